@@ -0,0 +1,84 @@
+#include "arena.h"
+
+// En-tête d'un bloc arrondi à l'alignement, ses données le suivent
+#define ARENA_HEADER	( ( sizeof( arenablock_t ) + ARENA_ALIGN - 1 ) & ~(size_t)( ARENA_ALIGN - 1 ) )
+
+static arenablock_t * ArenaBlock( arena_t * a, size_t size ) {
+	arenablock_t * b = (arenablock_t*)malloc( ARENA_HEADER + size );
+	if ( b == NULL ) {
+		printf( "(EE) Unable to allocate arena block of %zu bytes\n", size );
+		return NULL;
+	}
+	b->next = a->blocks;
+	b->size = size;
+	b->used = 0;
+	a->blocks = b;
+	a->mallocs++;
+	return b;
+}
+
+arena_t * Arena( size_t blocksize ) {
+	arena_t * a = (arena_t*)malloc( sizeof( arena_t ) );
+	if ( a == NULL ) {
+		printf( "(EE) Unable to allocate arena\n" );
+		return NULL;
+	}
+	a->blocks      = NULL;
+	a->blocksize   = ( blocksize > 0 ) ? blocksize : ARENA_BLOCK;
+	a->allocations = 0;
+	a->mallocs     = 0;
+	a->bytes       = 0;
+	return a;
+}
+
+void ArenaDelete( arena_t * a ) {
+	if ( a == NULL ) {
+		return;
+	}
+	arenablock_t * b = a->blocks;
+	while ( b != NULL ) {
+		arenablock_t * next = b->next;
+		free( b );
+		b = next;
+	}
+	free( a );
+}
+
+void * ArenaAlloc( arena_t * a, size_t size ) {
+	size = ( size + ARENA_ALIGN - 1 ) & ~(size_t)( ARENA_ALIGN - 1 );
+	arenablock_t * b = a->blocks;
+	// La fin du bloc courant est abandonnée si l'allocation n'y tient pas
+	if ( b == NULL || b->used + size > b->size ) {
+		b = ArenaBlock( a, ( size > a->blocksize ) ? size : a->blocksize );
+		if ( b == NULL ) {
+			return NULL;
+		}
+	}
+	void * p = (char*)b + ARENA_HEADER + b->used;
+	b->used += size;
+	a->allocations++;
+	a->bytes += size;
+	return p;
+}
+
+void ArenaReset( arena_t * a ) {
+	if ( a == NULL || a->blocks == NULL ) {
+		return;
+	}
+	if ( a->blocks->next != NULL ) {
+		size_t total = 0;
+		arenablock_t * b = a->blocks;
+		while ( b != NULL ) {
+			arenablock_t * next = b->next;
+			total += b->size;
+			free( b );
+			b = next;
+		}
+		a->blocks = NULL;
+		ArenaBlock( a, total );
+	}else {
+		a->blocks->used = 0;
+	}
+	a->allocations = 0;
+	a->bytes       = 0;
+}
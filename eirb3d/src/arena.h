@@ -0,0 +1,64 @@
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Taille par dfaut des blocs d'une arne, et alignement de chaque allocation
+ */
+#define ARENA_BLOCK		( 64 * 1024 )
+#define ARENA_ALIGN		16
+
+/**
+ * Dfinition des types
+ */
+
+/**
+ * Bloc d'une arne, suivi de ses size octets de donnes
+ */
+typedef struct arenablock {
+	struct arenablock	*	next;
+	size_t				size;
+	size_t				used;
+}arenablock_t;
+
+/**
+ * Arne : les allocations avancent dans le bloc courant et ne sont jamais libres une 
+ * une, mais toutes ensemble par ArenaReset ou ArenaDelete
+ */
+typedef struct arena {
+	arenablock_t		*	blocks;		// Bloc courant en tte
+	size_t				blocksize;
+	int				allocations;	// Allocations servies depuis la dernire remise  zro
+	int				mallocs;	// Blocs demands au systme depuis la cration
+	size_t				bytes;		// Octets servis depuis la dernire remise  zro
+}arena_t;
+
+/**
+ * Dfinition des prototypes de fonctions
+ */
+
+/**
+ * Construit une arne dont les blocs font au moins blocksize octets, NULL en cas d'chec
+ */
+arena_t			*	Arena			( size_t blocksize );
+
+/**
+ * Supprime une arne et tout ce qui y a t allou
+ */
+void				ArenaDelete		( arena_t * a );
+
+/**
+ * Alloue size octets aligns sur ARENA_ALIGN, non initialiss, NULL en cas d'chec
+ */
+void			*	ArenaAlloc		( arena_t * a, size_t size );
+
+/**
+ * Libre d'un coup tout ce qui a t allou. Si plusieurs blocs ont t ncessaires, ils
+ * sont remplacs par un seul bloc de leur taille totale : une arne remise  zro 
+ * chaque trame ne demande plus rien au systme une fois sa taille atteinte.
+ */
+void				ArenaReset		( arena_t * a );
+
+#endif //__ARENA_H__
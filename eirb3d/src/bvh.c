@@ -0,0 +1,435 @@
+#include <stdio.h>
+#include <string.h>
+#include "SDL2/SDL.h"
+#include "bvh.h"
+
+#define BVH_BINS		16
+#define BVH_LEAF_SIZE		4
+#define BVH_TRAVERSAL_COST	1.0f
+#define BVH_STACK_SIZE		128
+#define BVH_PARALLEL_COUNT	32768
+#define BVH_PARALLEL_DEPTH	3
+
+/**
+ * Noeud temporaire utilisé pendant la construction, avant la mise à plat
+ */
+typedef struct bvhbuildnode {
+	aabb_t			box;
+	int			left;
+	int			right;
+	int			start;
+	int			count;
+	int			axis;
+}bvhbuildnode_t;
+
+typedef struct bvhbuild {
+	bvhbuildnode_t	*	nodes;
+	SDL_atomic_t		nnodes;
+	const aabb_t	*	boxes;
+	vec3f_t		*	centroids;
+	int		*	prims;
+}bvhbuild_t;
+
+typedef struct bvhtask {
+	bvhbuild_t	*	build;
+	int			node;
+	int			depth;
+}bvhtask_t;
+
+static void BvhBuildNode( bvhbuild_t * b, int idx, int depth );
+
+static int BvhBuildThread( void * data ) {
+	bvhtask_t * task = (bvhtask_t*)data;
+	BvhBuildNode( task->build, task->node, task->depth );
+	return 0;
+}
+
+static int BvhAllocNode( bvhbuild_t * b, int start, int count ) {
+	int idx = SDL_AtomicAdd( &b->nnodes, 1 );
+	bvhbuildnode_t * n = &b->nodes[ idx ];
+	n->left  = -1;
+	n->right = -1;
+	n->start = start;
+	n->count = count;
+	n->axis  = 0;
+	n->box   = Aabb();
+	for ( int i = start; i < start + count; i++ ) {
+		AabbMerge( &n->box, b->boxes[ b->prims[ i ] ] );
+	}
+	return idx;
+}
+
+/**
+ * Cherche le meilleur plan de coupe par SAH sur des intervalles réguliers des centroïdes.
+ * Retourne le nombre de triangles placés à gauche, ou 0 si la feuille est préférable.
+ */
+static int BvhSplit( bvhbuild_t * b, bvhbuildnode_t * n ) {
+	aabb_t cb = Aabb();
+	for ( int i = n->start; i < n->start + n->count; i++ ) {
+		AabbExtend( &cb, b->centroids[ b->prims[ i ] ] );
+	}
+	vec3f_t extent = Vec3fSub( cb.max, cb.min );
+	int axis = ( extent.x > extent.y && extent.x > extent.z ) ? 0 : ( extent.y > extent.z ? 1 : 2 );
+	float lo = Vec3fAxis( cb.min, axis );
+	float size = Vec3fAxis( extent, axis );
+	n->axis = axis;
+
+	if ( size <= 0.0f ) {
+		// Centroïdes confondus : découpage au milieu si la feuille est trop grosse
+		return ( n->count > BVH_LEAF_SIZE ) ? n->count / 2 : 0;
+	}
+
+	int counts[ BVH_BINS ];
+	aabb_t boxes[ BVH_BINS ];
+	for ( int i = 0; i < BVH_BINS; i++ ) {
+		counts[ i ] = 0;
+		boxes[ i ] = Aabb();
+	}
+	float scale = BVH_BINS / size;
+	for ( int i = n->start; i < n->start + n->count; i++ ) {
+		int p = b->prims[ i ];
+		int bin = MIN( (int)( ( Vec3fAxis( b->centroids[ p ], axis ) - lo ) * scale ), BVH_BINS - 1 );
+		counts[ bin ]++;
+		AabbMerge( &boxes[ bin ], b->boxes[ p ] );
+	}
+
+	// Balayage de droite à gauche puis de gauche à droite pour évaluer chaque coupe
+	float rightcost[ BVH_BINS ];
+	aabb_t acc = Aabb();
+	int nacc = 0;
+	for ( int i = BVH_BINS - 1; i > 0; i-- ) {
+		AabbMerge( &acc, boxes[ i ] );
+		nacc += counts[ i ];
+		rightcost[ i ] = nacc * AabbHalfArea( acc );
+	}
+	float bestcost = HUGE_VALF;
+	int bestbin = -1;
+	acc = Aabb();
+	nacc = 0;
+	for ( int i = 0; i < BVH_BINS - 1; i++ ) {
+		AabbMerge( &acc, boxes[ i ] );
+		nacc += counts[ i ];
+		float cost = nacc * AabbHalfArea( acc ) + rightcost[ i + 1 ];
+		if ( nacc > 0 && nacc < n->count && cost < bestcost ) {
+			bestcost = cost;
+			bestbin = i;
+		}
+	}
+
+	// Coût d'une feuille comparé à celui d'une traversée supplémentaire, en nombre de tests rayon / triangle
+	float area = AabbHalfArea( n->box );
+	float leafcost = n->count * area;
+	if ( bestbin < 0 || ( n->count <= BVH_LEAF_SIZE && BVH_TRAVERSAL_COST * area + bestcost >= leafcost ) ) {
+		return ( n->count > BVH_LEAF_SIZE ) ? n->count / 2 : 0;
+	}
+
+	// Partition en place des triangles selon l'intervalle retenu
+	int i = n->start;
+	int j = n->start + n->count - 1;
+	while ( i <= j ) {
+		int bin = MIN( (int)( ( Vec3fAxis( b->centroids[ b->prims[ i ] ], axis ) - lo ) * scale ), BVH_BINS - 1 );
+		if ( bin <= bestbin ) {
+			i++;
+		}else {
+			swap( &b->prims[ i ], &b->prims[ j ] );
+			j--;
+		}
+	}
+	return i - n->start;
+}
+
+static void BvhBuildNode( bvhbuild_t * b, int idx, int depth ) {
+	bvhbuildnode_t * n = &b->nodes[ idx ];
+	if ( n->count <= 1 ) {
+		return;
+	}
+	int nleft = BvhSplit( b, n );
+	if ( nleft == 0 ) {
+		return;
+	}
+	n->left  = BvhAllocNode( b, n->start, nleft );
+	n->right = BvhAllocNode( b, n->start + nleft, n->count - nleft );
+
+	// Les gros sous-arbres du haut de la hiérarchie sont construits en parallèle
+	if ( n->count >= BVH_PARALLEL_COUNT && depth < BVH_PARALLEL_DEPTH ) {
+		bvhtask_t task = { b, n->left, depth + 1 };
+		SDL_Thread * thread = SDL_CreateThread( BvhBuildThread, "bvh", &task );
+		BvhBuildNode( b, n->right, depth + 1 );
+		if ( thread != NULL ) {
+			SDL_WaitThread( thread, NULL );
+		}else {
+			BvhBuildNode( b, n->left, depth + 1 );
+		}
+	}else {
+		BvhBuildNode( b, n->left, depth + 1 );
+		BvhBuildNode( b, n->right, depth + 1 );
+	}
+}
+
+/**
+ * Range les noeuds en profondeur d'abord et les triangles dans l'ordre des feuilles
+ */
+static void BvhFlatten( bvh_t * r, bvhbuild_t * b, const vec3f_t * corners, int idx, int * nprims, int depth ) {
+	bvhbuildnode_t * n = &b->nodes[ idx ];
+	int flat = r->nnodes++;
+	r->depth = MAX( r->depth, depth );
+	bvhnode_t * f = &r->nodes[ flat ];
+	f->box  = n->box;
+	f->axis = n->axis;
+	if ( n->left < 0 ) {
+		f->offset = *nprims;
+		f->count  = n->count;
+		for ( int i = n->start; i < n->start + n->count; i++ ) {
+			int p = b->prims[ i ];
+			r->prims[ *nprims ] = p;
+			if ( corners != NULL ) {
+				memcpy( &r->tris[ *nprims * 3 ], &corners[ p * 3 ], sizeof( vec3f_t ) * 3 );
+			}
+			( *nprims )++;
+		}
+	}else {
+		f->count = 0;
+		BvhFlatten( r, b, corners, n->left, nprims, depth + 1 );
+		r->nodes[ flat ].offset = r->nnodes;
+		BvhFlatten( r, b, corners, n->right, nprims, depth + 1 );
+	}
+}
+
+/**
+ * Construit la hiérarchie sur count boîtes englobantes. Si corners n'est pas NULL, les
+ * primitives sont des triangles dont les sommets sont recopiés dans l'ordre des feuilles.
+ */
+static bvh_t * BvhBoxes( const aabb_t * boxes, int count, const vec3f_t * corners ) {
+	bvhbuild_t b;
+	b.nodes     = (bvhbuildnode_t*)malloc( sizeof( bvhbuildnode_t ) * ( 2 * count - 1 ) );
+	b.boxes     = boxes;
+	b.centroids = (vec3f_t*)malloc( sizeof( vec3f_t ) * count );
+	b.prims     = (int*)malloc( sizeof( int ) * count );
+	SDL_AtomicSet( &b.nnodes, 0 );
+
+	bvh_t * r = (bvh_t*)malloc( sizeof( bvh_t ) );
+	if ( b.nodes == NULL || b.centroids == NULL || b.prims == NULL || r == NULL ) {
+		printf( "(EE) Unable to allocate bvh\n" );
+		free( b.nodes ); free( b.centroids ); free( b.prims ); free( r );
+		return NULL;
+	}
+
+	for ( int i = 0; i < count; i++ ) {
+		b.centroids[ i ] = Vec3fScale( Vec3fAdd( boxes[ i ].min, boxes[ i ].max ), 0.5f );
+		b.prims[ i ] = i;
+	}
+
+	int root = BvhAllocNode( &b, 0, count );
+	BvhBuildNode( &b, root, 0 );
+
+	r->nnodes = 0;
+	r->nprims = count;
+	r->depth  = 0;
+	r->nodes  = (bvhnode_t*)malloc( sizeof( bvhnode_t ) * SDL_AtomicGet( &b.nnodes ) );
+	r->prims  = (int*)malloc( sizeof( int ) * count );
+	r->tris   = ( corners != NULL ) ? (vec3f_t*)malloc( sizeof( vec3f_t ) * 3 * count ) : NULL;
+	if ( r->nodes == NULL || r->prims == NULL || ( corners != NULL && r->tris == NULL ) ) {
+		printf( "(EE) Unable to allocate bvh\n" );
+		free( b.nodes ); free( b.centroids ); free( b.prims );
+		BvhDelete( r );
+		return NULL;
+	}
+	int nprims = 0;
+	BvhFlatten( r, &b, corners, root, &nprims, 0 );
+
+	free( b.nodes );
+	free( b.centroids );
+	free( b.prims );
+	return r;
+}
+
+bvh_t * Bvh( const vec3f_t * corners, int ntris ) {
+	if ( ntris <= 0 ) {
+		return NULL;
+	}
+	aabb_t * boxes = (aabb_t*)malloc( sizeof( aabb_t ) * ntris );
+	if ( boxes == NULL ) {
+		printf( "(EE) Unable to allocate bvh\n" );
+		return NULL;
+	}
+	for ( int i = 0; i < ntris; i++ ) {
+		aabb_t box = Aabb();
+		AabbExtend( &box, corners[ i * 3 + 0 ] );
+		AabbExtend( &box, corners[ i * 3 + 1 ] );
+		AabbExtend( &box, corners[ i * 3 + 2 ] );
+		boxes[ i ] = box;
+	}
+	bvh_t * r = BvhBoxes( boxes, ntris, corners );
+	free( boxes );
+	return r;
+}
+
+bvh_t * BvhClusters( const clusters_t * c ) {
+	if ( c == NULL || c->count <= 0 ) {
+		return NULL;
+	}
+	aabb_t * boxes = (aabb_t*)malloc( sizeof( aabb_t ) * c->count );
+	if ( boxes == NULL ) {
+		printf( "(EE) Unable to allocate bvh\n" );
+		return NULL;
+	}
+	for ( int i = 0; i < c->count; i++ ) {
+		vec3f_t r = Vec3f( c->data[ i ].radius, c->data[ i ].radius, c->data[ i ].radius );
+		boxes[ i ].min = Vec3fSub( c->data[ i ].center, r );
+		boxes[ i ].max = Vec3fAdd( c->data[ i ].center, r );
+	}
+	bvh_t * r = BvhBoxes( boxes, c->count, NULL );
+	free( boxes );
+	return r;
+}
+
+void BvhDelete( bvh_t * b ) {
+	if ( b != NULL ) {
+		free( b->nodes );
+		free( b->prims );
+		free( b->tris );
+		free( b );
+	}
+}
+
+static bool BvhRayAabb( aabb_t box, vec3f_t o, vec3f_t inv, float tmax ) {
+	float t0 = 0.0f, t1 = tmax;
+	float lo, hi;
+	lo = ( box.min.x - o.x ) * inv.x; hi = ( box.max.x - o.x ) * inv.x;
+	t0 = MAX( t0, MIN( lo, hi ) ); t1 = MIN( t1, MAX( lo, hi ) );
+	lo = ( box.min.y - o.y ) * inv.y; hi = ( box.max.y - o.y ) * inv.y;
+	t0 = MAX( t0, MIN( lo, hi ) ); t1 = MIN( t1, MAX( lo, hi ) );
+	lo = ( box.min.z - o.z ) * inv.z; hi = ( box.max.z - o.z ) * inv.z;
+	t0 = MAX( t0, MIN( lo, hi ) ); t1 = MIN( t1, MAX( lo, hi ) );
+	return t0 <= t1;
+}
+
+/**
+ * Intersection rayon / triangle de Möller-Trumbore, sans élimination des faces arrières
+ */
+static bool BvhRayTriangle( ray_t r, const vec3f_t * tri, float * t ) {
+	vec3f_t e1 = Vec3fSub( tri[ 1 ], tri[ 0 ] );
+	vec3f_t e2 = Vec3fSub( tri[ 2 ], tri[ 0 ] );
+	vec3f_t p = Vec3fCross( r.d, e2 );
+	float det = Vec3fDot( e1, p );
+	if ( fabsf( det ) < 1e-12f ) {
+		return false;
+	}
+	float inv = 1.0f / det;
+	vec3f_t s = Vec3fSub( r.o, tri[ 0 ] );
+	float u = Vec3fDot( s, p ) * inv;
+	if ( u < 0.0f || u > 1.0f ) {
+		return false;
+	}
+	vec3f_t q = Vec3fCross( s, e1 );
+	float v = Vec3fDot( r.d, q ) * inv;
+	if ( v < 0.0f || u + v > 1.0f ) {
+		return false;
+	}
+	float d = Vec3fDot( e2, q ) * inv;
+	if ( d <= 0.0f || d >= *t ) {
+		return false;
+	}
+	*t = d;
+	return true;
+}
+
+int BvhPick( bvh_t * b, ray_t r, float * t ) {
+	if ( b == NULL ) {
+		return -1;
+	}
+	vec3f_t inv = Vec3f( 1.0f / r.d.x, 1.0f / r.d.y, 1.0f / r.d.z );
+	int neg[ 3 ] = { inv.x < 0.0f, inv.y < 0.0f, inv.z < 0.0f };
+	float tmax = HUGE_VALF;
+	int hit = -1;
+	// Un noeud interne empile au plus un enfant par niveau : au-delà de la pile, tous les
+	// triangles sont testés
+	if ( b->depth > BVH_STACK_SIZE ) {
+		for ( int i = 0; i < b->nprims; i++ ) {
+			if ( BvhRayTriangle( r, &b->tris[ i * 3 ], &tmax ) ) {
+				hit = i;
+			}
+		}
+	}
+	int stack[ BVH_STACK_SIZE ];
+	int top = 0;
+	int idx = 0;
+	while ( b->depth <= BVH_STACK_SIZE ) {
+		bvhnode_t * node = &b->nodes[ idx ];
+		if ( BvhRayAabb( node->box, r.o, inv, tmax ) ) {
+			if ( node->count > 0 ) {
+				for ( int i = node->offset; i < node->offset + node->count; i++ ) {
+					if ( BvhRayTriangle( r, &b->tris[ i * 3 ], &tmax ) ) {
+						hit = i;
+					}
+				}
+			}else {
+				// On visite d'abord l'enfant le plus proche selon le sens du rayon
+				if ( neg[ node->axis ] ) {
+					stack[ top++ ] = idx + 1;
+					idx = node->offset;
+				}else {
+					stack[ top++ ] = node->offset;
+					idx = idx + 1;
+				}
+				continue;
+			}
+		}
+		if ( top == 0 ) {
+			break;
+		}
+		idx = stack[ --top ];
+	}
+	if ( hit < 0 ) {
+		return -1;
+	}
+	if ( t != NULL ) {
+		*t = tmax;
+	}
+	return b->prims[ hit ];
+}
+
+int BvhCullClusters( bvh_t * b, clusters_t * c, const frustum_t * f, vec3f_t eye, int * out ) {
+	// Sans hiérarchie, ou trop profonde pour la pile, les groupes sont tous testés
+	if ( b == NULL || c == NULL || b->depth >= BVH_STACK_SIZE ) {
+		return ClustersCull( c, f, eye, out );
+	}
+	int stack[ BVH_STACK_SIZE ];
+	bool inside[ BVH_STACK_SIZE ];
+	int top = 0;
+	int n = 0;
+	stack[ top ] = 0;
+	inside[ top++ ] = false;
+	while ( top > 0 ) {
+		top--;
+		int idx = stack[ top ];
+		bvhnode_t * node = &b->nodes[ idx ];
+		bool in = inside[ top ];
+		if ( !in ) {
+			int test = FrustumTestAabb( f, node->box );
+			if ( test < 0 ) {
+				continue;
+			}
+			// Un noeud entièrement visible n'a plus besoin d'être testé, ni ses enfants
+			in = ( test > 0 );
+		}
+		if ( node->count > 0 ) {
+			for ( int i = node->offset; i < node->offset + node->count; i++ ) {
+				cluster_t * cl = &c->data[ b->prims[ i ] ];
+				if ( !in && FrustumTestSphere( f, cl->center, cl->radius ) < 0 ) {
+					continue;
+				}
+				if ( !ClusterBackfacing( cl, eye ) ) {
+					out[ n++ ] = b->prims[ i ];
+				}
+			}
+		}else {
+			// L'enfant gauche, dépilé en premier, garde l'ordre des feuilles
+			stack[ top ] = node->offset;
+			inside[ top++ ] = in;
+			stack[ top ] = idx + 1;
+			inside[ top++ ] = in;
+		}
+	}
+	return n;
+}
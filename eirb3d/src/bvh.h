@@ -0,0 +1,66 @@
+#ifndef __BVH_H__
+#define __BVH_H__
+
+#include <stdbool.h>
+#include "geometry.h"
+#include "cluster.h"
+
+/**
+ * Dfinition des types
+ */
+
+/**
+ * Noeud de la hirarchie, rang en profondeur d'abord : l'enfant gauche d'un
+ * noeud interne suit directement son parent, offset dsigne l'enfant droit.
+ * Pour une feuille, offset dsigne le premier triangle et count leur nombre.
+ */
+typedef struct bvhnode {
+	aabb_t			box;
+	int			offset;
+	short			count;
+	short			axis;
+}bvhnode_t;
+
+typedef struct bvh {
+	bvhnode_t	*	nodes;
+	int			nnodes;
+	int		*	prims;
+	vec3f_t		*	tris;		// Sommets des triangles dans l'ordre des feuilles, NULL pour des groupes
+	int			nprims;
+	int			depth;		// Profondeur de la feuille la plus basse
+}bvh_t;
+
+/**
+ * Dfinition des prototypes de fonctions
+ */
+
+/**
+ * Construit une hirarchie de volumes englobants (SAH par intervalles) sur
+ * ntris triangles donns par leurs trois sommets conscutifs
+ */
+bvh_t			*	Bvh			( const vec3f_t * corners, int ntris );
+
+/**
+ * Construit une hirarchie sur les sphres englobantes des groupes de triangles,
+ * ses feuilles dsignent des index de groupes
+ */
+bvh_t			*	BvhClusters		( const clusters_t * c );
+
+/**
+ * Supprime une hirarchie de volumes englobants
+ */
+void				BvhDelete		( bvh_t * b );
+
+/**
+ * Retourne l'index du triangle le plus proche touch par le rayon, ou -1
+ */
+int				BvhPick			( bvh_t * b, ray_t r, float * t );
+
+/**
+ * Ecrit dans out les index des groupes visibles depuis eye dans le frustum et retourne
+ * leur nombre, comme ClustersCull : les sous-arbres hors champ sont carts en bloc, ceux
+ * entirement dans le champ ne sont plus tests. Le test du cne reste fait par groupe.
+ */
+int				BvhCullClusters		( bvh_t * b, clusters_t * c, const frustum_t * f, vec3f_t eye, int * out );
+
+#endif //__BVH_H__
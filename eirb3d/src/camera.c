@@ -0,0 +1,62 @@
+#include "camera.h"
+
+camera_t Camera( vec3f_t eye, vec3f_t center, vec3f_t up, float fovy, float aspect ) {
+	camera_t c;
+	c.eye		= eye;
+	c.center	= center;
+	c.up		= up;
+	c.fovy		= fovy;
+	c.aspect	= aspect;
+	c.znear		= 0.1f;
+	c.zfar		= 100.0f;
+	return c;
+}
+
+matrixf_t CameraView( camera_t * c ) {
+	return MatrixfLookAt( c->eye, c->center, c->up );
+}
+
+matrixf_t CameraProjection( camera_t * c ) {
+	return MatrixfPerspective( c->fovy, c->aspect, c->znear, c->zfar );
+}
+
+matrixf_t CameraScreen( camera_t * c, int width, int height ) {
+	matrixf_t view = CameraView( c );
+	matrixf_t proj = CameraProjection( c );
+	matrixf_t viewport = MatrixfViewport( 0, 0, width, height );
+	matrixf_t pv = MatrixfMult( proj, view, 4, 4 );
+	matrixf_t m = MatrixfMult( viewport, pv, 4, 4 );
+	MatrixfDelete( view, 4 );
+	MatrixfDelete( proj, 4 );
+	MatrixfDelete( viewport, 4 );
+	MatrixfDelete( pv, 4 );
+	return m;
+}
+
+frustum_t CameraFrustum( camera_t * c ) {
+	matrixf_t view = CameraView( c );
+	matrixf_t proj = CameraProjection( c );
+	matrixf_t pv = MatrixfMult( proj, view, 4, 4 );
+	frustum_t f = MatrixfFrustum( pv );
+	MatrixfDelete( view, 4 );
+	MatrixfDelete( proj, 4 );
+	MatrixfDelete( pv, 4 );
+	return f;
+}
+
+ray_t CameraRay( camera_t * c, int x, int y, int width, int height ) {
+	// Coordonnées normalisées du centre du pixel, y vers le haut
+	float nx = 2.0f * ( x + 0.5f ) / width - 1.0f;
+	float ny = 1.0f - 2.0f * ( y + 0.5f ) / height;
+	float t = tanf( c->fovy / 2.0f );
+
+	vec3f_t forward = Vec3fNormalize( Vec3fSub( c->center, c->eye ) );
+	vec3f_t right = Vec3fNormalize( Vec3fCross( forward, c->up ) );
+	vec3f_t up = Vec3fCross( right, forward );
+
+	ray_t r;
+	r.o = c->eye;
+	r.d = Vec3fAdd( forward, Vec3fAdd( Vec3fScale( right, nx * t * c->aspect ), Vec3fScale( up, ny * t ) ) );
+	r.d = Vec3fNormalize( r.d );
+	return r;
+}
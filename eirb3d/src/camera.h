@@ -0,0 +1,53 @@
+#ifndef __CAMERA_H__
+#define __CAMERA_H__
+
+#include "geometry.h"
+
+/**
+ * Dfinition des types
+ */
+typedef struct camera {
+	vec3f_t			eye;
+	vec3f_t			center;
+	vec3f_t			up;
+	float			fovy;
+	float			aspect;
+	float			znear;
+	float			zfar;
+}camera_t;
+
+/**
+ * Dfinition des prototypes de fonctions
+ */
+
+/**
+ * Construit une camra perspective (fovy en radians)
+ */
+camera_t		Camera			( vec3f_t eye, vec3f_t center, vec3f_t up, float fovy, float aspect );
+
+/**
+ * Construit la matrice de vue de la camra
+ */
+matrixf_t		CameraView		( camera_t * c );
+
+/**
+ * Construit la matrice de projection de la camra
+ */
+matrixf_t		CameraProjection	( camera_t * c );
+
+/**
+ * Construit la matrice complte monde vers pixels (viewport * projection * vue)
+ */
+matrixf_t		CameraScreen		( camera_t * c, int width, int height );
+
+/**
+ * Retourne le frustum de la camra dans le repre du modle
+ */
+frustum_t		CameraFrustum		( camera_t * c );
+
+/**
+ * Construit le rayon partant de l'oeil et passant par le pixel (x, y)
+ */
+ray_t			CameraRay		( camera_t * c, int x, int y, int width, int height );
+
+#endif //__CAMERA_H__
@@ -0,0 +1,200 @@
+#include <stdio.h>
+#include <string.h>
+#include "cluster.h"
+#include "bvh.h"
+
+#define CLUSTER_SIZE		128
+
+static int ClustersCompare( const void * a, const void * b ) {
+	return *(const int*)a - *(const int*)b;
+}
+
+/**
+ * Calcule la sphère englobante et le cône des normales d'un groupe de triangles
+ */
+static void ClusterBounds( cluster_t * c, const vec3f_t * corners, const int * faces ) {
+	aabb_t box = Aabb();
+	vec3f_t sum = Vec3f( 0.0f, 0.0f, 0.0f );
+	for ( int i = c->offset; i < c->offset + c->count; i++ ) {
+		const vec3f_t * t = &corners[ faces[ i ] * 3 ];
+		AabbExtend( &box, t[ 0 ] );
+		AabbExtend( &box, t[ 1 ] );
+		AabbExtend( &box, t[ 2 ] );
+		vec3f_t n = Vec3fCross( Vec3fSub( t[ 1 ], t[ 0 ] ), Vec3fSub( t[ 2 ], t[ 0 ] ) );
+		float l = Vec3fLength( n );
+		if ( l > 0.0f ) {
+			sum = Vec3fAdd( sum, Vec3fScale( n, 1.0f / l ) );
+		}
+	}
+
+	c->center = Vec3fScale( Vec3fAdd( box.min, box.max ), 0.5f );
+	c->radius = 0.0f;
+	for ( int i = c->offset; i < c->offset + c->count; i++ ) {
+		const vec3f_t * t = &corners[ faces[ i ] * 3 ];
+		for ( int j = 0; j < 3; j++ ) {
+			c->radius = MAX( c->radius, Vec3fLength( Vec3fSub( t[ j ], c->center ) ) );
+		}
+	}
+
+	// Un cône d'ouverture supérieure à 90° ne permet aucun rejet : cutoff = 1
+	c->axis = Vec3f( 0.0f, 0.0f, 1.0f );
+	c->cutoff = 1.0f;
+	float l = Vec3fLength( sum );
+	if ( l <= 0.0f ) {
+		return;
+	}
+	c->axis = Vec3fScale( sum, 1.0f / l );
+	float mindot = 1.0f;
+	for ( int i = c->offset; i < c->offset + c->count; i++ ) {
+		const vec3f_t * t = &corners[ faces[ i ] * 3 ];
+		vec3f_t n = Vec3fCross( Vec3fSub( t[ 1 ], t[ 0 ] ), Vec3fSub( t[ 2 ], t[ 0 ] ) );
+		float nl = Vec3fLength( n );
+		if ( nl > 0.0f ) {
+			mindot = MIN( mindot, Vec3fDot( c->axis, n ) / nl );
+		}
+	}
+	if ( mindot > 0.0f ) {
+		c->cutoff = sqrtf( 1.0f - mindot * mindot );
+	}
+}
+
+/**
+ * Sélection rapide : range les triangles de [lo, hi) de sorte que celui d'index k
+ * soit à sa place selon l'axe donné, les plus petits avant, les plus grands après
+ */
+static void ClustersSelect( int * faces, const vec3f_t * centroids, int lo, int hi, int k, int axis ) {
+	while ( hi - lo > 1 ) {
+		float pivot = Vec3fAxis( centroids[ faces[ ( lo + hi ) / 2 ] ], axis );
+		int i = lo, j = hi - 1;
+		while ( i <= j ) {
+			while ( Vec3fAxis( centroids[ faces[ i ] ], axis ) < pivot ) i++;
+			while ( Vec3fAxis( centroids[ faces[ j ] ], axis ) > pivot ) j--;
+			if ( i <= j ) {
+				swap( &faces[ i ], &faces[ j ] );
+				i++;
+				j--;
+			}
+		}
+		if ( k <= j ) {
+			hi = j + 1;
+		}else if ( k >= i ) {
+			lo = i;
+		}else {
+			return;
+		}
+	}
+}
+
+/**
+ * Coupe récursivement [lo, hi) en deux à la médiane de l'axe le plus étendu
+ * jusqu'à obtenir des groupes d'au plus CLUSTER_SIZE triangles
+ */
+static void ClustersSplit( clusters_t * c, const vec3f_t * centroids, int lo, int hi ) {
+	if ( hi - lo <= CLUSTER_SIZE ) {
+		cluster_t * cl = &c->data[ c->count++ ];
+		cl->offset = lo;
+		cl->count  = hi - lo;
+		return;
+	}
+	aabb_t cb = Aabb();
+	for ( int i = lo; i < hi; i++ ) {
+		AabbExtend( &cb, centroids[ c->faces[ i ] ] );
+	}
+	vec3f_t e = Vec3fSub( cb.max, cb.min );
+	int axis = ( e.x > e.y && e.x > e.z ) ? 0 : ( e.y > e.z ? 1 : 2 );
+	int mid = ( lo + hi ) / 2;
+	ClustersSelect( c->faces, centroids, lo, hi, mid, axis );
+	ClustersSplit( c, centroids, lo, mid );
+	ClustersSplit( c, centroids, mid, hi );
+}
+
+clusters_t * Clusters( const vec3f_t * corners, int ntris ) {
+	if ( ntris <= 0 ) {
+		return NULL;
+	}
+	clusters_t * c = (clusters_t*)malloc( sizeof( clusters_t ) );
+	vec3f_t * centroids = (vec3f_t*)malloc( sizeof( vec3f_t ) * ntris );
+	int * buckets = (int*)malloc( sizeof( int ) * ntris );
+	cluster_t * data = (cluster_t*)malloc( sizeof( cluster_t ) * ntris );
+	int * faces = (int*)malloc( sizeof( int ) * ntris );
+	if ( c == NULL || centroids == NULL || buckets == NULL || data == NULL || faces == NULL ) {
+		printf( "(EE) Unable to allocate clusters\n" );
+		free( c ); free( centroids ); free( buckets ); free( data ); free( faces );
+		return NULL;
+	}
+	c->data   = data;
+	c->faces  = faces;
+	c->count  = 0;
+	c->nfaces = ntris;
+	c->bvh    = NULL;
+
+	// Répartition des triangles selon la direction dominante de leur normale
+	// (six demi-axes) pour que chaque groupe ait un cône de normales étroit
+	int start[ 7 ] = { 0 };
+	for ( int i = 0; i < ntris; i++ ) {
+		const vec3f_t * t = &corners[ i * 3 ];
+		vec3f_t n = Vec3fCross( Vec3fSub( t[ 1 ], t[ 0 ] ), Vec3fSub( t[ 2 ], t[ 0 ] ) );
+		vec3f_t a = Vec3f( fabsf( n.x ), fabsf( n.y ), fabsf( n.z ) );
+		int axis = ( a.x > a.y && a.x > a.z ) ? 0 : ( a.y > a.z ? 1 : 2 );
+		buckets[ i ] = axis * 2 + ( Vec3fAxis( n, axis ) < 0.0f ? 1 : 0 );
+		centroids[ i ] = Vec3fScale( Vec3fAdd( t[ 0 ], Vec3fAdd( t[ 1 ], t[ 2 ] ) ), 1.0f / 3.0f );
+		start[ buckets[ i ] + 1 ]++;
+	}
+	for ( int i = 0; i < 6; i++ ) {
+		start[ i + 1 ] += start[ i ];
+	}
+	int fill[ 6 ];
+	memcpy( fill, start, sizeof( fill ) );
+	for ( int i = 0; i < ntris; i++ ) {
+		c->faces[ fill[ buckets[ i ] ]++ ] = i;
+	}
+
+	for ( int i = 0; i < 6; i++ ) {
+		if ( start[ i + 1 ] > start[ i ] ) {
+			ClustersSplit( c, centroids, start[ i ], start[ i + 1 ] );
+		}
+	}
+	// Ne fait que réduire le bloc : en cas d'échec, l'ancien reste valide
+	data = (cluster_t*)realloc( c->data, sizeof( cluster_t ) * c->count );
+	if ( data != NULL ) {
+		c->data = data;
+	}
+
+	for ( int i = 0; i < c->count; i++ ) {
+		// Les faces d'un groupe gardent l'ordre du maillage, optimisé pour le cache de sommets
+		qsort( &c->faces[ c->data[ i ].offset ], c->data[ i ].count, sizeof( int ), ClustersCompare );
+		ClusterBounds( &c->data[ i ], corners, c->faces );
+	}
+	c->bvh = BvhClusters( c );
+
+	free( centroids );
+	free( buckets );
+	return c;
+}
+
+void ClustersDelete( clusters_t * c ) {
+	if ( c != NULL ) {
+		BvhDelete( c->bvh );
+		free( c->data );
+		free( c->faces );
+		free( c );
+	}
+}
+
+int ClustersCull( clusters_t * c, const frustum_t * f, vec3f_t eye, int * out ) {
+	if ( c == NULL ) {
+		return 0;
+	}
+	int n = 0;
+	for ( int i = 0; i < c->count; i++ ) {
+		cluster_t * cl = &c->data[ i ];
+		if ( FrustumTestSphere( f, cl->center, cl->radius ) < 0 ) {
+			continue;
+		}
+		if ( ClusterBackfacing( cl, eye ) ) {
+			continue;
+		}
+		out[ n++ ] = i;
+	}
+	return n;
+}
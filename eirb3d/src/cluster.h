@@ -0,0 +1,66 @@
+#ifndef __CLUSTER_H__
+#define __CLUSTER_H__
+
+#include <stdbool.h>
+#include "geometry.h"
+
+/**
+ * Dfinition des types
+ */
+
+/**
+ * Groupe de triangles voisins avec sa sphre englobante et le cne de ses normales.
+ * Ses faces sont faces[ offset ]  faces[ offset + count - 1 ].
+ * Le groupe est entirement de dos si dot( center - eye, axis ) >= cutoff * | center - eye | + radius.
+ */
+typedef struct cluster {
+	vec3f_t			center;
+	float			radius;
+	vec3f_t			axis;
+	float			cutoff;
+	int			offset;
+	int			count;
+}cluster_t;
+
+// Hirarchie de volumes englobants, dfinie dans bvh.h
+struct bvh;
+
+typedef struct clusters {
+	cluster_t	*	data;
+	int			count;
+	int		*	faces;
+	int			nfaces;
+	struct bvh	*	bvh;		// Hirarchie sur les sphres des groupes, NULL si elle n'a pu tre construite
+}clusters_t;
+
+/**
+ * Dfinition des prototypes de fonctions
+ */
+
+/**
+ * Dcoupe ntris triangles, donns par leurs trois sommets conscutifs, en groupes
+ * d'au plus 128 triangles voisins et d'orientations proches
+ */
+clusters_t		*	Clusters		( const vec3f_t * corners, int ntris );
+
+/**
+ * Supprime un dcoupage en groupes de triangles
+ */
+void				ClustersDelete		( clusters_t * c );
+
+/**
+ * Ecrit dans out les index des groupes visibles depuis eye dans le frustum
+ * (ni hors champ, ni entirement de dos) et retourne leur nombre.
+ * Parcourt tous les groupes : BvhCullClusters passe par leur hirarchie.
+ */
+int				ClustersCull		( clusters_t * c, const frustum_t * f, vec3f_t eye, int * out );
+
+/**
+ * Retourne vrai si toutes les faces du groupe tournent le dos  eye (test du cne des normales)
+ */
+inline bool ClusterBackfacing( const cluster_t * cl, vec3f_t eye ) {
+	vec3f_t v = Vec3fSub( cl->center, eye );
+	return Vec3fDot( v, cl->axis ) >= cl->cutoff * Vec3fLength( v ) + cl->radius;
+}
+
+#endif //__CLUSTER_H__
@@ -0,0 +1,158 @@
+#include "controller.h"
+#include <string.h>
+
+// Elévation maximale, en deçà de la verticale où le vecteur haut devient dégénéré
+#define CONTROLLER_PITCH	1.5f
+
+// Pas simulés au plus pour rattraper une longue trame, le reste du retard est abandonné
+#define CONTROLLER_CATCHUP	25
+
+/**
+ * Direction du centre vers l'oeil
+ */
+static vec3f_t ControllerDirection( const camerapose_t * p ) {
+	return Vec3f( cosf( p->pitch ) * sinf( p->yaw ), sinf( p->pitch ), cosf( p->pitch ) * cosf( p->yaw ) );
+}
+
+static vec3f_t ControllerEye( const camerapose_t * p ) {
+	return Vec3fAdd( p->center, Vec3fScale( ControllerDirection( p ), p->distance ) );
+}
+
+/**
+ * Tourne une position : autour du centre en orbite, autour de l'oeil en vol
+ */
+static void ControllerTurn( camerapose_t * p, int mode, float yaw, float pitch ) {
+	vec3f_t eye = ControllerEye( p );
+	p->yaw += yaw;
+	p->pitch = MIN( MAX( p->pitch + pitch, -CONTROLLER_PITCH ), CONTROLLER_PITCH );
+	if ( mode == CONTROLLER_FLY ) {
+		p->center = Vec3fSub( eye, Vec3fScale( ControllerDirection( p ), p->distance ) );
+	}
+}
+
+/**
+ * Déplace oeil et centre ensemble, dans le repère de la vue (droite, haut, avant)
+ */
+static void ControllerTranslate( camerapose_t * p, float right, float up, float forward ) {
+	vec3f_t f = Vec3fScale( ControllerDirection( p ), -1.0f );
+	vec3f_t r = Vec3fNormalize( Vec3fCross( f, Vec3f( 0.0f, 1.0f, 0.0f ) ) );
+	vec3f_t u = Vec3fCross( r, f );
+	p->center = Vec3fAdd( p->center, Vec3fAdd( Vec3fScale( r, right ), Vec3fAdd( Vec3fScale( u, up ), Vec3fScale( f, forward ) ) ) );
+}
+
+/**
+ * Retient l'horodatage du premier évènement depuis la dernière trame, pour la mesure de latence
+ */
+static void ControllerMark( controller_t * k, Uint32 timestamp ) {
+	if ( k->input == 0 ) {
+		k->input = MAX( timestamp, 1u );
+	}
+}
+
+/**
+ * Un pas de simulation de dt secondes : directions maintenues et lissage de la molette
+ */
+static void ControllerStep( controller_t * k, float dt ) {
+	camerapose_t * p = &k->current;
+	float x = (float)( ( ( k->held & CONTROLLER_RIGHT ) != 0 ) - ( ( k->held & CONTROLLER_LEFT ) != 0 ) );
+	float y = (float)( ( ( k->held & CONTROLLER_UP ) != 0 ) - ( ( k->held & CONTROLLER_DOWN ) != 0 ) );
+	float z = (float)( ( ( k->held & CONTROLLER_FORWARD ) != 0 ) - ( ( k->held & CONTROLLER_BACK ) != 0 ) );
+	if ( k->mode == CONTROLLER_FLY ) {
+		ControllerTranslate( p, x * k->speed * dt, y * k->speed * dt, z * k->speed * dt );
+		return;
+	}
+	// En orbite, les flèches tournent autour du centre et page haut / bas rapprochent l'oeil
+	ControllerTurn( p, k->mode, -x * CONTROLLER_TURN * dt, z * CONTROLLER_TURN * dt );
+	k->goal *= expf( -y * dt );
+	p->distance += ( k->goal - p->distance ) * ( 1.0f - expf( -CONTROLLER_SMOOTH * dt ) );
+}
+
+controller_t Controller( camera_t * c ) {
+	controller_t k;
+	vec3f_t d = Vec3fSub( c->eye, c->center );
+	k.mode			= CONTROLLER_ORBIT;
+	k.current.center	= c->center;
+	k.current.distance	= Vec3fLength( d );
+	k.current.yaw		= atan2f( d.x, d.z );
+	k.current.pitch		= asinf( d.y / k.current.distance );
+	k.previous		= k.current;
+	k.goal			= k.current.distance;
+	k.speed			= k.current.distance;
+	k.held			= 0;
+	k.time			= SDL_GetPerformanceCounter();
+	k.input			= 0;
+	k.lens			= *c;
+	return k;
+}
+
+void ControllerToggleMode( controller_t * k ) {
+	k->mode = ( k->mode == CONTROLLER_ORBIT ) ? CONTROLLER_FLY : CONTROLLER_ORBIT;
+	k->goal = k->current.distance;
+}
+
+void ControllerRotate( controller_t * k, int dx, int dy, Uint32 timestamp ) {
+	// Les deux derniers pas sont tournés : l'interpolation ne retarde pas le glissement
+	ControllerTurn( &k->previous, k->mode, -dx * CONTROLLER_DRAG, dy * CONTROLLER_DRAG );
+	ControllerTurn( &k->current, k->mode, -dx * CONTROLLER_DRAG, dy * CONTROLLER_DRAG );
+	ControllerMark( k, timestamp );
+}
+
+void ControllerPan( controller_t * k, int dx, int dy, Uint32 timestamp ) {
+	float scale = k->current.distance * CONTROLLER_DRAG;
+	ControllerTranslate( &k->previous, -dx * scale, dy * scale, 0.0f );
+	ControllerTranslate( &k->current, -dx * scale, dy * scale, 0.0f );
+	ControllerMark( k, timestamp );
+}
+
+void ControllerZoom( controller_t * k, int notches, Uint32 timestamp ) {
+	if ( k->mode == CONTROLLER_FLY ) {
+		float step = notches * ( 1.0f - CONTROLLER_ZOOM ) * k->speed;
+		ControllerTranslate( &k->previous, 0.0f, 0.0f, step );
+		ControllerTranslate( &k->current, 0.0f, 0.0f, step );
+	}else {
+		k->goal *= powf( CONTROLLER_ZOOM, (float)notches );
+	}
+	ControllerMark( k, timestamp );
+}
+
+void ControllerHold( controller_t * k, int direction, bool held, Uint32 timestamp ) {
+	k->held = held ? ( k->held | direction ) : ( k->held & ~direction );
+	ControllerMark( k, timestamp );
+}
+
+bool ControllerMoving( controller_t * k ) {
+	return k->held != 0 || fabsf( k->goal - k->current.distance ) > 1e-4f * k->goal
+		|| memcmp( &k->previous, &k->current, sizeof( camerapose_t ) ) != 0;
+}
+
+camera_t ControllerCamera( controller_t * k ) {
+	Uint64 tick = SDL_GetPerformanceFrequency() / CONTROLLER_RATE;
+	Uint64 now = SDL_GetPerformanceCounter();
+	if ( now - k->time > CONTROLLER_CATCHUP * tick ) {
+		k->time = now - CONTROLLER_CATCHUP * tick;
+	}
+	while ( now - k->time >= tick ) {
+		k->previous = k->current;
+		ControllerStep( k, 1.0f / CONTROLLER_RATE );
+		k->time += tick;
+	}
+
+	// Position à l'instant présent, entre les deux derniers pas
+	float t = (float)( now - k->time ) / tick;
+	camerapose_t p;
+	p.center	= Vec3fAdd( k->previous.center, Vec3fScale( Vec3fSub( k->current.center, k->previous.center ), t ) );
+	p.yaw		= k->previous.yaw + ( k->current.yaw - k->previous.yaw ) * t;
+	p.pitch		= k->previous.pitch + ( k->current.pitch - k->previous.pitch ) * t;
+	p.distance	= k->previous.distance + ( k->current.distance - k->previous.distance ) * t;
+
+	camera_t c = Camera( ControllerEye( &p ), p.center, k->lens.up, k->lens.fovy, k->lens.aspect );
+	c.znear = k->lens.znear;
+	c.zfar  = k->lens.zfar;
+	return c;
+}
+
+Uint32 ControllerTakeInput( controller_t * k ) {
+	Uint32 input = k->input;
+	k->input = 0;
+	return input;
+}
@@ -0,0 +1,119 @@
+#ifndef __CONTROLLER_H__
+#define __CONTROLLER_H__
+
+#include <stdbool.h>
+#include "SDL2/SDL.h"
+#include "camera.h"
+
+/**
+ * Dfinition des modes de la camra
+ */
+#define CONTROLLER_ORBIT	0	// Tourne autour du centre, la molette rapproche l'oeil
+#define CONTROLLER_FLY		1	// Tourne sur place, les flches dplacent l'oeil
+
+/**
+ * Directions maintenues par les touches (flches, page haut et page bas)
+ */
+#define CONTROLLER_FORWARD	1
+#define CONTROLLER_BACK		2
+#define CONTROLLER_LEFT		4
+#define CONTROLLER_RIGHT	8
+#define CONTROLLER_UP		16
+#define CONTROLLER_DOWN		32
+
+/**
+ * Pas de simulation par seconde des mouvements continus (touches maintenues, molette),
+ * indpendant de la cadence du rendu
+ */
+#define CONTROLLER_RATE		250
+
+/**
+ * Sensibilits : radians par pixel de glissement, radians par seconde au clavier,
+ * facteur de distance par cran de molette, et constante de lissage de la molette (par seconde)
+ */
+#define CONTROLLER_DRAG		0.005f
+#define CONTROLLER_TURN		1.5f
+#define CONTROLLER_ZOOM		0.85f
+#define CONTROLLER_SMOOTH	15.0f
+
+/**
+ * Dfinition des types
+ */
+
+/**
+ * Position de la camra : l'oeil est  distance du centre, dans la direction donne par
+ * les angles yaw (autour de y) et pitch (lvation)
+ */
+typedef struct camerapose {
+	vec3f_t			center;
+	float			yaw;
+	float			pitch;
+	float			distance;
+}camerapose_t;
+
+typedef struct controller {
+	int			mode;
+	camerapose_t		previous;	// Avant-dernier pas de simulation
+	camerapose_t		current;	// Dernier pas de simulation
+	float			goal;		// Distance vise par la molette, atteinte progressivement
+	float			speed;		// Dplacement au clavier, en units de la scne par seconde
+	int			held;		// Directions maintenues
+	Uint64			time;		// Instant du dernier pas (SDL_GetPerformanceCounter)
+	Uint32			input;		// Horodatage (SDL_GetTicks) du plus ancien vnement pas encore dessin, 0 sinon
+	camera_t		lens;		// Vecteur haut et projection de la camra d'origine
+}controller_t;
+
+/**
+ * Dfinition des prototypes de fonctions
+ */
+
+/**
+ * Contrleur en orbite reprenant la position et la projection d'une camra
+ */
+controller_t			Controller		( camera_t * c );
+
+/**
+ * Bascule entre orbite et vol libre, sans dplacer la camra
+ */
+void				ControllerToggleMode	( controller_t * k );
+
+/**
+ * Glissement de la souris de (dx, dy) pixels : rotation autour du centre (orbite) ou
+ * de l'oeil (vol). Applique aussitt, sans attendre le pas de simulation suivant.
+ */
+void				ControllerRotate	( controller_t * k, int dx, int dy, Uint32 timestamp );
+
+/**
+ * Glissement de (dx, dy) pixels dplaant oeil et centre dans le plan de l'cran
+ */
+void				ControllerPan		( controller_t * k, int dx, int dy, Uint32 timestamp );
+
+/**
+ * Crans de molette : rapproche (positif) ou loigne l'oeil du centre en orbite, avance
+ * ou recule en vol
+ */
+void				ControllerZoom		( controller_t * k, int notches, Uint32 timestamp );
+
+/**
+ * Appui (held vrai) ou relchement d'une direction
+ */
+void				ControllerHold		( controller_t * k, int direction, bool held, Uint32 timestamp );
+
+/**
+ * Vrai tant qu'un mouvement continu est en cours : la boucle doit continuer  dessiner
+ */
+bool				ControllerMoving	( controller_t * k );
+
+/**
+ * Avance la simulation jusqu' l'instant prsent et retourne la camra interpole
+ * entre ses deux derniers pas
+ */
+camera_t			ControllerCamera	( controller_t * k );
+
+/**
+ * Retourne l'horodatage du plus ancien vnement pris en compte depuis l'appel prcdent,
+ * 0 s'il n'y en a pas, et l'oublie :  appeler quand une trame est dessine
+ */
+Uint32				ControllerTakeInput	( controller_t * k );
+
+#endif //__CONTROLLER_H__
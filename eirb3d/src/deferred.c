@@ -0,0 +1,223 @@
+#include "deferred.h"
+#include "jobs.h"
+
+/**
+ * Emprise d'une lumière ponctuelle à l'écran : rectangle de pixels et intervalle de profondeur
+ */
+typedef struct deferredbounds {
+	int			minx, miny, maxx, maxy;
+	float			minz, maxz;
+}deferredbounds_t;
+
+typedef struct deferredpass {
+	window_t		*	w;
+	gbuffer_t		*	g;
+	const light_t		*	l;
+	const shadowmap_t	*	shadow;
+	const pointlight_t	*	points;
+	deferredbounds_t	*	bounds;
+	int				npoints;
+	bool				cull;
+	matrixf_t			inverse;
+	vec3f_t				eye;
+	int				tilesx;
+	SDL_atomic_t			ntiles;
+	SDL_atomic_t			nlights;
+}deferredpass_t;
+
+static deferredbounds_t *	g_bounds	= NULL;
+static int			g_nbounds	= 0;
+static float			g_lightspertile	= 0.0f;
+
+/**
+ * Projette les huit coins de la boîte englobant la sphère d'influence
+ */
+static deferredbounds_t DeferredLightBounds( window_t * w, matrixf_t screen, const pointlight_t * p ) {
+	deferredbounds_t b;
+	float minx = HUGE_VALF, miny = HUGE_VALF, maxx = -HUGE_VALF, maxy = -HUGE_VALF;
+	b.minz = HUGE_VALF;
+	b.maxz = -HUGE_VALF;
+	bool behind = false;
+	for ( int i = 0; i < 8; i++ ) {
+		vec3f_t corner = Vec3f( p->position.x + ( ( i & 1 ) ? p->radius : -p->radius ),
+					p->position.y + ( ( i & 2 ) ? p->radius : -p->radius ),
+					p->position.z + ( ( i & 4 ) ? p->radius : -p->radius ) );
+		vec4f_t h = MatrixfTransform( screen, corner );
+		if ( h.z < 0.0f || h.w <= 0.0f ) {
+			behind = true;
+			continue;
+		}
+		float inv = 1.0f / h.w;
+		minx = MIN( minx, h.x * inv ); maxx = MAX( maxx, h.x * inv );
+		miny = MIN( miny, h.y * inv ); maxy = MAX( maxy, h.y * inv );
+		b.minz = MIN( b.minz, h.z * inv ); b.maxz = MAX( b.maxz, h.z * inv );
+	}
+	// Une boîte qui traverse le plan proche peut couvrir tout l'écran
+	if ( behind ) {
+		minx = miny = 0.0f;
+		maxx = (float)w->width; maxy = (float)w->height;
+		b.minz = 0.0f;
+		b.maxz = MAX( b.maxz, 0.0f );
+	}
+	b.minx = (int)MAX( floorf( minx ), -1.0f );
+	b.miny = (int)MAX( floorf( miny ), -1.0f );
+	b.maxx = (int)MIN( ceilf( maxx ), (float)w->width );
+	b.maxy = (int)MIN( ceilf( maxy ), (float)w->height );
+	return b;
+}
+
+/**
+ * Ajoute la contribution des lumières ponctuelles retenues au point p de normale n
+ */
+static vec3f_t DeferredPointLights( const deferredpass_t * d, const int * list, int count, vec3f_t p, vec3f_t n, vec3f_t color ) {
+	vec3f_t v = Vec3fNormalize( Vec3fSub( d->eye, p ) );
+	for ( int k = 0; k < count; k++ ) {
+		const pointlight_t * pl = &d->points[ list[ k ] ];
+		vec3f_t l = Vec3fSub( pl->position, p );
+		float d2 = Vec3fDot( l, l );
+		if ( d2 >= pl->radius * pl->radius ) {
+			continue;
+		}
+		float dist = sqrtf( d2 );
+		l = Vec3fScale( l, 1.0f / MAX( dist, 1e-6f ) );
+		float ndl = Vec3fDot( n, l );
+		if ( ndl <= 0.0f ) {
+			continue;
+		}
+		float falloff = 1.0f - dist / pl->radius;
+		float ndh = MAX( Vec3fDot( n, Vec3fNormalize( Vec3fAdd( l, v ) ) ), 0.0f );
+		float i = 255.0f * falloff * falloff * ( d->l->diffuse * ndl + d->l->specular * LightSpecularPower( ndh ) );
+		color = Vec3fAdd( color, Vec3fScale( pl->color, i ) );
+	}
+	return Vec3f( MIN( color.x, 255.0f ), MIN( color.y, 255.0f ), MIN( color.z, 255.0f ) );
+}
+
+static void DeferredShadeTile( void * data, int index ) {
+	deferredpass_t * p = (deferredpass_t*)data;
+	int x0 = ( index % p->tilesx ) * DEFERRED_TILE, y0 = ( index / p->tilesx ) * DEFERRED_TILE;
+	int x1 = MIN( x0 + DEFERRED_TILE, p->w->width ), y1 = MIN( y0 + DEFERRED_TILE, p->w->height );
+
+	// Intervalle de profondeur de la géométrie de la tuile
+	float minz = HUGE_VALF, maxz = -HUGE_VALF;
+	for ( int y = y0; y < y1; y++ ) {
+		float * depth = WindowDepths( p->w, 0, y );
+		for ( int x = x0; x < x1; x++ ) {
+			if ( depth[ x ] < 1.0f ) {
+				minz = MIN( minz, depth[ x ] );
+				maxz = MAX( maxz, depth[ x ] );
+			}
+		}
+	}
+	if ( minz > maxz ) {
+		return;
+	}
+
+	int list[ DEFERRED_MAX_LIGHTS ];
+	int count = 0;
+	for ( int i = 0; i < p->npoints && count < DEFERRED_MAX_LIGHTS; i++ ) {
+		const deferredbounds_t * b = &p->bounds[ i ];
+		if ( !p->cull || ( b->maxx >= x0 && b->minx < x1 && b->maxy >= y0 && b->miny < y1 && b->maxz >= minz && b->minz <= maxz ) ) {
+			list[ count++ ] = i;
+		}
+	}
+	SDL_AtomicAdd( &p->ntiles, 1 );
+	SDL_AtomicAdd( &p->nlights, count );
+
+	for ( int y = y0; y < y1; y++ ) {
+		Uint32 * dst = WindowPixels( p->w, 0, y );
+		float * depth = WindowDepths( p->w, 0, y );
+		Uint32 * normal = p->g->normal + y * p->g->width;
+		int x = x0;
+#if defined( __SSE2__ )
+		// Sans lumière ponctuelle ni ombre, quatre pixels à la fois, seuls ceux couverts sont remplacés
+		for ( ; count == 0 && p->shadow == NULL && x + 4 <= x1; x += 4 ) {
+			__m128 covered = _mm_cmplt_ps( _mm_loadu_ps( depth + x ), _mm_set1_ps( 1.0f ) );
+			if ( _mm_movemask_ps( covered ) == 0 ) {
+				continue;
+			}
+			__m128 nx, ny, nz;
+			GBufferUnpackNormal4( _mm_loadu_si128( (__m128i*)( normal + x ) ), &nx, &ny, &nz );
+			__m128i color = LightShade4( p->l, nx, ny, nz );
+			__m128i mask = _mm_castps_si128( covered );
+			__m128i old = _mm_loadu_si128( (__m128i*)( dst + x ) );
+			_mm_storeu_si128( (__m128i*)( dst + x ), _mm_or_si128( _mm_and_si128( mask, color ), _mm_andnot_si128( mask, old ) ) );
+		}
+#endif
+		for ( ; x < x1; x++ ) {
+			if ( depth[ x ] >= 1.0f ) {
+				continue;
+			}
+			vec3f_t n = GBufferUnpackNormal( normal[ x ] );
+			if ( count == 0 && p->shadow == NULL ) {
+				vec3f_t c = LightShade( p->l, n );
+				dst[ x ] = WindowColor( (Uint8)c.x, (Uint8)c.y, (Uint8)c.z );
+				continue;
+			}
+			// Position monde retrouvée depuis la profondeur par la matrice écran inverse
+			vec4f_t h = MatrixfTransform( p->inverse, Vec3f( x + 0.5f, y + 0.5f, depth[ x ] ) );
+			vec3f_t world = Vec3fScale( Vec3f( h.x, h.y, h.z ), 1.0f / h.w );
+			float visibility = ( p->shadow != NULL ) ? ShadowMapVisibility( p->shadow, world ) : 1.0f;
+			vec3f_t c = LightShadeVisible( p->l, n, visibility );
+			if ( count > 0 ) {
+				c = DeferredPointLights( p, list, count, world, n, c );
+			}
+			dst[ x ] = WindowColor( (Uint8)c.x, (Uint8)c.y, (Uint8)c.z );
+		}
+	}
+}
+
+void DeferredShade( window_t * w, gbuffer_t * g, camera_t * c, const light_t * l, const pointlight_t * points, int npoints, bool cull, const shadowmap_t * shadow ) {
+	deferredpass_t p;
+	p.w       = w;
+	p.g       = g;
+	p.l       = l;
+	p.shadow  = shadow;
+	p.points  = points;
+	p.npoints = ( points != NULL ) ? npoints : 0;
+	p.cull    = cull;
+	p.eye     = c->eye;
+	p.tilesx  = ( w->width + DEFERRED_TILE - 1 ) / DEFERRED_TILE;
+	SDL_AtomicSet( &p.ntiles, 0 );
+	SDL_AtomicSet( &p.nlights, 0 );
+	int tilesy = ( w->height + DEFERRED_TILE - 1 ) / DEFERRED_TILE;
+
+	matrixf_t screen = CameraScreen( c, w->width, w->height );
+	p.inverse = MatrixfInverse( screen, 4 );
+	if ( p.inverse == NULL ) {
+		MatrixfDelete( screen, 4 );
+		return;
+	}
+	if ( g_nbounds < p.npoints ) {
+		free( g_bounds );
+		g_bounds  = (deferredbounds_t*)malloc( sizeof( deferredbounds_t ) * p.npoints );
+		g_nbounds = p.npoints;
+		if ( g_bounds == NULL ) {
+			printf( "(EE) Unable to allocate bounds of %d point lights\n", p.npoints );
+			g_nbounds = 0;
+			MatrixfDelete( screen, 4 );
+			MatrixfDelete( p.inverse, 4 );
+			return;
+		}
+	}
+	for ( int i = 0; i < p.npoints; i++ ) {
+		g_bounds[ i ] = DeferredLightBounds( w, screen, &points[ i ] );
+	}
+	p.bounds = g_bounds;
+
+	JobsRun( DeferredShadeTile, &p, p.tilesx * tilesy );
+
+	int ntiles = SDL_AtomicGet( &p.ntiles );
+	g_lightspertile = ( ntiles > 0 ) ? (float)SDL_AtomicGet( &p.nlights ) / ntiles : 0.0f;
+	MatrixfDelete( screen, 4 );
+	MatrixfDelete( p.inverse, 4 );
+}
+
+float DeferredLightsPerTile() {
+	return g_lightspertile;
+}
+
+void DeferredQuit() {
+	free( g_bounds );
+	g_bounds  = NULL;
+	g_nbounds = 0;
+}
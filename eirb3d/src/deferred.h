@@ -0,0 +1,43 @@
+#ifndef __DEFERRED_H__
+#define __DEFERRED_H__
+
+#include "window.h"
+#include "gbuffer.h"
+#include "light.h"
+#include "camera.h"
+#include "shadow.h"
+
+/**
+ * Ct en pixels des tuiles traites par une mme tche
+ */
+#define DEFERRED_TILE		32
+
+/**
+ * Nombre maximal de lumires ponctuelles retenues par tuile
+ */
+#define DEFERRED_MAX_LIGHTS	1024
+
+/**
+ * Dfinition des prototypes de fonctions
+ */
+
+/**
+ * Eclaire une seule fois chaque pixel visible du tampon gomtrique, par tuiles
+ * rparties entre les threads. Les pixels sans gomtrie (profondeur 1) sont conservs.
+ * Si cull est vrai, chaque tuile n'value que les lumires ponctuelles dont la sphre
+ * recoupe son rectangle et son intervalle de profondeur. Si shadow n'est pas NULL,
+ * la lumire directionnelle est attnue par la carte d'ombre.
+ */
+void			DeferredShade		( window_t * w, gbuffer_t * g, camera_t * c, const light_t * l, const pointlight_t * points, int npoints, bool cull, const shadowmap_t * shadow );
+
+/**
+ * Retourne le nombre moyen de lumires ponctuelles values par tuile non vide lors du dernier appel
+ */
+float			DeferredLightsPerTile	();
+
+/**
+ * Libre les tableaux gards d'un appel  l'autre
+ */
+void			DeferredQuit		();
+
+#endif //__DEFERRED_H__
@@ -0,0 +1,68 @@
+#include "edges.h"
+
+static int EdgesCompare( const void * a, const void * b ) {
+	unsigned long long x = *(const unsigned long long*)a;
+	unsigned long long y = *(const unsigned long long*)b;
+	return ( x > y ) - ( x < y );
+}
+
+edges_t * Edges( vector_t * vertices, vector_t * faces ) {
+	int nfaces = VectorGetLength( faces );
+	int npositions = VectorGetLength( vertices );
+	edges_t * e = (edges_t*)malloc( sizeof( edges_t ) );
+	unsigned long long * keys = (unsigned long long*)malloc( sizeof( unsigned long long ) * nfaces * 3 );
+	vec3f_t * positions = (vec3f_t*)malloc( sizeof( vec3f_t ) * MAX( npositions, 1 ) );
+	int * indices = (int*)malloc( sizeof( int ) * 2 * nfaces * 3 );
+	if ( e == NULL || keys == NULL || positions == NULL || indices == NULL ) {
+		printf( "(EE) Unable to allocate edges\n" );
+		free( e ); free( keys ); free( positions ); free( indices );
+		return NULL;
+	}
+
+	// Positions recopiées dans un tableau contigu pour la transformation en bloc
+	e->npositions = npositions;
+	e->positions = positions;
+	for ( int i = 0; i < e->npositions; i++ ) {
+		e->positions[ i ] = *(vec3f_t*)VectorGetFromIdx( vertices, i );
+	}
+
+	// Chaque arête devient une clé ( min, max ) : le tri regroupe les doublons
+	for ( int i = 0; i < nfaces; i++ ) {
+		face_t * f = (face_t*)VectorGetFromIdx( faces, i );
+		for ( int j = 0; j < 3; j++ ) {
+			unsigned int a = f->v[ j ] - 1;
+			unsigned int b = f->v[ ( j + 1 ) % 3 ] - 1;
+			keys[ i * 3 + j ] = ( (unsigned long long)MIN( a, b ) << 32 ) | MAX( a, b );
+		}
+	}
+	qsort( keys, nfaces * 3, sizeof( unsigned long long ), EdgesCompare );
+
+	e->indices = indices;
+	e->count = 0;
+	for ( int i = 0; i < nfaces * 3; i++ ) {
+		if ( i > 0 && keys[ i ] == keys[ i - 1 ] ) {
+			continue;
+		}
+		e->indices[ e->count * 2 ]     = (int)( keys[ i ] >> 32 );
+		e->indices[ e->count * 2 + 1 ] = (int)( keys[ i ] & 0xFFFFFFFFu );
+		e->count++;
+	}
+	// Ne fait que réduire le bloc : en cas d'échec, l'ancien reste valide
+	indices = (int*)realloc( e->indices, sizeof( int ) * 2 * MAX( e->count, 1 ) );
+	if ( indices != NULL ) {
+		e->indices = indices;
+	}
+
+	printf( "(II) Edges: %d unique edges for %d face edges\n", e->count, nfaces * 3 );
+
+	free( keys );
+	return e;
+}
+
+void EdgesDelete( edges_t * e ) {
+	if ( e != NULL ) {
+		free( e->positions );
+		free( e->indices );
+		free( e );
+	}
+}
@@ -0,0 +1,36 @@
+#ifndef __EDGES_H__
+#define __EDGES_H__
+
+#include "vector.h"
+#include "geometry.h"
+
+/**
+ * Dfinition des types
+ */
+
+/**
+ * Liste des artes uniques d'un modle : une arte partage par deux faces n'y
+ * figure qu'une fois. Chaque arte est une paire d'index dans positions.
+ */
+typedef struct edges {
+	vec3f_t		*	positions;
+	int			npositions;
+	int		*	indices;
+	int			count;
+}edges_t;
+
+/**
+ * Dfinition des prototypes de fonctions
+ */
+
+/**
+ * Construit la liste des artes uniques des faces
+ */
+edges_t			*	Edges			( vector_t * vertices, vector_t * faces );
+
+/**
+ * Supprime une liste d'artes
+ */
+void				EdgesDelete		( edges_t * e );
+
+#endif //__EDGES_H__
@@ -1,20 +1,137 @@
 #include "events.h"
+#include "model.h"
+#include "render.h"
+#include "raster.h"
+
+/**
+ * Direction de la camra associe  une touche, 0 pour les autres touches
+ */
+static int EventsDirection( SDL_Keycode key ) {
+	static const SDL_Keycode keys[ 6 ] = { SDLK_UP, SDLK_DOWN, SDLK_LEFT, SDLK_RIGHT, SDLK_PAGEUP, SDLK_PAGEDOWN };
+	for ( int i = 0; i < 6; i++ ) {
+		if ( key == keys[ i ] ) {
+			return 1 << i;	// Dans l'ordre de CONTROLLER_FORWARD  CONTROLLER_DOWN
+		}
+	}
+	return 0;
+}
 
 /**
  * Rcupre et traite les venements d'une fentre
  */
-int EventsUpdate( window_t * w ) {
+int EventsUpdate( window_t * w, camera_t * c, controller_t * k, int timeout ) {
 	SDL_Event event;
 	bool done = false;
-	while ( SDL_PollEvent( &event ) ) {      
+	// Le premier vnement est attendu au plus timeout millisecondes, les suivants seulement relevs
+	int pending = ( timeout > 0 ) ? SDL_WaitEventTimeout( &event, timeout ) : SDL_PollEvent( &event );
+	for ( ; pending; pending = SDL_PollEvent( &event ) ) {
 		unsigned int e = event.type;
-		if ( e == SDL_KEYDOWN ) {
+		if ( ( e == SDL_KEYDOWN || e == SDL_KEYUP ) && EventsDirection( event.key.keysym.sym ) != 0 ) {
+			// flches et page haut / bas : mouvement continu de la camra tant que la touche est enfonce
+			if ( !event.key.repeat ) {
+				ControllerHold( k, EventsDirection( event.key.keysym.sym ), e == SDL_KEYDOWN, event.key.timestamp );
+			}
+		}else if ( e == SDL_KEYDOWN ) {
 			if( event.key.keysym.sym == SDLK_f ) {
-				// appui sur la touche f du clavier
+				// bascule de l'anti-crnelage en post-traitement (FXAA)
+				RenderOptions()->fxaa = !RenderOptions()->fxaa;
+			}else if ( event.key.keysym.sym == SDLK_r ) {
+				// bascule entre rasterisation flottante et virgule fixe
+				render_t * r = RenderOptions();
+				r->raster = ( r->raster == RASTER_FIXED ) ? RASTER_FLOAT : RASTER_FIXED;
+			}else if ( event.key.keysym.sym == SDLK_l ) {
+				// passe au mode d'clairage suivant : plat, Gouraud, Phong
+				render_t * r = RenderOptions();
+				r->shading = ( r->shading + 1 ) % 3;
+			}else if ( event.key.keysym.sym == SDLK_d ) {
+				// bascule du rendu diffr
+				RenderOptions()->deferred = !RenderOptions()->deferred;
+			}else if ( event.key.keysym.sym == SDLK_p ) {
+				// allume ou teint les lumires ponctuelles (rendu diffr uniquement)
+				render_t * r = RenderOptions();
+				r->nlights = ( r->nlights > 0 || r->lights == NULL ) ? 0 : RENDER_POINT_LIGHTS;
+			}else if ( event.key.keysym.sym == SDLK_s ) {
+				// bascule des ombres portes (rendu diffr uniquement)
+				RenderOptions()->shadows = !RenderOptions()->shadows;
+			}else if ( event.key.keysym.sym == SDLK_z ) {
+				// bascule de la pr-passe de profondeur
+				RenderOptions()->zprepass = !RenderOptions()->zprepass;
+			}else if ( event.key.keysym.sym == SDLK_h ) {
+				// bascule de la carte de surcharge (critures par pixel)
+				RenderOptions()->heatmap = !RenderOptions()->heatmap;
+			}else if ( event.key.keysym.sym == SDLK_m ) {
+				// bascule du multi-chantillonnage 4x
+				RenderOptions()->msaa = !RenderOptions()->msaa;
+			}else if ( event.key.keysym.sym == SDLK_v ) {
+				// bascule de la rsolution dynamique
+				RenderOptions()->dynamic = !RenderOptions()->dynamic;
+			}else if ( event.key.keysym.sym == SDLK_c ) {
+				// bascule entre boucle continue (animations) et boucle pilote par les vnements
+				RenderOptions()->continuous = !RenderOptions()->continuous;
+			}else if ( event.key.keysym.sym == SDLK_n ) {
+				// passe au mode de prsentation suivant : en file, faible latence, sans synchronisation
+				static const char * names[ WINDOW_PRESENT_MODES ] = { "queued", "low latency", "immediate" };
+				WindowPresentMode( w, ( w->present + 1 ) % WINDOW_PRESENT_MODES );
+				printf( "(II) Present mode: %s\n", names[ w->present ] );
+			}else if ( event.key.keysym.sym == SDLK_k ) {
+				// passe au niveau de dtail suivant : automatique, puis chacun impos
+				render_t * r = RenderOptions();
+				int levels = ( ModelLods() != NULL ) ? ModelLods()->count : 1;
+				r->lod = ( r->lod + 1 < levels ) ? r->lod + 1 : RENDER_LOD_AUTO;
+				if ( r->lod == RENDER_LOD_AUTO ) {
+					printf( "(II) Level of detail: auto\n" );
+				}else {
+					printf( "(II) Level of detail: %d\n", r->lod );
+				}
+			}else if ( event.key.keysym.sym == SDLK_o ) {
+				// bascule de la camra entre orbite et vol libre
+				ControllerToggleMode( k );
+			}else if ( event.key.keysym.sym == SDLK_w ) {
+				// bascule du rendu en fil de fer
+				RenderOptions()->wireframe = !RenderOptions()->wireframe;
+			}else if ( event.key.keysym.sym == SDLK_a ) {
+				// bascule de l'anti-crnelage des lignes du fil de fer
+				RenderOptions()->antialias = !RenderOptions()->antialias;
 			}
+		}else if ( e == SDL_MOUSEBUTTONDOWN ) {
+			if ( event.button.button == SDL_BUTTON_LEFT ) {
+				// slection de la face sous le curseur
+				float t;
+				// le curseur est en pixels de la fentre, quelle que soit la rsolution interne
+				ray_t r = CameraRay( c, event.button.x, event.button.y, w->displaywidth, w->displayheight );
+				int face = BvhPick( ModelBvh(), r, &t );
+				if ( face >= 0 ) {
+					printf( "(II) Picked face %d at distance %f\n", face, t );
+				}
+			}
+		}else if ( e == SDL_MOUSEMOTION ) {
+			// glissement : bouton gauche pour tourner, bouton droit pour dplacer dans le plan de l'cran
+			if ( event.motion.state & SDL_BUTTON_LMASK ) {
+				ControllerRotate( k, event.motion.xrel, event.motion.yrel, event.motion.timestamp );
+			}else if ( event.motion.state & SDL_BUTTON_RMASK ) {
+				ControllerPan( k, event.motion.xrel, event.motion.yrel, event.motion.timestamp );
+			}
+		}else if ( e == SDL_MOUSEWHEEL ) {
+			ControllerZoom( k, event.wheel.y, event.wheel.timestamp );
+		}else if ( e == SDL_WINDOWEVENT ) {
+			// fentre dcouverte ou redimensionne : la trame est redessine et prsente
+			if ( event.window.event == SDL_WINDOWEVENT_EXPOSED || event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED ) {
+				RenderInvalidate();
+			}
+		}else if ( e == SDL_USEREVENT && event.user.code == EVENTS_WAKE ) {
+			// rveil demand par EventsWake
+			RenderInvalidate();
 		}else if ( e == SDL_QUIT ) {
 			done = true;
 		}
 	}
 	return done;
 }
+
+void EventsWake() {
+	SDL_Event event;
+	memset( &event, 0, sizeof( event ) );
+	event.type = SDL_USEREVENT;
+	event.user.code = EVENTS_WAKE;
+	SDL_PushEvent( &event );
+}
@@ -4,10 +4,36 @@
 #include <stdbool.h>
 #include "SDL2/SDL.h"
 #include "window.h"
+#include "camera.h"
+#include "controller.h"
+
+/**
+ * Attente maximale d'un vnement quand rien n'est  redessiner, en millisecondes
+ */
+#define EVENTS_IDLE_TIMEOUT	1000
+
+/**
+ * Code des vnements SDL_USEREVENT pousss par EventsWake
+ */
+#define EVENTS_WAKE		1
 
 /**
  * Dfinition des prototypes de fonctions
  */
-int EventsUpdate( window_t * w );
+
+/**
+ * Traite les vnements en attente et retourne vrai si la fentre doit tre ferme.
+ * Souris et touches de dplacement sont transmises au contrleur de camra k, la
+ * camra c tant celle de la dernire trame (slection sous le curseur).
+ * Si timeout est positif et qu'aucun vnement n'est en attente, bloque jusqu'au
+ * prochain au plus timeout millisecondes au lieu de retourner aussitt.
+ */
+int EventsUpdate( window_t * w, camera_t * c, controller_t * k, int timeout );
+
+/**
+ * Rveille la boucle principale bloque dans EventsUpdate et force une nouvelle trame
+ * (fin d'un chargement, minuterie). Peut tre appele depuis n'importe quel thread.
+ */
+void EventsWake();
 
 #endif //__EVENTS_H__
@@ -0,0 +1,214 @@
+#include "fxaa.h"
+#include "jobs.h"
+#if defined( __SSE2__ )
+#include <emmintrin.h>
+#endif
+
+// Pas de la recherche des extrémités d'un bord, de plus en plus grands
+static const int	g_steps[]	= { 1, 1, 1, 1, 1, 2, 2, 2, 4, 8 };
+#define FXAA_STEPS		( (int)( sizeof( g_steps ) / sizeof( g_steps[ 0 ] ) ) )
+#define FXAA_SUBPIXEL		0.75f
+
+// Luminance de chaque pixel, et image filtrée échangée avec le framebuffer
+static Uint8	*	g_luma		= NULL;
+static Uint32	*	g_output	= NULL;
+static int		g_size		= 0;
+
+/**
+ * Luminance d'un pixel dans [0,255], pondérée en faveur du vert
+ */
+static inline int FxaaLuma( Uint32 p ) {
+	return ( ( ( p >> 16 ) & 0xFF ) * 77 + ( ( p >> 8 ) & 0xFF ) * 150 + ( p & 0xFF ) * 29 + 128 ) >> 8;
+}
+
+/**
+ * Mélange deux couleurs, t dans [0,1] étant le poids de b
+ */
+static inline Uint32 FxaaBlend( Uint32 a, Uint32 b, float t ) {
+	Uint32 wb = (Uint32)( t * 256.0f ), wa = 256 - wb;
+	Uint32 rb = ( ( a & 0xFF00FF ) * wa + ( b & 0xFF00FF ) * wb ) >> 8;
+	Uint32 g  = ( ( a & 0x00FF00 ) * wa + ( b & 0x00FF00 ) * wb ) >> 8;
+	return 0xFF000000 | ( rb & 0xFF00FF ) | ( g & 0x00FF00 );
+}
+
+/**
+ * Filtre un pixel hors des bords de l'image : détection du bord à partir des
+ * luminances voisines, recherche de ses extrémités, puis mélange avec le voisin
+ * situé de l'autre côté du bord
+ */
+static Uint32 FxaaPixel( window_t * w, int x, int y ) {
+	int width = w->width;
+	const Uint8 * l = g_luma + y * width + x;
+	const Uint32 * c = WindowPixels( w, x, y );
+	int m = l[ 0 ], n = l[ -width ], s = l[ width ], wl = l[ -1 ], e = l[ 1 ];
+	int hi = MAX( MAX( MAX( n, s ), MAX( wl, e ) ), m );
+	int lo = MIN( MIN( MIN( n, s ), MIN( wl, e ) ), m );
+	int range = hi - lo;
+	if ( range < MAX( FXAA_THRESHOLD_MIN, hi >> FXAA_THRESHOLD_SHIFT ) ) {
+		return c[ 0 ];
+	}
+	int nw = l[ -width - 1 ], ne = l[ -width + 1 ], sw = l[ width - 1 ], se = l[ width + 1 ];
+
+	// Bord horizontal si la luminance varie davantage verticalement qu'horizontalement
+	int horizontal = abs( nw + sw - 2 * wl ) + 2 * abs( n + s - 2 * m ) + abs( ne + se - 2 * e );
+	int vertical   = abs( nw + ne - 2 * n ) + 2 * abs( wl + e - 2 * m ) + abs( sw + se - 2 * s );
+	bool horz = ( horizontal >= vertical );
+
+	// Côté du bord où le gradient est le plus fort : step vaut -1 (haut ou gauche) ou 1
+	int lneg = horz ? n : wl, lpos = horz ? s : e;
+	int gneg = abs( lneg - m ), gpos = abs( lpos - m );
+	int step = ( gneg >= gpos ) ? -1 : 1;
+	int gradient = MAX( gneg, gpos );
+	int sx = horz ? 0 : step, sy = horz ? step : 0;
+
+	// Recherche des extrémités du bord dans les deux sens, à mi-chemin entre les deux
+	// côtés : les sommes de deux luminances évitent toute division, et seule la position
+	// le long du bord est bornée à l'image
+	const Uint8 * base = l - ( horz ? x : y * width );
+	int along = horz ? x : y, length = horz ? width : w->height;
+	int stride = horz ? 1 : width, across = sy * width + sx;
+	int average = m + l[ across ];
+	int d1 = 1, d2 = 1, end1 = 0, end2 = 0;
+	bool reached1 = false, reached2 = false;
+	// Les deux côtés avancent ensemble, sans branchement sur un côté déjà arrêté
+	for ( int i = 0; i < FXAA_STEPS && !( reached1 && reached2 ); i++ ) {
+		const Uint8 * p1 = base + MAX( along - d1, 0 ) * stride;
+		const Uint8 * p2 = base + MIN( along + d2, length - 1 ) * stride;
+		end1 = reached1 ? end1 : p1[ 0 ] + p1[ across ] - average;
+		end2 = reached2 ? end2 : p2[ 0 ] + p2[ across ] - average;
+		reached1 = ( 2 * abs( end1 ) >= gradient );
+		reached2 = ( 2 * abs( end2 ) >= gradient );
+		d1 += reached1 ? 0 : g_steps[ i ];
+		d2 += reached2 ? 0 : g_steps[ i ];
+	}
+
+	// Décalage selon la position du pixel le long du bord, seulement si l'extrémité la
+	// plus proche varie dans le sens opposé au pixel
+	bool closer1 = ( d1 < d2 );
+	float offset = 0.5f - (float)MIN( d1, d2 ) / (float)( d1 + d2 );
+	if ( ( ( closer1 ? end1 : end2 ) < 0 ) == ( 2 * m < average ) ) {
+		offset = 0.0f;
+	}
+
+	// Anti-crénelage des détails plus fins qu'un pixel, d'après la moyenne du voisinage
+	float neighbours = (float)( 2 * ( n + s + wl + e ) + ( nw + ne + sw + se ) - 12 * m );
+	float sub = MIN( fabsf( neighbours ) / (float)( 12 * range ), 1.0f );
+	sub = ( -2.0f * sub + 3.0f ) * sub * sub;
+	offset = MAX( offset, sub * sub * FXAA_SUBPIXEL );
+
+	return FxaaBlend( c[ 0 ], c[ sy * width + sx ], offset );
+}
+
+static void FxaaLumaBand( void * data, int band ) {
+	window_t * w = (window_t*)data;
+	int y0 = band * FXAA_BAND, y1 = MIN( y0 + FXAA_BAND, w->height );
+	int n = ( y1 - y0 ) * w->width;
+	const Uint32 * src = WindowPixels( w, 0, y0 );
+	Uint8 * dst = g_luma + y0 * w->width;
+	int i = 0;
+#if defined( __SSE2__ )
+	__m128i mask = _mm_set1_epi32( 0xFF ), half = _mm_set1_epi32( 128 );
+	__m128i kr = _mm_set1_epi32( 77 ), kg = _mm_set1_epi32( 150 ), kb = _mm_set1_epi32( 29 );
+	for ( ; i + 16 <= n; i += 16 ) {
+		__m128i l[ 4 ];
+		for ( int k = 0; k < 4; k++ ) {
+			__m128i p = _mm_loadu_si128( (const __m128i*)( src + i + k * 4 ) );
+			// Composantes et produits tiennent sur les 16 bits de poids faible de chaque mot
+			__m128i r = _mm_mullo_epi16( _mm_and_si128( _mm_srli_epi32( p, 16 ), mask ), kr );
+			__m128i g = _mm_mullo_epi16( _mm_and_si128( _mm_srli_epi32( p, 8 ), mask ), kg );
+			__m128i b = _mm_mullo_epi16( _mm_and_si128( p, mask ), kb );
+			l[ k ] = _mm_srli_epi32( _mm_add_epi32( _mm_add_epi32( r, g ), _mm_add_epi32( b, half ) ), 8 );
+		}
+		_mm_storeu_si128( (__m128i*)( dst + i ), _mm_packus_epi16( _mm_packs_epi32( l[ 0 ], l[ 1 ] ), _mm_packs_epi32( l[ 2 ], l[ 3 ] ) ) );
+	}
+#endif
+	for ( ; i < n; i++ ) {
+		dst[ i ] = (Uint8)FxaaLuma( src[ i ] );
+	}
+}
+
+static void FxaaFilterBand( void * data, int band ) {
+	window_t * w = (window_t*)data;
+	int width = w->width, height = w->height;
+	int y0 = band * FXAA_BAND, y1 = MIN( y0 + FXAA_BAND, height );
+	for ( int y = y0; y < y1; y++ ) {
+		const Uint32 * src = WindowPixels( w, 0, y );
+		Uint32 * dst = g_output + y * width;
+		// Les pixels du bord de l'image sont recopiés tels quels
+		if ( y == 0 || y == height - 1 ) {
+			memcpy( dst, src, width * sizeof( Uint32 ) );
+			continue;
+		}
+		dst[ 0 ] = src[ 0 ];
+		dst[ width - 1 ] = src[ width - 1 ];
+		int x = 1;
+#if defined( __SSE2__ )
+		// Contraste local de seize pixels à la fois : la plupart ne sont pas sur un bord
+		const Uint8 * l = g_luma + y * width;
+		__m128i minimum = _mm_set1_epi8( FXAA_THRESHOLD_MIN ), low = _mm_set1_epi8( 0xFF >> FXAA_THRESHOLD_SHIFT ), zero = _mm_setzero_si128();
+		for ( ; x + 16 <= width - 1; x += 16 ) {
+			__m128i m = _mm_loadu_si128( (const __m128i*)( l + x ) );
+			__m128i n = _mm_loadu_si128( (const __m128i*)( l + x - width ) );
+			__m128i s = _mm_loadu_si128( (const __m128i*)( l + x + width ) );
+			__m128i wl = _mm_loadu_si128( (const __m128i*)( l + x - 1 ) );
+			__m128i e = _mm_loadu_si128( (const __m128i*)( l + x + 1 ) );
+			__m128i hi = _mm_max_epu8( _mm_max_epu8( _mm_max_epu8( n, s ), _mm_max_epu8( wl, e ) ), m );
+			__m128i lo = _mm_min_epu8( _mm_min_epu8( _mm_min_epu8( n, s ), _mm_min_epu8( wl, e ) ), m );
+			__m128i threshold = _mm_max_epu8( _mm_and_si128( _mm_srli_epi16( hi, FXAA_THRESHOLD_SHIFT ), low ), minimum );
+			// Bord si range >= seuil, c'est-à-dire si seuil - range sature à zéro
+			int edges = _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_subs_epu8( threshold, _mm_subs_epu8( hi, lo ) ), zero ) );
+			if ( edges == 0 ) {
+				memcpy( dst + x, src + x, 16 * sizeof( Uint32 ) );
+				continue;
+			}
+			for ( int k = 0; k < 16; k++ ) {
+				dst[ x + k ] = ( edges & ( 1 << k ) ) ? FxaaPixel( w, x + k, y ) : src[ x + k ];
+			}
+		}
+#endif
+		for ( ; x < width - 1; x++ ) {
+			dst[ x ] = FxaaPixel( w, x, y );
+		}
+	}
+}
+
+void FxaaApply( window_t * w ) {
+	if ( w->samples > 1 ) {
+		return;
+	}
+	int n = w->width * w->height;
+	if ( g_size != n ) {
+		free( g_luma );
+		free( g_output );
+		g_luma   = (Uint8*)malloc( n );
+		g_output = (Uint32*)malloc( sizeof( Uint32 ) * n );
+		g_size   = n;
+		if ( g_luma == NULL || g_output == NULL ) {
+			SDL_LogError( SDL_LOG_CATEGORY_APPLICATION, "Couldn't allocate FXAA buffers\n" );
+			free( g_luma );
+			free( g_output );
+			g_luma = NULL;
+			g_output = NULL;
+			g_size = 0;
+			return;
+		}
+	}
+
+	// Toutes les luminances sont connues avant de filtrer : les bandes lisent celles de leurs voisines
+	int bands = ( w->height + FXAA_BAND - 1 ) / FXAA_BAND;
+	JobsRun( FxaaLumaBand, w, bands );
+	JobsRun( FxaaFilterBand, w, bands );
+
+	// L'image filtrée devient le framebuffer, l'ancien recevra le résultat suivant
+	Uint32 * previous = (Uint32*)w->framebuffer;
+	w->framebuffer = (unsigned char*)g_output;
+	g_output = previous;
+}
+
+void FxaaQuit() {
+	free( g_luma );
+	free( g_output );
+	g_luma = NULL;
+	g_output = NULL;
+	g_size = 0;
+}
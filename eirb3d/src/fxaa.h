@@ -0,0 +1,34 @@
+#ifndef __FXAA_H__
+#define __FXAA_H__
+
+#include "window.h"
+
+/**
+ * Nombre de lignes traites par une mme tche
+ */
+#define FXAA_BAND		32
+
+/**
+ * Contraste local minimal, absolu et relatif  la luminance la plus forte, pour
+ * qu'un pixel soit trait comme un bord (luminances dans [0,255])
+ */
+#define FXAA_THRESHOLD_MIN	16
+#define FXAA_THRESHOLD_SHIFT	3	// Soit 1/8 de la luminance la plus forte
+
+/**
+ * Dfinition des prototypes de fonctions
+ */
+
+/**
+ * Anti-crnelage en post-traitement (FXAA) du framebuffer, par bandes de lignes
+ * rparties entre les threads. L'image filtre remplace le framebuffer de la fentre,
+ * qui ne doit donc pas tre conserv par l'appelant. Sans effet en multi-chantillonnage.
+ */
+void			FxaaApply		( window_t * w );
+
+/**
+ * Libre les luminances et l'image de rechange gardes d'une trame  l'autre
+ */
+void			FxaaQuit		();
+
+#endif //__FXAA_H__
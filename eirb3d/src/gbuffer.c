@@ -0,0 +1,28 @@
+#include "gbuffer.h"
+
+gbuffer_t * GBuffer( int width, int height ) {
+	gbuffer_t * g = (gbuffer_t*)malloc( sizeof( gbuffer_t ) );
+	if ( g == NULL ) {
+		printf( "(EE) Unable to allocate G-buffer\n" );
+		return NULL;
+	}
+	g->width   = width;
+	g->height  = height;
+	g->normal  = (Uint32*)malloc( sizeof( Uint32 ) * width * height );
+	g->surface = (Uint32*)malloc( sizeof( Uint32 ) * width * height );
+	if ( g->normal == NULL || g->surface == NULL ) {
+		printf( "(EE) Unable to allocate %dx%d G-buffer\n", width, height );
+		GBufferDelete( g );
+		return NULL;
+	}
+	return g;
+}
+
+void GBufferDelete( gbuffer_t * g ) {
+	if ( g == NULL ) {
+		return;
+	}
+	free( g->normal );
+	free( g->surface );
+	free( g );
+}
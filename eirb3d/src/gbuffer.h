@@ -0,0 +1,111 @@
+#ifndef __GBUFFER_H__
+#define __GBUFFER_H__
+
+#include <stdio.h>
+#include "SDL2/SDL.h"
+#include "geometry.h"
+
+#if defined( __SSE2__ )
+#include <emmintrin.h>
+#endif
+
+/**
+ * Dfinition des types
+ */
+
+/**
+ * Tampon gomtrique du rendu diffr. La profondeur reste dans le zbuffer de la
+ * fentre ; par pixel s'ajoutent une normale compresse et la surface (coordonnes
+ * de texture et matriau), soit 8 octets.
+ */
+typedef struct gbuffer {
+	Uint32		*	normal;		// Normale en octadre, 2 x 16 bits
+	Uint32		*	surface;	// u et v sur 12 bits, matriau sur 8 bits
+	int			width;
+	int			height;
+}gbuffer_t;
+
+/**
+ * Dfinition des prototypes de fonctions
+ */
+
+/**
+ * Construit un tampon gomtrique de width x height pixels, NULL en cas d'chec
+ */
+gbuffer_t		*	GBuffer			( int width, int height );
+
+/**
+ * Supprime un tampon gomtrique
+ */
+void				GBufferDelete		( gbuffer_t * g );
+
+/**
+ * Compresse une normale (pas forcment unitaire) par projection sur un octadre
+ */
+inline Uint32 GBufferPackNormal( vec3f_t n ) {
+	float l1 = fabsf( n.x ) + fabsf( n.y ) + fabsf( n.z );
+	float inv = ( l1 > 0.0f ) ? 1.0f / l1 : 0.0f;
+	float x = n.x * inv, y = n.y * inv;
+	if ( n.z < 0.0f ) {
+		float ox = ( 1.0f - fabsf( y ) ) * ( ( x >= 0.0f ) ? 1.0f : -1.0f );
+		float oy = ( 1.0f - fabsf( x ) ) * ( ( y >= 0.0f ) ? 1.0f : -1.0f );
+		x = ox; y = oy;
+	}
+	Uint32 px = (Uint32)( ( x * 0.5f + 0.5f ) * 65535.0f + 0.5f );
+	Uint32 py = (Uint32)( ( y * 0.5f + 0.5f ) * 65535.0f + 0.5f );
+	return ( py << 16 ) | px;
+}
+
+/**
+ * Retrouve la normale unitaire compresse par GBufferPackNormal
+ */
+inline vec3f_t GBufferUnpackNormal( Uint32 p ) {
+	float x = ( p & 0xFFFF ) * ( 2.0f / 65535.0f ) - 1.0f;
+	float y = ( p >> 16 ) * ( 2.0f / 65535.0f ) - 1.0f;
+	float z = 1.0f - fabsf( x ) - fabsf( y );
+	if ( z < 0.0f ) {
+		float ox = ( 1.0f - fabsf( y ) ) * ( ( x >= 0.0f ) ? 1.0f : -1.0f );
+		float oy = ( 1.0f - fabsf( x ) ) * ( ( y >= 0.0f ) ? 1.0f : -1.0f );
+		x = ox; y = oy;
+	}
+	return Vec3fNormalize( Vec3f( x, y, z ) );
+}
+
+/**
+ * Compresse des coordonnes de texture (rptes dans [0,1[) et un identifiant de matriau
+ */
+inline Uint32 GBufferPackSurface( float u, float v, int material ) {
+	Uint32 pu = (Uint32)( ( u - floorf( u ) ) * 4095.0f + 0.5f );
+	Uint32 pv = (Uint32)( ( v - floorf( v ) ) * 4095.0f + 0.5f );
+	return ( (Uint32)material << 24 ) | ( pv << 12 ) | pu;
+}
+
+/**
+ * Retourne l'identifiant de matriau d'une surface compresse
+ */
+inline int GBufferMaterial( Uint32 p ) {
+	return p >> 24;
+}
+
+#if defined( __SSE2__ )
+/**
+ * Dcompresse quatre normales  la fois, sans les renormaliser
+ */
+inline void GBufferUnpackNormal4( __m128i p, __m128 * nx, __m128 * ny, __m128 * nz ) {
+	__m128 scale = _mm_set1_ps( 2.0f / 65535.0f ), one = _mm_set1_ps( 1.0f );
+	__m128 sign = _mm_castsi128_ps( _mm_set1_epi32( 0x80000000 ) );
+	__m128 x = _mm_sub_ps( _mm_mul_ps( _mm_cvtepi32_ps( _mm_and_si128( p, _mm_set1_epi32( 0xFFFF ) ) ), scale ), one );
+	__m128 y = _mm_sub_ps( _mm_mul_ps( _mm_cvtepi32_ps( _mm_srli_epi32( p, 16 ) ), scale ), one );
+	__m128 ax = _mm_andnot_ps( sign, x ), ay = _mm_andnot_ps( sign, y );
+	__m128 z = _mm_sub_ps( _mm_sub_ps( one, ax ), ay );
+	// Hmisphre infrieur : repli de l'octadre, le signe de x et y est conserv
+	__m128 fold = _mm_cmplt_ps( z, _mm_setzero_ps() );
+	__m128 ox = _mm_or_ps( _mm_sub_ps( one, ay ), _mm_and_ps( x, sign ) );
+	__m128 oy = _mm_or_ps( _mm_sub_ps( one, ax ), _mm_and_ps( y, sign ) );
+	*nx = _mm_or_ps( _mm_and_ps( fold, ox ), _mm_andnot_ps( fold, x ) );
+	*ny = _mm_or_ps( _mm_and_ps( fold, oy ), _mm_andnot_ps( fold, y ) );
+	*nz = z;
+}
+#endif
+
+#endif //__GBUFFER_H__
@@ -1,28 +1,23 @@
 #include "geometry.h"
+#include <string.h>
 
 matrixf_t Matrixf( int n, int m ) {
-	float ** a = (float **)malloc( sizeof( float * ) * n );
-	if ( a ) {
-		for ( int i = 0; i < n; i++ ) {
-            		a[ i ] = (float*)malloc( sizeof( float ) * m );
-            		if ( a[ i ] == NULL ) {
-                		return NULL;
-            		}
-        	}
-    	}
-    	for ( int i = 0; i < n; i++ ) {
-        	for ( int j = 0; j < m; j++ ) {
-            		a[ i ][ j ] = 0.0f;
-        	}
-    	}
+	// Pointeurs de lignes et coefficients dans un seul bloc, libéré par un seul free
+	float ** a = (float **)malloc( sizeof( float * ) * n + sizeof( float ) * n * m );
+	if ( a == NULL ) {
+		return NULL;
+	}
+	float * data = (float*)( a + n );
+	for ( int i = 0; i < n; i++ ) {
+		a[ i ] = data + i * m;
+	}
+	memset( data, 0, sizeof( float ) * n * m );
 	return a;
 }
 
 void MatrixfDelete( matrixf_t m, int n ) {
-	for ( int i = 0; i < n; i++) {
-		free( m[ i ] );
-	}
-    	free( m );
+	(void)n;
+	free( m );
 }
 
 matrixf_t MatrixfIdentity( int n ) {
@@ -48,14 +43,148 @@ matrixf_t MatrixfMult( matrixf_t a, matrixf_t b, int n, int m ) {
     	return mtx;
 }
 
+matrixf_t MatrixfInverse( matrixf_t m, int n ) {
+	// Gauss-Jordan avec pivot partiel, en double pour les matrices écran mal conditionnées
+	double * a = (double*)malloc( sizeof( double ) * n * 2 * n );
+	if ( a == NULL ) {
+		return NULL;
+	}
+	for ( int i = 0; i < n; i++ ) {
+		for ( int j = 0; j < n; j++ ) {
+			a[ i * 2 * n + j ]     = m[ i ][ j ];
+			a[ i * 2 * n + n + j ] = ( i == j ) ? 1.0 : 0.0;
+		}
+	}
+	for ( int c = 0; c < n; c++ ) {
+		int pivot = c;
+		for ( int i = c + 1; i < n; i++ ) {
+			if ( fabs( a[ i * 2 * n + c ] ) > fabs( a[ pivot * 2 * n + c ] ) ) {
+				pivot = i;
+			}
+		}
+		if ( a[ pivot * 2 * n + c ] == 0.0 ) {
+			free( a );
+			return NULL;
+		}
+		for ( int j = 0; j < 2 * n; j++ ) {
+			double t = a[ c * 2 * n + j ];
+			a[ c * 2 * n + j ] = a[ pivot * 2 * n + j ];
+			a[ pivot * 2 * n + j ] = t;
+		}
+		double inv = 1.0 / a[ c * 2 * n + c ];
+		for ( int j = 0; j < 2 * n; j++ ) {
+			a[ c * 2 * n + j ] *= inv;
+		}
+		for ( int i = 0; i < n; i++ ) {
+			double f = a[ i * 2 * n + c ];
+			if ( i == c || f == 0.0 ) {
+				continue;
+			}
+			for ( int j = 0; j < 2 * n; j++ ) {
+				a[ i * 2 * n + j ] -= f * a[ c * 2 * n + j ];
+			}
+		}
+	}
+	matrixf_t r = Matrixf( n, n );
+	for ( int i = 0; r != NULL && i < n; i++ ) {
+		for ( int j = 0; j < n; j++ ) {
+			r[ i ][ j ] = (float)a[ i * 2 * n + n + j ];
+		}
+	}
+	free( a );
+	return r;
+}
+
 matrixf_t MatrixfViewport( int x, int y, int w, int h ) {
-	// Fonction à implementer
-    	matrixf_t m = MatrixfIdentity( 4 );
-    	return m;
+	// NDC [-1,1] vers pixels, l'axe y est inversé (ligne 0 en haut du framebuffer)
+	// et la profondeur est ramenée dans [0,1]
+	matrixf_t m = MatrixfIdentity( 4 );
+	m[ 0 ][ 0 ] = w / 2.0f;		m[ 0 ][ 3 ] = x + w / 2.0f;
+	m[ 1 ][ 1 ] = -h / 2.0f;	m[ 1 ][ 3 ] = y + h / 2.0f;
+	m[ 2 ][ 2 ] = 0.5f;		m[ 2 ][ 3 ] = 0.5f;
+	return m;
 }
 
 matrixf_t MatrixfLookAt( vec3f_t eye, vec3f_t center, vec3f_t up ) {
-	// Fonction à implementer
-    	matrixf_t r = MatrixfIdentity( 4 );
-    	return r;
+	vec3f_t z = Vec3fNormalize( Vec3fSub( eye, center ) );
+	vec3f_t x = Vec3fNormalize( Vec3fCross( up, z ) );
+	vec3f_t y = Vec3fCross( z, x );
+	matrixf_t r = MatrixfIdentity( 4 );
+	r[ 0 ][ 0 ] = x.x; r[ 0 ][ 1 ] = x.y; r[ 0 ][ 2 ] = x.z; r[ 0 ][ 3 ] = -Vec3fDot( x, eye );
+	r[ 1 ][ 0 ] = y.x; r[ 1 ][ 1 ] = y.y; r[ 1 ][ 2 ] = y.z; r[ 1 ][ 3 ] = -Vec3fDot( y, eye );
+	r[ 2 ][ 0 ] = z.x; r[ 2 ][ 1 ] = z.y; r[ 2 ][ 2 ] = z.z; r[ 2 ][ 3 ] = -Vec3fDot( z, eye );
+	return r;
+}
+
+matrixf_t MatrixfPerspective( float fovy, float aspect, float znear, float zfar ) {
+	float f = 1.0f / tanf( fovy / 2.0f );
+	matrixf_t m = Matrixf( 4, 4 );
+	m[ 0 ][ 0 ] = f / aspect;
+	m[ 1 ][ 1 ] = f;
+	m[ 2 ][ 2 ] = ( zfar + znear ) / ( znear - zfar );
+	m[ 2 ][ 3 ] = 2.0f * zfar * znear / ( znear - zfar );
+	m[ 3 ][ 2 ] = -1.0f;
+	return m;
+}
+
+matrixf_t MatrixfOrtho( float left, float right, float bottom, float top, float znear, float zfar ) {
+	matrixf_t m = MatrixfIdentity( 4 );
+	m[ 0 ][ 0 ] = 2.0f / ( right - left );	m[ 0 ][ 3 ] = -( right + left ) / ( right - left );
+	m[ 1 ][ 1 ] = 2.0f / ( top - bottom );	m[ 1 ][ 3 ] = -( top + bottom ) / ( top - bottom );
+	m[ 2 ][ 2 ] = -2.0f / ( zfar - znear );	m[ 2 ][ 3 ] = -( zfar + znear ) / ( zfar - znear );
+	return m;
+}
+
+frustum_t MatrixfFrustum( matrixf_t m ) {
+	// Méthode de Gribb et Hartmann : chaque plan est une combinaison de la
+	// dernière ligne de la matrice avec l'une des trois premières
+	frustum_t f;
+	for ( int i = 0; i < 6; i++ ) {
+		int row = i / 2;
+		float s = ( i % 2 == 0 ) ? 1.0f : -1.0f;
+		plane_t * p = &f.p[ i ];
+		p->n = Vec3f(	m[ 3 ][ 0 ] + s * m[ row ][ 0 ],
+				m[ 3 ][ 1 ] + s * m[ row ][ 1 ],
+				m[ 3 ][ 2 ] + s * m[ row ][ 2 ] );
+		p->d = m[ 3 ][ 3 ] + s * m[ row ][ 3 ];
+		float l = Vec3fLength( p->n );
+		p->n = Vec3fScale( p->n, 1.0f / l );
+		p->d /= l;
+	}
+	return f;
+}
+
+int FrustumTestAabb( const frustum_t * f, aabb_t b ) {
+	int result = 1;
+	for ( int i = 0; i < 6; i++ ) {
+		const plane_t * p = &f->p[ i ];
+		// Sommets de la boîte le plus loin et le plus proche dans la direction de la normale
+		vec3f_t pos = Vec3f( p->n.x >= 0.0f ? b.max.x : b.min.x,
+				     p->n.y >= 0.0f ? b.max.y : b.min.y,
+				     p->n.z >= 0.0f ? b.max.z : b.min.z );
+		vec3f_t neg = Vec3f( p->n.x >= 0.0f ? b.min.x : b.max.x,
+				     p->n.y >= 0.0f ? b.min.y : b.max.y,
+				     p->n.z >= 0.0f ? b.min.z : b.max.z );
+		if ( Vec3fDot( p->n, pos ) + p->d < 0.0f ) {
+			return -1;
+		}
+		if ( Vec3fDot( p->n, neg ) + p->d < 0.0f ) {
+			result = 0;
+		}
+	}
+	return result;
+}
+
+int FrustumTestSphere( const frustum_t * f, vec3f_t c, float r ) {
+	int result = 1;
+	for ( int i = 0; i < 6; i++ ) {
+		float d = Vec3fDot( f->p[ i ].n, c ) + f->p[ i ].d;
+		if ( d < -r ) {
+			return -1;
+		}
+		if ( d < r ) {
+			result = 0;
+		}
+	}
+	return result;
 }
@@ -13,7 +13,12 @@ typedef struct vec2f		{ float x; float y;			} vec2f_t;
 typedef struct vec3f		{ float x; float y; float z;		} vec3f_t;
 typedef struct vec2i		{ int x; int y;				} vec2i_t;
 typedef struct vec3i		{ int x; int y; int z;			} vec3i_t;
+typedef struct vec4f		{ float x; float y; float z; float w;	} vec4f_t;
 typedef struct face		{ int v[ 3 ]; int vt[ 3 ]; int vn[ 3 ];	} face_t;
+typedef struct aabb		{ vec3f_t min; vec3f_t max;		} aabb_t;
+typedef struct plane		{ vec3f_t n; float d;			} plane_t;
+typedef struct frustum		{ plane_t p[ 6 ];			} frustum_t;
+typedef struct ray		{ vec3f_t o; vec3f_t d;			} ray_t;
 
 /**
  * Dfinition des macros
@@ -62,6 +67,12 @@ matrixf_t	MatrixfIdentity	( int n );
  */
 matrixf_t	MatrixfMult	( matrixf_t a, matrixf_t b, int n, int m );
 
+/**
+ * Inverse une matrice flottante de dimension n x n, retourne NULL si elle est singulire
+ * ou si la mmoire manque
+ */
+matrixf_t	MatrixfInverse	( matrixf_t m, int n );
+
 /**
  * Construit une matrice viewport flottante
  */
@@ -72,6 +83,31 @@ matrixf_t	MatrixfViewport	( int x, int y, int w, int h );
  */
 matrixf_t	MatrixfLookAt	( vec3f_t eye, vec3f_t center, vec3f_t up );
 
+/**
+ * Construit une matrice de projection perspective flottante (fovy en radians)
+ */
+matrixf_t	MatrixfPerspective	( float fovy, float aspect, float znear, float zfar );
+
+/**
+ * Construit une matrice de projection orthographique flottante
+ */
+matrixf_t	MatrixfOrtho	( float left, float right, float bottom, float top, float znear, float zfar );
+
+/**
+ * Extrait les six plans du frustum d'une matrice de projection 4x4 (projection * vue)
+ */
+frustum_t	MatrixfFrustum	( matrixf_t m );
+
+/**
+ * Teste une bote englobante contre un frustum : -1 dehors, 0  cheval, 1 dedans
+ */
+int		FrustumTestAabb	( const frustum_t * f, aabb_t b );
+
+/**
+ * Teste une sphre englobante contre un frustum : -1 dehors, 0  cheval, 1 dedans
+ */
+int		FrustumTestSphere	( const frustum_t * f, vec3f_t c, float r );
+
 /**
  * Echange deux entiers entre eux
  */
@@ -105,6 +141,52 @@ inline vec3f_t Vec3fSub( vec3f_t a, vec3f_t b ) {
 	return r;
 }
 
+/**
+ * Additionne deux vecteurs flottant de dimension 3
+ */
+inline vec3f_t Vec3fAdd( vec3f_t a, vec3f_t b ) {
+	vec3f_t r;
+	r.x = a.x + b.x; r.y = a.y + b.y; r.z = a.z + b.z;
+	return r;
+}
+
+/**
+ * Multiplie un vecteur flottant de dimension 3 par un scalaire
+ */
+inline vec3f_t Vec3fScale( vec3f_t v, float s ) {
+	vec3f_t r;
+	r.x = v.x * s; r.y = v.y * s; r.z = v.z * s;
+	return r;
+}
+
+/**
+ * Effectue le produit scalaire entre deux vecteurs flottants de dimension 3
+ */
+inline float Vec3fDot( vec3f_t a, vec3f_t b ) {
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+/**
+ * Retourne le minimum composante par composante de deux vecteurs flottants de dimension 3
+ */
+inline vec3f_t Vec3fMin( vec3f_t a, vec3f_t b ) {
+	return Vec3f( MIN( a.x, b.x ), MIN( a.y, b.y ), MIN( a.z, b.z ) );
+}
+
+/**
+ * Retourne le maximum composante par composante de deux vecteurs flottants de dimension 3
+ */
+inline vec3f_t Vec3fMax( vec3f_t a, vec3f_t b ) {
+	return Vec3f( MAX( a.x, b.x ), MAX( a.y, b.y ), MAX( a.z, b.z ) );
+}
+
+/**
+ * Retourne la composante d'un vecteur flottant de dimension 3 selon l'axe (0, 1 ou 2)
+ */
+inline float Vec3fAxis( vec3f_t v, int axis ) {
+	return ( axis == 0 ) ? v.x : ( ( axis == 1 ) ? v.y : v.z );
+}
+
 /**
  * Calcul la longueur d'un vecteur flottant de dimension 3
  */
@@ -177,4 +259,51 @@ inline matrixf_t Vec3f2Matrixf( vec3f_t v ) {
 	return m;
 }
 
+/**
+ * Transforme un point par une matrice flottante 4x4 sans allocation (coordonnes homognes)
+ */
+inline vec4f_t MatrixfTransform( matrixf_t m, vec3f_t v ) {
+	vec4f_t r;
+	r.x = m[ 0 ][ 0 ] * v.x + m[ 0 ][ 1 ] * v.y + m[ 0 ][ 2 ] * v.z + m[ 0 ][ 3 ];
+	r.y = m[ 1 ][ 0 ] * v.x + m[ 1 ][ 1 ] * v.y + m[ 1 ][ 2 ] * v.z + m[ 1 ][ 3 ];
+	r.z = m[ 2 ][ 0 ] * v.x + m[ 2 ][ 1 ] * v.y + m[ 2 ][ 2 ] * v.z + m[ 2 ][ 3 ];
+	r.w = m[ 3 ][ 0 ] * v.x + m[ 3 ][ 1 ] * v.y + m[ 3 ][ 2 ] * v.z + m[ 3 ][ 3 ];
+	return r;
+}
+
+/**
+ * Construit une bote englobante vide
+ */
+inline aabb_t Aabb() {
+	aabb_t b;
+	b.min = Vec3f(  HUGE_VALF,  HUGE_VALF,  HUGE_VALF );
+	b.max = Vec3f( -HUGE_VALF, -HUGE_VALF, -HUGE_VALF );
+	return b;
+}
+
+/**
+ * Agrandit une bote englobante pour contenir un point
+ */
+inline void AabbExtend( aabb_t * b, vec3f_t p ) {
+	b->min = Vec3fMin( b->min, p );
+	b->max = Vec3fMax( b->max, p );
+}
+
+/**
+ * Agrandit une bote englobante pour contenir une autre bote
+ */
+inline void AabbMerge( aabb_t * b, aabb_t o ) {
+	b->min = Vec3fMin( b->min, o.min );
+	b->max = Vec3fMax( b->max, o.max );
+}
+
+/**
+ * Retourne la demi-surface d'une bote englobante (heuristique SAH)
+ */
+inline float AabbHalfArea( aabb_t b ) {
+	vec3f_t e = Vec3fSub( b.max, b.min );
+	if ( e.x < 0.0f ) return 0.0f;
+	return e.x * e.y + e.y * e.z + e.z * e.x;
+}
+
 #endif //__GEOMETRY_H__
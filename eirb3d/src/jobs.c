@@ -0,0 +1,123 @@
+#include "jobs.h"
+
+static SDL_Thread	**	g_threads	= NULL;
+static int			g_nthreads	= 0;
+static SDL_mutex	*	g_mutex		= NULL;
+static SDL_cond		*	g_start		= NULL;
+static SDL_cond		*	g_done		= NULL;
+static int			g_generation	= 0;
+static int			g_active	= 0;
+static bool			g_quit		= false;
+
+// Lot de tâches en cours, les index sont distribués par un compteur atomique
+static jobfunc_t		g_func		= NULL;
+static void		*	g_data		= NULL;
+static int			g_count		= 0;
+static SDL_atomic_t		g_next;
+
+static void JobsDrain() {
+	int i;
+	while ( ( i = SDL_AtomicAdd( &g_next, 1 ) ) < g_count ) {
+		g_func( g_data, i );
+	}
+}
+
+static int JobsWorker( void * data ) {
+	(void)data;
+	int seen = 0;
+	SDL_LockMutex( g_mutex );
+	for ( ;; ) {
+		while ( !g_quit && g_generation == seen ) {
+			SDL_CondWait( g_start, g_mutex );
+		}
+		if ( g_quit ) {
+			break;
+		}
+		seen = g_generation;
+		SDL_UnlockMutex( g_mutex );
+		JobsDrain();
+		SDL_LockMutex( g_mutex );
+		if ( --g_active == 0 ) {
+			SDL_CondSignal( g_done );
+		}
+	}
+	SDL_UnlockMutex( g_mutex );
+	return 0;
+}
+
+void JobsInit( int nthreads ) {
+	if ( g_mutex != NULL ) {
+		return;
+	}
+	if ( nthreads <= 0 ) {
+		nthreads = SDL_GetCPUCount() - 1;
+	}
+	g_mutex   = SDL_CreateMutex();
+	g_start   = SDL_CreateCond();
+	g_done    = SDL_CreateCond();
+	g_quit    = false;
+	g_threads = (SDL_Thread**)malloc( sizeof( SDL_Thread* ) * ( nthreads > 0 ? nthreads : 1 ) );
+	g_nthreads = 0;
+	for ( int i = 0; i < nthreads; i++ ) {
+		SDL_Thread * t = SDL_CreateThread( JobsWorker, "jobs", NULL );
+		if ( t == NULL ) {
+			SDL_LogError( SDL_LOG_CATEGORY_APPLICATION, "Couldn't create worker thread: %s\n", SDL_GetError() );
+			break;
+		}
+		g_threads[ g_nthreads++ ] = t;
+	}
+}
+
+void JobsRun( jobfunc_t func, void * data, int count ) {
+	if ( g_mutex == NULL ) {
+		JobsInit( 0 );
+	}
+	if ( g_nthreads == 0 || count <= 1 ) {
+		for ( int i = 0; i < count; i++ ) {
+			func( data, i );
+		}
+		return;
+	}
+	SDL_LockMutex( g_mutex );
+	g_func   = func;
+	g_data   = data;
+	g_count  = count;
+	g_active = g_nthreads;
+	SDL_AtomicSet( &g_next, 0 );
+	g_generation++;
+	SDL_CondBroadcast( g_start );
+	SDL_UnlockMutex( g_mutex );
+
+	// Le thread appelant participe au lot au lieu d'attendre
+	JobsDrain();
+
+	SDL_LockMutex( g_mutex );
+	while ( g_active > 0 ) {
+		SDL_CondWait( g_done, g_mutex );
+	}
+	SDL_UnlockMutex( g_mutex );
+}
+
+int JobsCount() {
+	return g_nthreads + 1;
+}
+
+void JobsQuit() {
+	if ( g_mutex == NULL ) {
+		return;
+	}
+	SDL_LockMutex( g_mutex );
+	g_quit = true;
+	SDL_CondBroadcast( g_start );
+	SDL_UnlockMutex( g_mutex );
+	for ( int i = 0; i < g_nthreads; i++ ) {
+		SDL_WaitThread( g_threads[ i ], NULL );
+	}
+	free( g_threads );
+	SDL_DestroyCond( g_start );
+	SDL_DestroyCond( g_done );
+	SDL_DestroyMutex( g_mutex );
+	g_threads  = NULL;
+	g_nthreads = 0;
+	g_mutex    = NULL;
+}
@@ -0,0 +1,42 @@
+#ifndef __JOBS_H__
+#define __JOBS_H__
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include "SDL2/SDL.h"
+
+/**
+ * Dfinition des types
+ */
+
+/**
+ * Tche excute pour chaque index de 0  count - 1
+ */
+typedef void ( *jobfunc_t )( void * data, int index );
+
+/**
+ * Dfinition des prototypes de fonctions
+ */
+
+/**
+ * Dmarre les threads de travail (nthreads <= 0 : un par coeur, moins le thread appelant)
+ */
+void			JobsInit		( int nthreads );
+
+/**
+ * Excute func pour count index rpartis entre les threads et le thread appelant,
+ * et retourne quand tous sont traits. Ne doit pas tre appele depuis une tche.
+ */
+void			JobsRun			( jobfunc_t func, void * data, int count );
+
+/**
+ * Retourne le nombre de threads participant aux tches, thread appelant compris
+ */
+int			JobsCount		();
+
+/**
+ * Arrte les threads de travail
+ */
+void			JobsQuit		();
+
+#endif //__JOBS_H__
@@ -0,0 +1,110 @@
+#include "latency.h"
+
+// Largeur des groupes de l'histogramme affiché, en millisecondes
+#define LATENCY_GROUP	5
+
+/**
+ * Compte une trame présentée maintenant, si elle tenait compte d'un évènement
+ */
+static void LatencyRecord( latency_t * l, const latencyframe_t * f, Uint32 now ) {
+	if ( f->input == 0 ) {
+		return;
+	}
+	Uint32 total = now - f->input;
+	l->histogram[ MIN( total, (Uint32)( LATENCY_BUCKETS - 1 ) ) ]++;
+	l->count++;
+	l->queued += f->sampled - f->input;
+	l->pipeline += now - f->sampled;
+}
+
+/**
+ * Plus petite latence atteinte ou dépassée par la fraction donnée des trames mesurées
+ */
+static int LatencyPercentile( latency_t * l, float fraction ) {
+	int sum = 0;
+	for ( int i = 0; i < LATENCY_BUCKETS; i++ ) {
+		sum += l->histogram[ i ];
+		if ( sum >= fraction * l->count ) {
+			return i;
+		}
+	}
+	return LATENCY_BUCKETS - 1;
+}
+
+latency_t Latency() {
+	latency_t l;
+	memset( &l, 0, sizeof( l ) );
+	return l;
+}
+
+bool LatencyWait( latency_t * l, window_t * w ) {
+	if ( w->present != WINDOW_PRESENT_LOWLATENCY || l->presented == 0 ) {
+		return false;
+	}
+	Uint64 frequency = SDL_GetPerformanceFrequency();
+	Uint64 interval = frequency / w->refresh;
+	Uint64 now = SDL_GetPerformanceCounter();
+
+	// Prochaine synchronisation, comptée depuis la dernière présentation qui l'attendait
+	Uint64 next = l->presented + ( ( now - l->presented ) / interval + 1 ) * interval;
+	Uint64 needed = (Uint64)( ( l->render + LATENCY_MARGIN ) * frequency / 1000.0f );
+	if ( next <= now + needed ) {
+		return false;
+	}
+	SDL_Delay( (Uint32)( ( next - needed - now ) * 1000 / frequency ) );
+	return true;
+}
+
+void LatencySample( latency_t * l ) {
+	l->sampleticks = SDL_GetTicks();
+	l->samplecounter = SDL_GetPerformanceCounter();
+}
+
+void LatencyDrawn( latency_t * l, Uint32 input ) {
+	l->drawn.input = input;
+	l->drawn.sampled = l->sampleticks;
+
+	// La prévision suit aussitôt une trame plus longue, et ne redescend que progressivement
+	float ms = (float)( SDL_GetPerformanceCounter() - l->samplecounter ) * 1000.0f / SDL_GetPerformanceFrequency();
+	l->render = ( ms > l->render ) ? ms : l->render + ( ms - l->render ) * LATENCY_SMOOTHING;
+}
+
+void LatencyPresented( latency_t * l, bool latest ) {
+	Uint32 now = SDL_GetTicks();
+	l->presented = SDL_GetPerformanceCounter();
+	LatencyRecord( l, &l->waiting, now );
+	if ( latest ) {
+		LatencyRecord( l, &l->drawn, now );
+		l->waiting.input = 0;
+	}else {
+		l->waiting = l->drawn;
+	}
+	l->drawn.input = 0;
+}
+
+void LatencyReport( latency_t * l ) {
+	if ( l->count == 0 ) {
+		return;
+	}
+	int max = LatencyPercentile( l, 1.0f );
+	printf( "(II) Latency: %d ms median, %d ms p90, %d ms p99, %s%d ms max over %d frames (%.1f ms to sampling, %.1f ms from sampling to present)\n",
+		LatencyPercentile( l, 0.5f ), LatencyPercentile( l, 0.9f ), LatencyPercentile( l, 0.99f ), ( max == LATENCY_BUCKETS - 1 ) ? ">= " : "", max, l->count, l->queued / l->count, l->pipeline / l->count );
+
+	printf( "(II) Latency histogram:" );
+	const char * separator = " ";
+	for ( int i = 0; i < LATENCY_BUCKETS; i += LATENCY_GROUP ) {
+		int n = 0;
+		for ( int j = i; j < MIN( i + LATENCY_GROUP, LATENCY_BUCKETS ); j++ ) {
+			n += l->histogram[ j ];
+		}
+		if ( n > 0 ) {
+			printf( "%s%d-%d ms: %d", separator, i, i + LATENCY_GROUP - 1, n );
+			separator = ", ";
+		}
+	}
+	printf( "\n" );
+
+	memset( l->histogram, 0, sizeof( l->histogram ) );
+	l->count = 0;
+	l->queued = l->pipeline = 0.0;
+}
@@ -0,0 +1,94 @@
+#ifndef __LATENCY_H__
+#define __LATENCY_H__
+
+#include <stdbool.h>
+#include "SDL2/SDL.h"
+#include "window.h"
+
+/**
+ * Histogramme des latences, par millisecondes : la dernire case reoit toutes les
+ * latences plus longues
+ */
+#define LATENCY_BUCKETS		100
+
+/**
+ * Marge laisse avant la synchronisation verticale quand l'chantillonnage des
+ * vnements est retard, en millisecondes
+ */
+#define LATENCY_MARGIN		2.0f
+
+/**
+ * Poids de la dernire trame dans la dure de dessin prvue
+ */
+#define LATENCY_SMOOTHING	0.1f
+
+/**
+ * Dfinition des types
+ */
+
+/**
+ * Trame dessine mais pas encore prsente
+ */
+typedef struct latencyframe {
+	Uint32			input;		// Horodatage SDL du premier vnement pris en compte, 0 sinon
+	Uint32			sampled;	// Instant o la camra a t chantillonne (SDL_GetTicks)
+}latencyframe_t;
+
+/**
+ * Mesure de la latence entre un vnement et la prsentation de la premire trame qui
+ * en tient compte, dcompose en attente avant l'chantillonnage puis dessin, copie et
+ * prsentation
+ */
+typedef struct latency {
+	Uint32			sampleticks;	// Dernier chantillonnage, en millisecondes
+	Uint64			samplecounter;	// Le mme, au compteur haute prcision
+	latencyframe_t		drawn;		// Trame tout juste dessine
+	latencyframe_t		waiting;	// Trame copie en attente de la prsentation suivante
+	Uint64			presented;	// Dernire prsentation (SDL_GetPerformanceCounter), 0 avant la premire
+	float			render;		// Dure prvue de l'chantillonnage  la copie, en millisecondes
+	int			histogram[ LATENCY_BUCKETS ];
+	int			count;		// Trames mesures
+	double			queued;		// Cumul des attentes de l'vnement  l'chantillonnage
+	double			pipeline;	// Cumul des dures de l'chantillonnage  la prsentation
+}latency_t;
+
+/**
+ * Dfinition des prototypes de fonctions
+ */
+
+/**
+ * Mesure vide
+ */
+latency_t			Latency			();
+
+/**
+ * En mode WINDOW_PRESENT_LOWLATENCY, dort jusqu'au dernier moment qui laisse encore le
+ * temps de dessiner la trame avant la prochaine synchronisation verticale, et retourne
+ * vrai : les vnements relevs ensuite sont les plus rcents possibles. Sans effet dans
+ * les autres modes, ou s'il est dj trop tard.
+ */
+bool				LatencyWait		( latency_t * l, window_t * w );
+
+/**
+ * Note l'instant o les vnements sont chantillonns pour la trame  dessiner
+ */
+void				LatencySample		( latency_t * l );
+
+/**
+ * Une trame vient d'tre dessine avec les vnements reus depuis input (0 s'il n'y en a
+ * pas), juste avant sa copie vers la fentre
+ */
+void				LatencyDrawn		( latency_t * l, Uint32 input );
+
+/**
+ * A appeler juste aprs chaque prsentation : mesure la trame en attente et, si latest
+ * est vrai, la trame tout juste dessine ; sinon celle-ci attend la prsentation suivante
+ */
+void				LatencyPresented	( latency_t * l, bool latest );
+
+/**
+ * Affiche la distribution des latences mesures depuis l'appel prcdent et la remet  zro
+ */
+void				LatencyReport		( latency_t * l );
+
+#endif //__LATENCY_H__
@@ -0,0 +1,32 @@
+#include "light.h"
+#include <stdio.h>
+
+light_t Light( vec3f_t direction, vec3f_t view, vec3f_t color ) {
+	light_t l;
+	l.direction = Vec3fNormalize( direction );
+	l.half      = Vec3fNormalize( Vec3fAdd( l.direction, Vec3fNormalize( view ) ) );
+	l.color     = color;
+	l.ambient   = 0.1f;
+	l.diffuse   = 0.7f;
+	l.specular  = 0.4f;
+	return l;
+}
+
+pointlight_t * LightScatter( int count, vec3f_t center, float radius, float range ) {
+	pointlight_t * lights = (pointlight_t*)malloc( sizeof( pointlight_t ) * count );
+	if ( lights == NULL ) {
+		printf( "(EE) Unable to allocate %d point lights\n", count );
+		return NULL;
+	}
+	// Spirale de Fibonacci : points répartis uniformément sur la sphère
+	float golden = (float)M_PI * ( 3.0f - sqrtf( 5.0f ) );
+	for ( int i = 0; i < count; i++ ) {
+		float y = 1.0f - 2.0f * ( i + 0.5f ) / count;
+		float r = sqrtf( 1.0f - y * y );
+		float a = golden * i;
+		lights[ i ].position = Vec3fAdd( center, Vec3fScale( Vec3f( r * cosf( a ), y, r * sinf( a ) ), radius ) );
+		lights[ i ].color    = Vec3f( 0.5f + 0.5f * cosf( a ), 0.5f + 0.5f * cosf( a + 2.094f ), 0.5f + 0.5f * cosf( a + 4.189f ) );
+		lights[ i ].radius   = range;
+	}
+	return lights;
+}
@@ -0,0 +1,115 @@
+#ifndef __LIGHT_H__
+#define __LIGHT_H__
+
+#include "geometry.h"
+
+#if defined( __SSE2__ )
+#include <emmintrin.h>
+#endif
+
+/**
+ * Exposant spculaire obtenu par lvations au carr successives : 2^5 = 32
+ */
+#define LIGHT_SHININESS_SQUARINGS	5
+
+/**
+ * Dfinition des types
+ */
+
+/**
+ * Lumire directionnelle (Blinn-Phong, observateur  l'infini : le vecteur
+ * demi-angle est le mme pour tous les points de la scne)
+ */
+typedef struct light {
+	vec3f_t			direction;
+	vec3f_t			half;
+	vec3f_t			color;
+	float			ambient;
+	float			diffuse;
+	float			specular;
+}light_t;
+
+/**
+ * Lumire ponctuelle dont l'influence s'annule  la distance radius
+ */
+typedef struct pointlight {
+	vec3f_t			position;
+	vec3f_t			color;
+	float			radius;
+}pointlight_t;
+
+/**
+ * Dfinition des prototypes de fonctions
+ */
+
+/**
+ * Construit une lumire directionnelle venant de direction, vue depuis la direction view
+ */
+light_t			Light			( vec3f_t direction, vec3f_t view, vec3f_t color );
+
+/**
+ * Rpartit count lumires ponctuelles colores sur une spirale autour d'une sphre (scne de test).
+ * Retourne NULL si l'allocation choue
+ */
+pointlight_t		*	LightScatter		( int count, vec3f_t center, float radius, float range );
+
+/**
+ * Elve un cosinus  la puissance spculaire
+ */
+inline float LightSpecularPower( float x ) {
+	for ( int i = 0; i < LIGHT_SHININESS_SQUARINGS; i++ ) {
+		x *= x;
+	}
+	return x;
+}
+
+/**
+ * Calcule la couleur (composantes dans [0,255]) d'un point de normale n, pas forcment
+ * unitaire, dont visibility est la part de lumire reue (ombres)
+ */
+inline vec3f_t LightShadeVisible( const light_t * l, vec3f_t n, float visibility ) {
+	float len = Vec3fLength( n );
+	float inv = ( len > 0.0f ) ? 1.0f / len : 0.0f;
+	float ndl = MAX( Vec3fDot( n, l->direction ) * inv, 0.0f );
+	float ndh = MAX( Vec3fDot( n, l->half ) * inv, 0.0f );
+	float i = 255.0f * ( l->ambient + visibility * ( l->diffuse * ndl + l->specular * LightSpecularPower( ndh ) ) );
+	return Vec3f( MIN( l->color.x * i, 255.0f ), MIN( l->color.y * i, 255.0f ), MIN( l->color.z * i, 255.0f ) );
+}
+
+/**
+ * Calcule la couleur (composantes dans [0,255]) d'un point de normale n, pas forcment unitaire
+ */
+inline vec3f_t LightShade( const light_t * l, vec3f_t n ) {
+	return LightShadeVisible( l, n, 1.0f );
+}
+
+#if defined( __SSE2__ )
+/**
+ * Calcule les couleurs de quatre points  partir de leurs normales, pas forcment
+ * unitaires, et les retourne au format du framebuffer
+ */
+inline __m128i LightShade4( const light_t * l, __m128 nx, __m128 ny, __m128 nz ) {
+	__m128 zero = _mm_setzero_ps();
+	__m128 len2 = _mm_add_ps( _mm_add_ps( _mm_mul_ps( nx, nx ), _mm_mul_ps( ny, ny ) ), _mm_mul_ps( nz, nz ) );
+	// Inverse de la norme approche, affine par une itration de Newton
+	__m128 inv = _mm_rsqrt_ps( len2 );
+	inv = _mm_mul_ps( _mm_mul_ps( _mm_set1_ps( 0.5f ), inv ), _mm_sub_ps( _mm_set1_ps( 3.0f ), _mm_mul_ps( len2, _mm_mul_ps( inv, inv ) ) ) );
+	__m128 ndl = _mm_add_ps( _mm_add_ps( _mm_mul_ps( nx, _mm_set1_ps( l->direction.x ) ), _mm_mul_ps( ny, _mm_set1_ps( l->direction.y ) ) ), _mm_mul_ps( nz, _mm_set1_ps( l->direction.z ) ) );
+	__m128 ndh = _mm_add_ps( _mm_add_ps( _mm_mul_ps( nx, _mm_set1_ps( l->half.x ) ), _mm_mul_ps( ny, _mm_set1_ps( l->half.y ) ) ), _mm_mul_ps( nz, _mm_set1_ps( l->half.z ) ) );
+	ndl = _mm_max_ps( _mm_mul_ps( ndl, inv ), zero );
+	ndh = _mm_max_ps( _mm_mul_ps( ndh, inv ), zero );
+	for ( int i = 0; i < LIGHT_SHININESS_SQUARINGS; i++ ) {
+		ndh = _mm_mul_ps( ndh, ndh );
+	}
+	__m128 i = _mm_add_ps( _mm_set1_ps( l->ambient ), _mm_add_ps( _mm_mul_ps( _mm_set1_ps( l->diffuse ), ndl ), _mm_mul_ps( _mm_set1_ps( l->specular ), ndh ) ) );
+	i = _mm_mul_ps( i, _mm_set1_ps( 255.0f ) );
+	__m128 max = _mm_set1_ps( 255.0f );
+	__m128i r = _mm_cvttps_epi32( _mm_min_ps( _mm_mul_ps( i, _mm_set1_ps( l->color.x ) ), max ) );
+	__m128i g = _mm_cvttps_epi32( _mm_min_ps( _mm_mul_ps( i, _mm_set1_ps( l->color.y ) ), max ) );
+	__m128i b = _mm_cvttps_epi32( _mm_min_ps( _mm_mul_ps( i, _mm_set1_ps( l->color.z ) ), max ) );
+	__m128i argb = _mm_or_si128( _mm_slli_epi32( r, 16 ), _mm_or_si128( _mm_slli_epi32( g, 8 ), b ) );
+	return _mm_or_si128( argb, _mm_set1_epi32( 0xFF << 24 ) );
+}
+#endif
+
+#endif //__LIGHT_H__
@@ -0,0 +1,486 @@
+#include <stdio.h>
+#include <string.h>
+#include "lod.h"
+#include "jobs.h"
+
+// Passes de contractions au plus : chaque passe contracte des arêtes sans position commune
+#define LOD_PASSES		32
+
+// Cosinus minimal entre la normale d'un triangle avant et après une contraction
+#define LOD_FLIP		0.25f
+
+// Sommets au plus à une même position, au-delà elle n'est pas contractée
+#define LOD_WEDGES		8
+
+/**
+ * Quadrique d'erreur symétrique : somme des carrés des distances aux plans
+ * ax + by + cz + d = 0 des triangles voisins, pondérés par leur aire, coefficients
+ * a², ab, ac, ad, b², bc, bd, c², cd, d², puis somme des poids
+ */
+typedef struct lodquadric {
+	double			q[ 11 ];
+}lodquadric_t;
+
+/**
+ * Contraction candidate de l'arête from -> to
+ */
+typedef struct lodcollapse {
+	double			cost;
+	int			from;
+	int			to;
+}lodcollapse_t;
+
+/**
+ * Etat de la simplification partagé avec les tâches d'évaluation des contractions.
+ * Les sommets de même position (coins d'une couture de normales ou de texture) sont
+ * contractés ensemble : quadriques et verrous sont par position.
+ */
+typedef struct lodstate {
+	const mesh_t	*	mesh;
+	const clusters_t *	clusters;
+	int		*	tris;		// Sommets des triangles, modifiés par les contractions
+	bool		*	alive;
+	int		*	pos;		// Position de chaque sommet
+	unsigned char	*	locked;		// Positions fixes (bords ouverts, arêtes non manifold)
+	lodquadric_t	*	quadrics;	// Par position
+	lodcollapse_t	*	candidates;	// Une contraction candidate par coin, coût HUGE_VAL sinon
+}lodstate_t;
+
+static void LodQuadricAdd( lodquadric_t * a, const lodquadric_t * b ) {
+	for ( int i = 0; i < 11; i++ ) {
+		a->q[ i ] += b->q[ i ];
+	}
+}
+
+/**
+ * Ajoute le plan du triangle aux quadriques de ses trois positions, ignoré s'il est dégénéré
+ */
+static void LodQuadricTriangle( lodquadric_t * q, const vertex_t * v, const int * pos, const int * c ) {
+	vec3f_t p0 = v[ c[ 0 ] ].pos;
+	vec3f_t n = Vec3fCross( Vec3fSub( v[ c[ 1 ] ].pos, p0 ), Vec3fSub( v[ c[ 2 ] ].pos, p0 ) );
+	double l = Vec3fLength( n );
+	if ( l <= 0.0 ) {
+		return;
+	}
+	double a = n.x / l, b = n.y / l, d = n.z / l;
+	double e = -( a * p0.x + b * p0.y + d * p0.z );
+	double w = 0.5 * l;
+	lodquadric_t p = { { w * a * a, w * a * b, w * a * d, w * a * e, w * b * b, w * b * d, w * b * e, w * d * d, w * d * e, w * e * e, w } };
+	for ( int j = 0; j < 3; j++ ) {
+		LodQuadricAdd( &q[ pos[ c[ j ] ] ], &p );
+	}
+}
+
+/**
+ * Carré de la distance moyenne de p aux plans de la quadrique
+ */
+static double LodQuadricError( const lodquadric_t * a, vec3f_t p ) {
+	const double * q = a->q;
+	double x = p.x, y = p.y, z = p.z;
+	double e = q[ 0 ] * x * x + 2.0 * q[ 1 ] * x * y + 2.0 * q[ 2 ] * x * z + 2.0 * q[ 3 ] * x
+		+ q[ 4 ] * y * y + 2.0 * q[ 5 ] * y * z + 2.0 * q[ 6 ] * y
+		+ q[ 7 ] * z * z + 2.0 * q[ 8 ] * z + q[ 9 ];
+	return ( q[ 10 ] > 0.0 ) ? MAX( e, 0.0 ) / q[ 10 ] : 0.0;
+}
+
+static int LodCompareCollapse( const void * a, const void * b ) {
+	double ca = ( (const lodcollapse_t*)a )->cost, cb = ( (const lodcollapse_t*)b )->cost;
+	return ( ca > cb ) - ( ca < cb );
+}
+
+static int LodCompareEdge( const void * a, const void * b ) {
+	const int * ea = (const int*)a, * eb = (const int*)b;
+	return ( ea[ 0 ] != eb[ 0 ] ) ? ea[ 0 ] - eb[ 0 ] : ea[ 1 ] - eb[ 1 ];
+}
+
+/**
+ * Evalue les arêtes des triangles d'un groupe : contraction de la position la moins
+ * coûteuse vers l'autre, chaque coin écrivant dans sa propre case
+ */
+static void LodEvaluateCluster( void * data, int index ) {
+	lodstate_t * s = (lodstate_t*)data;
+	const cluster_t * cluster = &s->clusters->data[ index ];
+	const vertex_t * v = s->mesh->vertices;
+	for ( int i = cluster->offset; i < cluster->offset + cluster->count; i++ ) {
+		int t = s->clusters->faces[ i ];
+		for ( int j = 0; j < 3; j++ ) {
+			lodcollapse_t * c = &s->candidates[ t * 3 + j ];
+			c->cost = HUGE_VAL;
+			if ( !s->alive[ t ] ) {
+				continue;
+			}
+			int ua = s->tris[ t * 3 + j ], ub = s->tris[ t * 3 + ( j + 1 ) % 3 ];
+			int a = s->pos[ ua ], b = s->pos[ ub ];
+			// Chaque arête intérieure est vue par ses deux triangles : un seul sens suffit
+			if ( a >= b ) {
+				continue;
+			}
+			lodquadric_t q = s->quadrics[ a ];
+			LodQuadricAdd( &q, &s->quadrics[ b ] );
+			double ab = s->locked[ a ] ? HUGE_VAL : LodQuadricError( &q, v[ ub ].pos );
+			double ba = s->locked[ b ] ? HUGE_VAL : LodQuadricError( &q, v[ ua ].pos );
+			c->cost = MIN( ab, ba );
+			c->from = ( ab <= ba ) ? a : b;
+			c->to   = ( ab <= ba ) ? b : a;
+		}
+	}
+}
+
+/**
+ * Associe chaque sommet de la position from au sommet de la position to qu'il touche par
+ * l'arête contractée. Retourne faux si un sommet n'en touche aucun ou plusieurs différents
+ * (la couture serait déchirée), ou si un triangle restant se retourne.
+ */
+static bool LodCollapseMap( lodstate_t * s, const int * adjacent, int count, int from, int to, int * wedges, int * targets, int * nwedges ) {
+	const vertex_t * v = s->mesh->vertices;
+	vec3f_t moved = Vec3f( 0.0f, 0.0f, 0.0f );
+	*nwedges = 0;
+	for ( int i = 0; i < count; i++ ) {
+		int t = adjacent[ i ];
+		const int * c = &s->tris[ t * 3 ];
+		if ( !s->alive[ t ] ) {
+			continue;
+		}
+		int target = -1;
+		for ( int j = 0; j < 3; j++ ) {
+			if ( s->pos[ c[ j ] ] == to ) {
+				target = c[ j ];
+				moved = v[ target ].pos;
+			}
+		}
+		for ( int j = 0; j < 3; j++ ) {
+			if ( s->pos[ c[ j ] ] != from ) {
+				continue;
+			}
+			int k = 0;
+			while ( k < *nwedges && wedges[ k ] != c[ j ] ) {
+				k++;
+			}
+			if ( k == *nwedges ) {
+				if ( k == LOD_WEDGES ) {
+					return false;
+				}
+				wedges[ k ] = c[ j ];
+				targets[ k ] = -1;
+				( *nwedges )++;
+			}
+			if ( target >= 0 ) {
+				if ( targets[ k ] >= 0 && targets[ k ] != target ) {
+					return false;
+				}
+				targets[ k ] = target;
+			}
+		}
+	}
+	for ( int k = 0; k < *nwedges; k++ ) {
+		if ( targets[ k ] < 0 ) {
+			return false;
+		}
+	}
+
+	// Triangles déplacés sans disparaître : aucun ne doit se retourner ni s'écraser
+	for ( int i = 0; i < count; i++ ) {
+		int t = adjacent[ i ];
+		const int * c = &s->tris[ t * 3 ];
+		if ( !s->alive[ t ] || s->pos[ c[ 0 ] ] == to || s->pos[ c[ 1 ] ] == to || s->pos[ c[ 2 ] ] == to ) {
+			continue;
+		}
+		vec3f_t p[ 3 ], r[ 3 ];
+		for ( int j = 0; j < 3; j++ ) {
+			p[ j ] = v[ c[ j ] ].pos;
+			r[ j ] = ( s->pos[ c[ j ] ] == from ) ? moved : p[ j ];
+		}
+		vec3f_t n0 = Vec3fCross( Vec3fSub( p[ 1 ], p[ 0 ] ), Vec3fSub( p[ 2 ], p[ 0 ] ) );
+		vec3f_t n1 = Vec3fCross( Vec3fSub( r[ 1 ], r[ 0 ] ), Vec3fSub( r[ 2 ], r[ 0 ] ) );
+		if ( Vec3fDot( n0, n1 ) <= LOD_FLIP * Vec3fLength( n0 ) * Vec3fLength( n1 ) ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+mesh_t * LodSimplify( const mesh_t * m, const clusters_t * c, float ratio, float * error ) {
+	if ( c == NULL ) {
+		return NULL;
+	}
+	int nv = m->nvertices;
+	int nt = m->nindices / 3;
+	int size = 1;
+	while ( size < nv * 2 ) {
+		size <<= 1;
+	}
+	lodstate_t s;
+	s.mesh       = m;
+	s.clusters   = c;
+	s.tris       = (int*)malloc( sizeof( int ) * nt * 3 );
+	s.alive      = (bool*)malloc( sizeof( bool ) * nt );
+	s.pos        = (int*)malloc( sizeof( int ) * nv );
+	s.locked     = (unsigned char*)calloc( nv, 1 );
+	s.quadrics   = (lodquadric_t*)calloc( nv, sizeof( lodquadric_t ) );
+	s.candidates = (lodcollapse_t*)malloc( sizeof( lodcollapse_t ) * nt * 3 );
+	int * table  = (int*)malloc( sizeof( int ) * MAX( size, nt * 6 ) );
+	int * start  = (int*)malloc( sizeof( int ) * ( nv + 1 ) );
+	int * adjacent = (int*)malloc( sizeof( int ) * nt * 3 );
+	bool * touched = (bool*)malloc( sizeof( bool ) * nv );
+	mesh_t * r   = (mesh_t*)malloc( sizeof( mesh_t ) );
+	if ( s.tris == NULL || s.alive == NULL || s.pos == NULL || s.locked == NULL || s.quadrics == NULL || s.candidates == NULL
+		|| table == NULL || start == NULL || adjacent == NULL || touched == NULL || r == NULL ) {
+		printf( "(EE) Unable to allocate simplified mesh\n" );
+		free( s.tris ); free( s.alive ); free( s.pos ); free( s.locked ); free( s.quadrics ); free( s.candidates );
+		free( table ); free( start ); free( adjacent ); free( touched ); free( r );
+		return NULL;
+	}
+	for ( int i = 0; i < nt * 3; i++ ) {
+		s.tris[ i ] = MeshIndex( m, i );
+	}
+	for ( int t = 0; t < nt; t++ ) {
+		s.alive[ t ] = true;
+	}
+
+	// Positions : sommets de mêmes coordonnées soudés, le premier donnant son index
+	memset( table, -1, sizeof( int ) * size );
+	for ( int i = 0; i < nv; i++ ) {
+		vec3f_t p = m->vertices[ i ].pos;
+		Uint32 bits[ 3 ];
+		memcpy( bits, &p, sizeof( bits ) );
+		unsigned int h = ( bits[ 0 ] * 73856093u ^ bits[ 1 ] * 19349663u ^ bits[ 2 ] * 83492791u ) & ( size - 1 );
+		while ( table[ h ] >= 0 && memcmp( &m->vertices[ table[ h ] ].pos, &p, sizeof( vec3f_t ) ) != 0 ) {
+			h = ( h + 1 ) & ( size - 1 );
+		}
+		if ( table[ h ] < 0 ) {
+			table[ h ] = i;
+		}
+		s.pos[ i ] = table[ h ];
+	}
+
+	// Arêtes d'un seul triangle (bord ouvert) ou de plus de deux : leurs positions restent fixes
+	int * edges = table;
+	for ( int i = 0; i < nt * 3; i++ ) {
+		int a = s.pos[ s.tris[ i ] ], b = s.pos[ s.tris[ i - i % 3 + ( i + 1 ) % 3 ] ];
+		edges[ i * 2 ]     = MIN( a, b );
+		edges[ i * 2 + 1 ] = MAX( a, b );
+	}
+	qsort( edges, nt * 3, sizeof( int ) * 2, LodCompareEdge );
+	for ( int i = 0; i < nt * 3; ) {
+		int j = i + 1;
+		while ( j < nt * 3 && LodCompareEdge( &edges[ i * 2 ], &edges[ j * 2 ] ) == 0 ) {
+			j++;
+		}
+		if ( j - i != 2 ) {
+			s.locked[ edges[ i * 2 ] ] = s.locked[ edges[ i * 2 + 1 ] ] = 1;
+		}
+		i = j;
+	}
+
+	for ( int t = 0; t < nt; t++ ) {
+		LodQuadricTriangle( s.quadrics, m->vertices, s.pos, &s.tris[ t * 3 ] );
+	}
+
+	// Passes successives : coûts évalués en parallèle par groupe, puis arêtes contractées
+	// par coût croissant tant que leurs deux positions sont intactes dans la passe
+	int target = MAX( (int)ceilf( nt * ratio ), 1 );
+	int remaining = nt;
+	double worst = 0.0;
+	for ( int pass = 0; pass < LOD_PASSES && remaining > target; pass++ ) {
+		JobsRun( LodEvaluateCluster, &s, c->count );
+		int ncandidates = 0;
+		for ( int i = 0; i < nt * 3; i++ ) {
+			if ( s.candidates[ i ].cost != HUGE_VAL ) {
+				s.candidates[ ncandidates++ ] = s.candidates[ i ];
+			}
+		}
+		qsort( s.candidates, ncandidates, sizeof( lodcollapse_t ), LodCompareCollapse );
+
+		// Triangles vivants autour de chaque position
+		memset( start, 0, sizeof( int ) * ( nv + 1 ) );
+		for ( int i = 0; i < nt * 3; i++ ) {
+			if ( s.alive[ i / 3 ] ) {
+				start[ s.pos[ s.tris[ i ] ] + 1 ]++;
+			}
+		}
+		for ( int i = 0; i < nv; i++ ) {
+			start[ i + 1 ] += start[ i ];
+		}
+		for ( int i = 0; i < nt * 3; i++ ) {
+			if ( s.alive[ i / 3 ] ) {
+				adjacent[ start[ s.pos[ s.tris[ i ] ] ]++ ] = i / 3;
+			}
+		}
+		for ( int i = nv; i > 0; i-- ) {
+			start[ i ] = start[ i - 1 ];
+		}
+		start[ 0 ] = 0;
+
+		memset( touched, 0, sizeof( bool ) * nv );
+		int collapsed = 0;
+		for ( int i = 0; i < ncandidates && remaining > target; i++ ) {
+			lodcollapse_t * e = &s.candidates[ i ];
+			int wedges[ LOD_WEDGES ], targets[ LOD_WEDGES ], nwedges;
+			const int * around = &adjacent[ start[ e->from ] ];
+			int count = start[ e->from + 1 ] - start[ e->from ];
+			if ( touched[ e->from ] || touched[ e->to ] || !LodCollapseMap( &s, around, count, e->from, e->to, wedges, targets, &nwedges ) ) {
+				continue;
+			}
+			for ( int k = 0; k < count; k++ ) {
+				int t = around[ k ];
+				int * v = &s.tris[ t * 3 ];
+				if ( !s.alive[ t ] ) {
+					continue;
+				}
+				// Les triangles de l'arête disparaissent, les autres passent aux sommets associés
+				if ( s.pos[ v[ 0 ] ] == e->to || s.pos[ v[ 1 ] ] == e->to || s.pos[ v[ 2 ] ] == e->to ) {
+					s.alive[ t ] = false;
+					remaining--;
+					continue;
+				}
+				for ( int j = 0; j < 3; j++ ) {
+					for ( int w = 0; w < nwedges; w++ ) {
+						if ( v[ j ] == wedges[ w ] ) {
+							v[ j ] = targets[ w ];
+							break;
+						}
+					}
+				}
+			}
+			LodQuadricAdd( &s.quadrics[ e->to ], &s.quadrics[ e->from ] );
+			touched[ e->from ] = touched[ e->to ] = true;
+			worst = MAX( worst, e->cost );
+			collapsed++;
+		}
+		if ( collapsed == 0 ) {
+			break;
+		}
+	}
+
+	// Triangles gardés rassemblés, sommets inutilisés retirés
+	int * remap = start;
+	for ( int i = 0; i < nv; i++ ) {
+		remap[ i ] = -1;
+	}
+	int kept = 0, nunique = 0;
+	for ( int t = 0; t < nt; t++ ) {
+		if ( !s.alive[ t ] ) {
+			continue;
+		}
+		for ( int j = 0; j < 3; j++ ) {
+			int v = s.tris[ t * 3 + j ];
+			if ( remap[ v ] < 0 ) {
+				remap[ v ] = nunique++;
+			}
+			s.tris[ kept * 3 + j ] = v;
+		}
+		kept++;
+	}
+	r->nvertices = nunique;
+	r->vertices  = (vertex_t*)malloc( sizeof( vertex_t ) * MAX( nunique, 1 ) );
+	r->nindices  = kept * 3;
+	r->indexsize = ( nunique <= 65536 ) ? 2 : 4;
+	r->indices   = malloc( r->indexsize * MAX( kept * 3, 1 ) );
+	if ( r->vertices == NULL || r->indices == NULL ) {
+		printf( "(EE) Unable to allocate simplified mesh\n" );
+		MeshDelete( r );
+		r = NULL;
+	}else {
+		for ( int i = 0; i < nv; i++ ) {
+			if ( remap[ i ] >= 0 ) {
+				r->vertices[ remap[ i ] ] = m->vertices[ i ];
+			}
+		}
+		for ( int i = 0; i < kept * 3; i++ ) {
+			MeshSetIndex( r, i, remap[ s.tris[ i ] ] );
+		}
+	}
+	*error = (float)sqrt( worst );
+
+	free( s.tris ); free( s.alive ); free( s.pos ); free( s.locked ); free( s.quadrics ); free( s.candidates );
+	free( table ); free( start ); free( adjacent ); free( touched );
+	return r;
+}
+
+lods_t * Lods( mesh_t * m, clusters_t * c, bool optimize ) {
+	lods_t * l = (lods_t*)malloc( sizeof( lods_t ) );
+	if ( l == NULL ) {
+		printf( "(EE) Unable to allocate levels of detail\n" );
+		return NULL;
+	}
+	l->levels[ 0 ].mesh = m;
+	l->levels[ 0 ].clusters = c;
+	l->levels[ 0 ].error = 0.0f;
+	l->count = 1;
+
+	aabb_t box = Aabb();
+	for ( int i = 0; i < m->nvertices; i++ ) {
+		AabbExtend( &box, m->vertices[ i ].pos );
+	}
+	l->center = Vec3fScale( Vec3fAdd( box.min, box.max ), 0.5f );
+	l->radius = 0.5f * Vec3fLength( Vec3fSub( box.max, box.min ) );
+
+	for ( int i = 1; i < LOD_LEVELS; i++ ) {
+		lod_t * previous = &l->levels[ i - 1 ];
+		Uint64 start = SDL_GetPerformanceCounter();
+		float error;
+		mesh_t * s = LodSimplify( previous->mesh, previous->clusters, LOD_RATIO, &error );
+		if ( s == NULL ) {
+			break;
+		}
+		// Plus rien à gagner : bords et coutures fixes retiennent la plupart des triangles
+		if ( s->nindices == 0 || s->nindices > 0.9f * previous->mesh->nindices ) {
+			MeshDelete( s );
+			break;
+		}
+		if ( optimize ) {
+			MeshOptimize( s );
+		}
+		int nfaces = s->nindices / 3;
+		vec3f_t * corners = (vec3f_t*)malloc( sizeof( vec3f_t ) * s->nindices );
+		clusters_t * clusters = NULL;
+		if ( corners != NULL ) {
+			for ( int j = 0; j < s->nindices; j++ ) {
+				corners[ j ] = s->vertices[ MeshIndex( s, j ) ].pos;
+			}
+			clusters = Clusters( corners, nfaces );
+			free( corners );
+		}
+		// Sans ses groupes, le niveau ne peut être ni dessiné ni simplifié : on s'arrête là
+		if ( clusters == NULL ) {
+			printf( "(EE) Unable to allocate level of detail %d\n", i );
+			MeshDelete( s );
+			break;
+		}
+		lod_t * lod = &l->levels[ i ];
+		lod->mesh = s;
+		lod->clusters = clusters;
+		// Chaque niveau simplifie le précédent : les écarts s'ajoutent
+		lod->error = previous->error + error;
+		l->count++;
+		printf( "(II) LOD %d: %d triangles, %d vertices, error %g, built in %.2f ms\n", i, nfaces, s->nvertices, lod->error,
+			1000.0 * ( SDL_GetPerformanceCounter() - start ) / SDL_GetPerformanceFrequency() );
+	}
+	return l;
+}
+
+void LodsDelete( lods_t * l ) {
+	if ( l == NULL ) {
+		return;
+	}
+	for ( int i = 1; i < l->count; i++ ) {
+		MeshDelete( l->levels[ i ].mesh );
+		ClustersDelete( l->levels[ i ].clusters );
+	}
+	free( l );
+}
+
+int LodsSelect( const lods_t * l, const camera_t * c, int height ) {
+	float distance = Vec3fLength( Vec3fSub( l->center, c->eye ) ) - l->radius;
+	if ( distance <= c->znear ) {
+		return 0;
+	}
+	// Pixels couverts par une unité de la scène à cette distance
+	float scale = height / ( 2.0f * tanf( 0.5f * c->fovy ) * distance );
+	for ( int i = l->count - 1; i > 0; i-- ) {
+		if ( l->levels[ i ].error * scale <= LOD_PIXELS ) {
+			return i;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,75 @@
+#ifndef __LOD_H__
+#define __LOD_H__
+
+#include <stdbool.h>
+#include "geometry.h"
+#include "camera.h"
+#include "mesh.h"
+#include "cluster.h"
+
+/**
+ * Nombre de niveaux de dtail, le niveau 0 tant le maillage d'origine, et proportion
+ * de triangles vise par chaque niveau par rapport au prcdent
+ */
+#define LOD_LEVELS		4
+#define LOD_RATIO		0.5f
+
+/**
+ * Erreur gomtrique projete tolre par le choix automatique du niveau, en pixels
+ */
+#define LOD_PIXELS		1.0f
+
+/**
+ * Dfinition des types
+ */
+
+/**
+ * Niveau de dtail : maillage simplifi, ses groupes de triangles pour le culling, et
+ * borne de l'cart  la surface d'origine, en units de la scne
+ */
+typedef struct lod {
+	mesh_t		*	mesh;
+	clusters_t	*	clusters;
+	float			error;
+}lod_t;
+
+typedef struct lods {
+	lod_t			levels[ LOD_LEVELS ];
+	int			count;
+	vec3f_t			center;		// Sphre englobante du modle
+	float			radius;
+}lods_t;
+
+/**
+ * Dfinition des prototypes de fonctions
+ */
+
+/**
+ * Simplifie un maillage par contractions d'artes guides par les quadriques d'erreur,
+ * jusqu' garder environ ratio de ses triangles. Les cots des artes sont valus en
+ * parallle, groupe par groupe. Chaque sommet gard reste en place ; les sommets d'une
+ * couture suivent celle-ci, et les bords ouverts ne bougent pas. error reoit la plus
+ * grande distance moyenne aux plans d'origine d'une contraction. Retourne NULL si
+ * l'allocation choue.
+ */
+mesh_t			*	LodSimplify		( const mesh_t * m, const clusters_t * c, float ratio, float * error );
+
+/**
+ * Construit les niveaux de dtail d'un maillage : le niveau 0 est le maillage et ses
+ * groupes, repris sans copie, chaque niveau suivant simplifie le prcdent. Avec
+ * optimize, les triangles des niveaux sont rordonns pour le cache de sommets.
+ */
+lods_t			*	Lods			( mesh_t * m, clusters_t * c, bool optimize );
+
+/**
+ * Supprime les niveaux de dtail, sauf le niveau 0 qui appartient  l'appelant
+ */
+void				LodsDelete		( lods_t * l );
+
+/**
+ * Niveau le plus simple dont l'erreur, projete  la distance du point du modle le plus
+ * proche de la camra, reste sous LOD_PIXELS pixels d'une image de height lignes
+ */
+int				LodsSelect		( const lods_t * l, const camera_t * c, int height );
+
+#endif //__LOD_H__
@@ -1,8 +1,17 @@
-﻿#include "window.h"
+#include "window.h"
 #include "events.h"
+#include "controller.h"
 #include "vector.h"
 #include "geometry.h"
 #include "model.h"
+#include "camera.h"
+#include "render.h"
+#include "jobs.h"
+#include "fxaa.h"
+#include "resolution.h"
+#include "latency.h"
+#include "stream.h"
+#include <time.h>
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
@@ -11,46 +20,210 @@ int main( int argc, char ** argv ) {
 	const int width		= 1024;
 	const int height	= 768;
 
-	bool test = ModelLoad("./bin/data/body.obj");
+	// Découpage d'un modèle en morceaux pour le rendu hors mémoire : --chunk modele.obj morceaux.chunks
+	if ( argc > 3 && strcmp( argv[ 1 ], "--chunk" ) == 0 ) {
+		return StreamBuild( argv[ 2 ], argv[ 3 ] ) ? 0 : 1;
+	}
+
+	// Modèle donné en premier argument : un fichier .chunks est lu par morceaux, dans la
+	// limite de mémoire donnée en Mo en argument suivant. --target fixe la durée de trame
+	// visée en millisecondes par la résolution dynamique
+	char * path = (char*)"./bin/data/body.obj";
+	char * megabytes = NULL;
+	float target = RESOLUTION_TARGET;
+	int positional = 0;
+	bool usage = false;
+	for ( int i = 1; i < argc; i++ ) {
+		if ( strcmp( argv[ i ], "--target" ) == 0 && i + 1 < argc ) {
+			target = (float)atof( argv[ ++i ] );
+		}else if ( argv[ i ][ 0 ] != '-' && positional == 0 ) {
+			path = argv[ i ];
+			positional++;
+		}else if ( argv[ i ][ 0 ] != '-' && positional == 1 ) {
+			megabytes = argv[ i ];
+			positional++;
+		}else {
+			usage = true;
+		}
+	}
+	size_t length = strlen( path );
+	bool streamed = length > 7 && strcmp( path + length - 7, ".chunks" ) == 0;
+	size_t budget = ( megabytes != NULL ) ? (size_t)( atof( megabytes ) * 1024.0 * 1024.0 ) : STREAM_BUDGET;
+	bool test = !usage && ( streamed || megabytes == NULL ) && target > 0.0f;
+	test = test && ( streamed ? ModelLoadStream( path, budget ) : ModelLoad( path, MODEL_OPTIMIZE | MODEL_LOD ) );
+	if ( !test ) {
+		printf( "Usage: %s [model.obj | model.chunks [budget MB]] [--target ms]\n", argv[ 0 ] );
+		printf( "       %s --chunk model.obj model.chunks\n", argv[ 0 ] );
+		return 1;
+	}
 
 	// Ouverture d'une nouvelle fenêtre
 	window_t * mainwindow = WindowInit( width, height, 4 );
-	
+
+	// Caméra regardant le modèle depuis l'axe z
+	camera_t camera = Camera( Vec3f( 0.0f, 0.0f, 3.0f ), Vec3f( 0.0f, 0.0f, 0.0f ), Vec3f( 0.0f, 1.0f, 0.0f ), M_PI / 4.0f, (float)width / height );
+
+	// Un modèle lu par morceaux est cadré en entier, le plan lointain reculé si besoin
+	if ( streamed ) {
+		aabb_t bounds = ModelStream()->bounds;
+		vec3f_t center = Vec3fScale( Vec3fAdd( bounds.min, bounds.max ), 0.5f );
+		float radius = 0.5f * Vec3fLength( Vec3fSub( bounds.max, bounds.min ) );
+		camera = Camera( Vec3fAdd( center, Vec3f( 0.0f, 0.0f, 1.5f * radius ) ), center, Vec3f( 0.0f, 1.0f, 0.0f ), M_PI / 4.0f, (float)width / height );
+		camera.zfar = MAX( camera.zfar, 4.0f * radius );
+	}
+
+	// Lumières ponctuelles réparties autour du modèle, allumées par la touche p
+	if ( ModelBvh() != NULL ) {
+		aabb_t bounds = ModelBvh()->nodes[ 0 ].box;
+		vec3f_t center = Vec3fScale( Vec3fAdd( bounds.min, bounds.max ), 0.5f );
+		float radius = 0.3f * Vec3fLength( Vec3fSub( bounds.max, bounds.min ) );
+		RenderOptions()->lights = LightScatter( RENDER_POINT_LIGHTS, center, radius, 0.5f * radius );
+	}
+
+	// Résolution dynamique (touche v), visant la durée de trame donnée par --target
+	resolution_t resolution = Resolution( target );
+
+	// Caméra pilotée par la souris et le clavier (touche o : orbite ou vol libre)
+	controller_t controller = Controller( &camera );
+
+	// Latence entre les évènements et la présentation (touche n : mode de présentation)
+	latency_t latency = Latency();
 
 	int done = false;
 
+	// Statistiques cumulées, affichées une fois par seconde, et temps processeur consommé
+	Uint64 frequency = SDL_GetPerformanceFrequency();
+	Uint64 report = SDL_GetPerformanceCounter();
+	clock_t cpu = clock();
+	double rendertime = 0.0, overdraw = 0.0, fxaatime = 0.0, frametime = 0.0;
+	int frames = 0, unchanged = 0;
+	long long uploaded = 0;
+
+	// Vrai tant que la dernière trame dessinée n'a pas été présentée
+	bool pending = false;
+
 	// Tant que l'utilisateur de ferme pas la fenêtre
 	while ( !done ) {
 
-		// Mise à jour et traitement des evênements de la fenêtre
-		done = EventsUpdate( mainwindow );		
-		
-		// Effacement de l'écran avec une couleur
-		WindowDrawClearColor( mainwindow, 0, 0, 0 );
+		// Mise à jour et traitement des evênements de la fenêtre : sans rien à dessiner ni à
+		// présenter, la boucle pilotée par les évènements dort jusqu'au prochain
+		bool continuous = RenderOptions()->continuous;
+		done = EventsUpdate( mainwindow, &camera, &controller, ( continuous || pending || ControllerMoving( &controller ) ) ? 0 : EVENTS_IDLE_TIMEOUT );
 
-		// Dessin d'un point blanc au milieu de le fenêtre		
-		//WindowDrawPoint( mainwindow, width / 2, height / 2, 255, 255, 255 );
+		Uint64 now = SDL_GetPerformanceCounter();
+		if ( now - report >= frequency ) {
+			double seconds = (double)( now - report ) / frequency;
+			renderstats_t * stats = RenderStats();
+			if ( frames > 0 ) {
+				printf( "(II) Render: %.2f ms, %.2f fragments shaded per visible pixel (%s%s)\n", 1000.0 * rendertime / frames, overdraw / frames, RenderOptions()->zprepass ? "z-prepass" : "single pass", RenderOptions()->msaa ? ", 4x MSAA" : "" );
+				if ( RenderOptions()->fxaa ) {
+					printf( "(II) FXAA: %.2f ms\n", 1000.0 * fxaatime / frames );
+				}
+				if ( RenderOptions()->dynamic ) {
+					printf( "(II) Resolution: %dx%d (%d%%), frame %.2f ms for a %.2f ms target\n", mainwindow->width, mainwindow->height, 100 * resolution.level / RESOLUTION_LEVELS, 1000.0 * frametime / frames, resolution.target );
+				}
+				if ( ModelLods() != NULL ) {
+					printf( "(II) LOD: level %d (%s), %d triangles\n", stats->lod, ( RenderOptions()->lod == RENDER_LOD_AUTO ) ? "auto" : "forced", stats->triangles );
+				}
+				if ( RenderOptions()->heatmap ) {
+					printf( "(II) Overdraw: %lld fragments over %d pixels, ratio %.2f, at most %d writes per pixel\n", stats->fragments, stats->pixels, ( stats->pixels > 0 ) ? (double)stats->fragments / stats->pixels : 0.0, stats->maxwrites );
+				}
+			}
+			LatencyReport( &latency );
+			StreamReport( ModelStream() );
+			printf( "(II) Redraw: %d frames drawn, %d unchanged, %.1f%% of the pixels uploaded, CPU %.1f%% (%s loop)\n", frames, unchanged, ( frames > 0 ) ? 100.0 * uploaded / ( (double)frames * mainwindow->width * mainwindow->height ) : 0.0, 100.0 * ( clock() - cpu ) / CLOCKS_PER_SEC / seconds, continuous ? "continuous" : "event-driven" );
+			report = now;
+			cpu = clock();
+			rendertime = overdraw = fxaatime = frametime = 0.0;
+			frames = unchanged = 0;
+			uploaded = 0;
+		}
 
-		// Dessin d'une ligne
-		//for(int i = 0 ; i < 10000 ; i++){
-			//WindowDrawLine( mainwindow, 50, 10, 50, 200, 255, 255, 255);
-		//}
-		
-		WindowDrawTriangle(mainwindow, 1);
+		// Caméra échantillonnée au dernier moment avant le dessin, interpolée entre deux pas
+		// du contrôleur : une trame longue ne retarde pas la prise en compte des évènements
+		camera = ControllerCamera( &controller );
+
+		// La boucle continue redessine chaque trame, pour les animations
+		if ( continuous ) {
+			RenderInvalidate();
+		}
+
+		// Caméra, options et fenêtre inchangées : la trame précédente reste à l'écran, et
+		// n'est présentée que si elle ne l'a pas encore été
+		if ( !RenderChanged( mainwindow, &camera ) ) {
+			if ( pending ) {
+				WindowUpdateRect( mainwindow, NULL );
+				LatencyPresented( &latency, false );
+				pending = false;
+			}
+			unchanged++;
+			continue;
+		}
+
+		// En mode faible latence, la trame attend le dernier moment qui lui laisse le temps
+		// d'être prête à la synchronisation verticale, et reprend les évènements arrivés entre-temps
+		if ( LatencyWait( &latency, mainwindow ) ) {
+			done = EventsUpdate( mainwindow, &camera, &controller, 0 ) || done;
+			camera = ControllerCamera( &controller );
+			RenderChanged( mainwindow, &camera );
+		}
+		LatencySample( &latency );
 		
-		// Mise à jour de la fenêtre
-		WindowUpdate( mainwindow );
+		// Effacement des seules tuiles dessinées par la trame précédente, le reste est au fond
+		Uint64 framestart = SDL_GetPerformanceCounter();
+		SDL_Rect previous = RenderStats()->drawn;
+		WindowClearRect( mainwindow, &previous, WindowColor( 0, 0, 0 ) );
+
+		// Dessin du modèle vu depuis la caméra
+		Uint64 start = SDL_GetPerformanceCounter();
+		RenderModel( mainwindow, &camera );
+		rendertime += (double)( SDL_GetPerformanceCounter() - start ) / frequency;
+
+		// Anti-crénelage en post-traitement, avant la copie vers la texture
+		if ( RenderOptions()->fxaa ) {
+			start = SDL_GetPerformanceCounter();
+			FxaaApply( mainwindow );
+			fxaatime += (double)( SDL_GetPerformanceCounter() - start ) / frequency;
+		}
+
+		// Durée de la trame hors présentation, qui attend la synchronisation verticale
+		double elapsed = (double)( SDL_GetPerformanceCounter() - framestart ) / frequency;
+		frametime += elapsed;
+		renderstats_t * stats = RenderStats();
+		SDL_Rect dirty;
+		SDL_UnionRect( &previous, &stats->drawn, &dirty );
+		uploaded += (long long)dirty.w * dirty.h;
+		overdraw += ( stats->pixels > 0 ) ? (double)stats->fragments / stats->pixels : 0.0;
+		frames++;
+
+		// Mise à jour de la fenêtre : seules les tuiles effacées ou redessinées sont copiées,
+		// après la présentation de la trame précédente en mode en file, avant sinon
+		LatencyDrawn( &latency, ControllerTakeInput( &controller ) );
+		bool shown = WindowUpdateRect( mainwindow, &dirty );
+		LatencyPresented( &latency, shown );
+		pending = !shown;
+
+		// Nouvelle résolution interne éventuelle, prise en compte dès la trame suivante
+		if ( RenderOptions()->dynamic ) {
+			ResolutionUpdate( &resolution, mainwindow, (float)( 1000.0 * elapsed ) );
+		}else {
+			ResolutionReset( &resolution, mainwindow );
+		}
 
 	}
 
+	// Modèle libéré d'un coup, avant la fenêtre : le chargeur de morceaux éventuel la
+	// réveille par des évènements
+	ModelDelete();
+	RenderQuit();
+	FxaaQuit();
+
 	// Fermeture de la fenêtre
 	WindowDestroy( mainwindow );
+	JobsQuit();
 	
 	
-	free(ModelNormals());
-	free(ModelVertices());
-	free(ModelTexcoords());
-	free(ModelFaces());
+	free(RenderOptions()->lights);
 	
 	return 1;
 }
@@ -0,0 +1,336 @@
+#include "mesh.h"
+
+#define MESH_CACHE_SIZE		32
+#define MESH_FIFO_SIZE		16
+
+/**
+ * Entrée de la table de hachage des triplets v/vt/vn déjà rencontrés
+ */
+typedef struct meshkey {
+	int			v;
+	int			vt;
+	int			vn;
+	int			idx;
+}meshkey_t;
+
+static unsigned int MeshHash( int v, int vt, int vn ) {
+	unsigned int h = (unsigned int)v * 73856093u;
+	h ^= (unsigned int)vt * 19349663u;
+	h ^= (unsigned int)vn * 83492791u;
+	return h;
+}
+
+static vertex_t MeshVertex( vector_t * vertices, vector_t * normals, vector_t * texcoords, int v, int vt, int vn ) {
+	vertex_t r;
+	memset( &r, 0, sizeof( vertex_t ) );
+	// Index OBJ à partir de 1 : hors de [1, longueur], VectorGetFromIdx retourne NULL et
+	// l'attribut reste nul
+	vec3f_t * p = (vec3f_t*)VectorGetFromIdx( vertices, v - 1 );
+	vec3f_t * n = (vec3f_t*)VectorGetFromIdx( normals, vn - 1 );
+	vec2f_t * t = (vec2f_t*)VectorGetFromIdx( texcoords, vt - 1 );
+	if ( p != NULL ) r.pos = *p;
+	if ( n != NULL ) r.norm = *n;
+	if ( t != NULL ) r.uv = *t;
+	return r;
+}
+
+/**
+ * Ramène un index OBJ (à partir de 1, ou négatif depuis le dernier élément lu) dans
+ * [1, count], 0 s'il ne désigne aucun élément
+ */
+static int MeshObjIndex( int i, int count ) {
+	if ( i < 0 ) {
+		i += count + 1;
+	}
+	return ( i >= 1 && i <= count ) ? i : 0;
+}
+
+bool MeshParseFace( const char * line, face_t * face, int nv, int nvt, int nvn ) {
+	memset( face, 0, sizeof( face_t ) );
+	int * v = face->v, * vt = face->vt, * vn = face->vn;
+	if ( sscanf( line, "%*s %d/%d/%d %d/%d/%d %d/%d/%d", &v[0], &vt[0], &vn[0], &v[1], &vt[1], &vn[1], &v[2], &vt[2], &vn[2] ) != 9 ) {
+		memset( face, 0, sizeof( face_t ) );
+		if ( sscanf( line, "%*s %d//%d %d//%d %d//%d", &v[0], &vn[0], &v[1], &vn[1], &v[2], &vn[2] ) != 6 ) {
+			memset( face, 0, sizeof( face_t ) );
+			if ( sscanf( line, "%*s %d/%d %d/%d %d/%d", &v[0], &vt[0], &v[1], &vt[1], &v[2], &vt[2] ) != 6 ) {
+				memset( face, 0, sizeof( face_t ) );
+				if ( sscanf( line, "%*s %d %d %d", &v[0], &v[1], &v[2] ) != 3 ) {
+					return false;
+				}
+			}
+		}
+	}
+	for ( int j = 0; j < 3; j++ ) {
+		v[ j ]  = MeshObjIndex( v[ j ], nv );
+		vt[ j ] = MeshObjIndex( vt[ j ], nvt );
+		vn[ j ] = MeshObjIndex( vn[ j ], nvn );
+		if ( v[ j ] == 0 ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+mesh_t * Mesh( vector_t * vertices, vector_t * normals, vector_t * texcoords, vector_t * faces ) {
+	int nfaces = VectorGetLength( faces );
+	int ncorners = nfaces * 3;
+
+	int size = 1;
+	while ( size < ncorners * 2 ) {
+		size <<= 1;
+	}
+	meshkey_t * table = (meshkey_t*)malloc( sizeof( meshkey_t ) * size );
+	unsigned int * remap = (unsigned int*)malloc( sizeof( unsigned int ) * ncorners );
+	vertex_t * unique = (vertex_t*)malloc( sizeof( vertex_t ) * ncorners );
+	mesh_t * m = (mesh_t*)malloc( sizeof( mesh_t ) );
+	if ( table == NULL || remap == NULL || unique == NULL || m == NULL ) {
+		printf( "(EE) Unable to allocate mesh\n" );
+		free( table ); free( remap ); free( unique ); free( m );
+		return NULL;
+	}
+	for ( int i = 0; i < size; i++ ) {
+		table[ i ].idx = -1;
+	}
+
+	// Chaque coin est cherché dans la table par sondage linéaire, un sommet
+	// n'est créé que pour un triplet v/vt/vn jamais vu
+	int nunique = 0;
+	for ( int i = 0; i < nfaces; i++ ) {
+		face_t * f = (face_t*)VectorGetFromIdx( faces, i );
+		for ( int j = 0; j < 3; j++ ) {
+			int v = f->v[ j ], vt = f->vt[ j ], vn = f->vn[ j ];
+			unsigned int h = MeshHash( v, vt, vn ) & ( size - 1 );
+			while ( table[ h ].idx >= 0 && ( table[ h ].v != v || table[ h ].vt != vt || table[ h ].vn != vn ) ) {
+				h = ( h + 1 ) & ( size - 1 );
+			}
+			if ( table[ h ].idx < 0 ) {
+				table[ h ].v   = v;
+				table[ h ].vt  = vt;
+				table[ h ].vn  = vn;
+				table[ h ].idx = nunique;
+				unique[ nunique++ ] = MeshVertex( vertices, normals, texcoords, v, vt, vn );
+			}
+			remap[ i * 3 + j ] = table[ h ].idx;
+		}
+	}
+
+	int indexsize = ( nunique <= 65536 ) ? 2 : 4;
+	void * indices = malloc( (size_t)indexsize * (size_t)ncorners );
+	if ( indices == NULL ) {
+		printf( "(EE) Unable to allocate mesh\n" );
+		free( table ); free( remap ); free( unique ); free( m );
+		return NULL;
+	}
+	// Ne fait que réduire le bloc : en cas d'échec, l'ancien reste valide
+	vertex_t * shrunk = (vertex_t*)realloc( unique, sizeof( vertex_t ) * MAX( nunique, 1 ) );
+	m->nvertices = nunique;
+	m->vertices  = ( shrunk != NULL ) ? shrunk : unique;
+	m->nindices  = ncorners;
+	m->indexsize = indexsize;
+	m->indices   = indices;
+	for ( int i = 0; i < ncorners; i++ ) {
+		MeshSetIndex( m, i, remap[ i ] );
+	}
+
+	// Comparaison avec les faces à trois jeux d'index et les attributs séparés
+	size_t before = sizeof( face_t ) * nfaces
+		+ sizeof( vec3f_t ) * ( VectorGetLength( vertices ) + VectorGetLength( normals ) )
+		+ sizeof( vec2f_t ) * VectorGetLength( texcoords );
+	size_t after = sizeof( vertex_t ) * nunique + m->indexsize * ncorners;
+	printf( "(II) Mesh: %d corners welded into %d vertices (%.1f%%), %d-bit indices, %zu -> %zu bytes\n",
+		ncorners, nunique, 100.0f * nunique / MAX( ncorners, 1 ), m->indexsize * 8, before, after );
+
+	free( table );
+	free( remap );
+	return m;
+}
+
+/**
+ * Score d'un sommet selon sa position dans le cache simulé et le nombre de
+ * triangles qui l'utilisent encore (Forsyth, "Linear-Speed Vertex Cache Optimisation")
+ */
+static float MeshVertexScore( int position, int remaining ) {
+	if ( remaining == 0 ) {
+		return -1.0f;
+	}
+	float score = 0.0f;
+	if ( position >= 0 ) {
+		if ( position < 3 ) {
+			// Les sommets du dernier triangle ont un score fixe pour éviter les bandes
+			score = 0.75f;
+		}else {
+			score = powf( 1.0f - ( position - 3 ) * ( 1.0f / ( MESH_CACHE_SIZE - 3 ) ), 1.5f );
+		}
+	}
+	return score + 2.0f * powf( (float)remaining, -0.5f );
+}
+
+float MeshACMR( mesh_t * m, int cachesize ) {
+	int * stamp = (int*)malloc( sizeof( int ) * MAX( m->nvertices, 1 ) );
+	if ( stamp == NULL ) {
+		printf( "(EE) Unable to allocate cache simulation of %d vertices\n", m->nvertices );
+		return -1.0f;
+	}
+	for ( int i = 0; i < m->nvertices; i++ ) {
+		stamp[ i ] = -cachesize - 1;
+	}
+	// Un sommet est dans le cache FIFO si moins de cachesize défauts ont eu lieu depuis son entrée
+	int misses = 0;
+	for ( int i = 0; i < m->nindices; i++ ) {
+		int v = MeshIndex( m, i );
+		if ( misses - stamp[ v ] > cachesize ) {
+			stamp[ v ] = misses;
+			misses++;
+		}
+	}
+	free( stamp );
+	return (float)misses / MAX( m->nindices / 3, 1 );
+}
+
+void MeshOptimize( mesh_t * m ) {
+	int ntris = m->nindices / 3;
+	int nverts = m->nvertices;
+	float before = MeshACMR( m, MESH_FIFO_SIZE );
+
+	// Triangles adjacents à chaque sommet, rangés de façon contiguë
+	int * offsets   = (int*)calloc( nverts + 1, sizeof( int ) );
+	int * remaining = (int*)calloc( nverts, sizeof( int ) );
+	int * adjacency = (int*)malloc( sizeof( int ) * m->nindices );
+	int * position  = (int*)malloc( sizeof( int ) * nverts );
+	float * vscore  = (float*)malloc( sizeof( float ) * nverts );
+	float * tscore  = (float*)malloc( sizeof( float ) * ntris );
+	bool * emitted  = (bool*)calloc( ntris, sizeof( bool ) );
+	int * order     = (int*)malloc( sizeof( int ) * m->nindices );
+	int * fill      = (int*)malloc( sizeof( int ) * nverts );
+	vertex_t * vertices = (vertex_t*)malloc( sizeof( vertex_t ) * nverts );
+	if ( offsets == NULL || remaining == NULL || adjacency == NULL || position == NULL || vscore == NULL
+		|| tscore == NULL || emitted == NULL || order == NULL || fill == NULL || vertices == NULL ) {
+		// Le maillage garde son ordre d'origine
+		printf( "(EE) Unable to allocate mesh optimization\n" );
+		free( offsets ); free( remaining ); free( adjacency ); free( position ); free( vscore );
+		free( tscore ); free( emitted ); free( order ); free( fill ); free( vertices );
+		return;
+	}
+
+	for ( int i = 0; i < m->nindices; i++ ) {
+		remaining[ MeshIndex( m, i ) ]++;
+	}
+	for ( int v = 0; v < nverts; v++ ) {
+		offsets[ v + 1 ] = offsets[ v ] + remaining[ v ];
+		position[ v ] = -1;
+		vscore[ v ] = MeshVertexScore( -1, remaining[ v ] );
+	}
+	memcpy( fill, offsets, sizeof( int ) * nverts );
+	for ( int i = 0; i < m->nindices; i++ ) {
+		adjacency[ fill[ MeshIndex( m, i ) ]++ ] = i / 3;
+	}
+	free( fill );
+	for ( int t = 0; t < ntris; t++ ) {
+		tscore[ t ] = vscore[ MeshIndex( m, t * 3 ) ] + vscore[ MeshIndex( m, t * 3 + 1 ) ] + vscore[ MeshIndex( m, t * 3 + 2 ) ];
+	}
+
+	int cache[ MESH_CACHE_SIZE + 3 ];
+	int ncache = 0;
+	int cursor = 0;
+	int best = -1;
+	for ( int n = 0; n < ntris; n++ ) {
+		if ( best < 0 ) {
+			// Plus aucun candidat dans le cache : on repart du premier triangle restant
+			while ( emitted[ cursor ] ) {
+				cursor++;
+			}
+			best = cursor;
+		}
+		int t = best;
+		emitted[ t ] = true;
+		int tri[ 3 ];
+		for ( int j = 0; j < 3; j++ ) {
+			tri[ j ] = MeshIndex( m, t * 3 + j );
+			order[ n * 3 + j ] = tri[ j ];
+			remaining[ tri[ j ] ]--;
+			// Retire le triangle émis de la liste d'adjacence du sommet
+			int * adj = &adjacency[ offsets[ tri[ j ] ] ];
+			for ( int k = 0; k <= remaining[ tri[ j ] ]; k++ ) {
+				if ( adj[ k ] == t ) {
+					adj[ k ] = adj[ remaining[ tri[ j ] ] ];
+					break;
+				}
+			}
+		}
+
+		// Cache LRU : les sommets du triangle passent en tête
+		int newcache[ MESH_CACHE_SIZE + 3 ];
+		int nnew = 0;
+		for ( int j = 0; j < 3; j++ ) {
+			newcache[ nnew++ ] = tri[ j ];
+		}
+		for ( int i = 0; i < ncache; i++ ) {
+			int v = cache[ i ];
+			if ( v != tri[ 0 ] && v != tri[ 1 ] && v != tri[ 2 ] ) {
+				newcache[ nnew++ ] = v;
+			}
+		}
+		for ( int i = MESH_CACHE_SIZE; i < nnew; i++ ) {
+			position[ newcache[ i ] ] = -1;
+			vscore[ newcache[ i ] ] = MeshVertexScore( -1, remaining[ newcache[ i ] ] );
+		}
+		ncache = MIN( nnew, MESH_CACHE_SIZE );
+		memcpy( cache, newcache, sizeof( int ) * ncache );
+
+		// Mise à jour des scores des sommets du cache et de leurs triangles restants
+		for ( int i = 0; i < ncache; i++ ) {
+			position[ cache[ i ] ] = i;
+			vscore[ cache[ i ] ] = MeshVertexScore( i, remaining[ cache[ i ] ] );
+		}
+		best = -1;
+		float bestscore = -1.0f;
+		for ( int i = 0; i < ncache; i++ ) {
+			int v = cache[ i ];
+			for ( int k = 0; k < remaining[ v ]; k++ ) {
+				int a = adjacency[ offsets[ v ] + k ];
+				tscore[ a ] = vscore[ MeshIndex( m, a * 3 ) ] + vscore[ MeshIndex( m, a * 3 + 1 ) ] + vscore[ MeshIndex( m, a * 3 + 2 ) ];
+				if ( tscore[ a ] > bestscore ) {
+					bestscore = tscore[ a ];
+					best = a;
+				}
+			}
+		}
+	}
+
+	// Renumérotation des sommets dans leur ordre de première utilisation
+	int * remap = position;
+	for ( int v = 0; v < nverts; v++ ) {
+		remap[ v ] = -1;
+	}
+	int nused = 0;
+	for ( int i = 0; i < m->nindices; i++ ) {
+		int v = order[ i ];
+		if ( remap[ v ] < 0 ) {
+			remap[ v ] = nused;
+			vertices[ nused++ ] = m->vertices[ v ];
+		}
+		MeshSetIndex( m, i, remap[ v ] );
+	}
+	free( m->vertices );
+	m->vertices = vertices;
+	m->nvertices = nused;
+
+	printf( "(II) Mesh optimization: ACMR %.3f -> %.3f (FIFO %d)\n", before, MeshACMR( m, MESH_FIFO_SIZE ), MESH_FIFO_SIZE );
+
+	free( offsets );
+	free( remaining );
+	free( adjacency );
+	free( position );
+	free( vscore );
+	free( tscore );
+	free( emitted );
+	free( order );
+}
+
+void MeshDelete( mesh_t * m ) {
+	if ( m != NULL ) {
+		free( m->vertices );
+		free( m->indices );
+		free( m );
+	}
+}
@@ -0,0 +1,84 @@
+#ifndef __MESH_H__
+#define __MESH_H__
+
+#include "vector.h"
+#include "geometry.h"
+
+/**
+ * Dfinition des types
+ */
+
+/**
+ * Sommet entrelac : position, normale et coordonnes de texture (32 octets)
+ */
+typedef struct vertex {
+	vec3f_t			pos;
+	vec3f_t			norm;
+	vec2f_t			uv;
+}vertex_t;
+
+/**
+ * Maillage index : trois index par triangle, sur 16 bits si le nombre de
+ * sommets le permet, sur 32 bits sinon
+ */
+typedef struct mesh {
+	vertex_t	*	vertices;
+	int			nvertices;
+	void		*	indices;
+	int			nindices;
+	int			indexsize;
+}mesh_t;
+
+/**
+ * Dfinition des prototypes de fonctions
+ */
+
+/**
+ * Construit un maillage index en soudant les triplets v/vt/vn identiques des faces
+ */
+mesh_t			*	Mesh			( vector_t * vertices, vector_t * normals, vector_t * texcoords, vector_t * faces );
+
+/**
+ * Lit les trois coins d'une ligne f de fichier OBJ sous la forme v/vt/vn, v//vn, v/vt ou v
+ * et ramne les index dans [1, count] pour nv positions, nvt coordonnes de texture et nvn
+ * normales dj lues. Retourne faux si la forme n'est pas reconnue ou si un coin ne dsigne
+ * pas une position ; une normale ou une coordonne de texture absente est laisse  0.
+ */
+bool				MeshParseFace		( const char * line, face_t * face, int nv, int nvt, int nvn );
+
+/**
+ * Rordonne les triangles pour la localit du cache de sommets transforms
+ * (algorithme de Forsyth) puis les sommets dans leur ordre de premire utilisation
+ */
+void				MeshOptimize		( mesh_t * m );
+
+/**
+ * Retourne le nombre moyen de dfauts de cache par triangle (ACMR) pour un cache FIFO de taille donne,
+ * -1 si la simulation n'a pu tre alloue
+ */
+float				MeshACMR		( mesh_t * m, int cachesize );
+
+/**
+ * Supprime un maillage index
+ */
+void				MeshDelete		( mesh_t * m );
+
+/**
+ * Retourne l'index de sommet du coin i du maillage
+ */
+inline int MeshIndex( const mesh_t * m, int i ) {
+	return ( m->indexsize == 2 ) ? ( (unsigned short*)m->indices )[ i ] : (int)( (unsigned int*)m->indices )[ i ];
+}
+
+/**
+ * Positionne l'index de sommet du coin i du maillage
+ */
+inline void MeshSetIndex( mesh_t * m, int i, int v ) {
+	if ( m->indexsize == 2 ) {
+		( (unsigned short*)m->indices )[ i ] = (unsigned short)v;
+	}else {
+		( (unsigned int*)m->indices )[ i ] = (unsigned int)v;
+	}
+}
+
+#endif //__MESH_H__
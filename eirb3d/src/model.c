@@ -6,6 +6,13 @@ vector_t * g_vertex;
 vector_t * g_norm;
 vector_t * g_texcoord;
 vector_t * g_face;
+bvh_t    * g_bvh;
+clusters_t * g_clusters;
+mesh_t   * g_mesh;
+edges_t  * g_edges;
+lods_t   * g_lods = NULL;
+stream_t * g_stream = NULL;
+arena_t  * g_arena = NULL;
 
 vector_t * ModelVertices() {
 	return g_vertex;
@@ -23,6 +30,30 @@ vector_t * ModelFaces() {
 	return g_face;
 }
 
+bvh_t * ModelBvh() {
+	return g_bvh;
+}
+
+clusters_t * ModelClusters() {
+	return g_clusters;
+}
+
+mesh_t * ModelMesh() {
+	return g_mesh;
+}
+
+stream_t * ModelStream() {
+	return g_stream;
+}
+
+edges_t * ModelEdges() {
+	return g_edges;
+}
+
+lods_t * ModelLods() {
+	return g_lods;
+}
+
 vec3f_t ModelGetVertex( int index ) {
 	vec3f_t v = *(vec3f_t*)VectorGetFromIdx( ModelVertices(), index );
 	return v;
@@ -43,34 +74,56 @@ face_t ModelGetFace( int index ) {
 	return f;
 }
 
-bool ModelLoad( char * objfilename ) {
-
-	g_vertex = Vector();
-	g_norm = Vector();
-	g_texcoord = Vector();
-	g_face = Vector();
+bool ModelLoad( char * objfilename, int flags ) {
+
+	// Sommets, normales, coordonnées de texture et faces sont alloués dans l'arène du
+	// modèle, libérée d'un coup par ModelDelete
+	g_arena = Arena( ARENA_BLOCK );
+	g_vertex = VectorArena( g_arena );
+	g_norm = VectorArena( g_arena );
+	g_texcoord = VectorArena( g_arena );
+	g_face = VectorArena( g_arena );
+	if ( g_arena == NULL || g_vertex == NULL || g_norm == NULL || g_texcoord == NULL || g_face == NULL ) {
+		printf( "(EE) Unable to allocate model %s\n", objfilename );
+		ModelDelete();
+		return false;
+	}
 
 	char ligne[128];
 	char str[8];
 	FILE *modele = fopen(objfilename,"r");
 	if( modele == NULL ) {
-		printf( "erreur d'ouverture du fichier\n" );
+		printf( "(EE) Unable to open %s\n", objfilename );
+		ModelDelete();
+		return false;
 	}
-while(feof(modele)==0){
-  fgets(ligne, 128, modele);
+	int rejected = 0;
+	// Faux dès qu'un élément n'a pu être alloué dans l'arène
+	bool ok = true;
+while(ok && fgets(ligne, 128, modele) != NULL){
 	//printf("LIGNE : %s\n", ligne);
 
-		int ok = sscanf( ligne, "%s", str );
-		//printf("ok : %d\n", ok);
+		// Une ligne vide ne doit pas reprendre le mot-clé de la précédente
+		if ( sscanf( ligne, "%7s", str ) != 1 ) {
+			continue;
+		}
 		if ( strcmp(str,"v") == 0 ){
-			vec3f_t * v1 = (vec3f_t*)malloc( sizeof( vec3f_t ) );
+			vec3f_t * v1 = (vec3f_t*)ArenaAlloc( g_arena, sizeof( vec3f_t ) );
+			if ( v1 == NULL ) {
+				ok = false;
+				continue;
+			}
 			int okv = sscanf(ligne, " %s %f %f %f", str, &v1->x, &v1->y, &v1->z );
 			//printf("okv : %d\n", okv);
 			//printf("ligne v : %s %f %f %f\n", str, v1->x, v1->y, v1->z);
 			VectorAdd( g_vertex,  v1 );
 		}
 		else if( strcmp(str,"vn") == 0 ){
-			vec3f_t * v2 = (vec3f_t*)malloc( sizeof( vec3f_t ) );
+			vec3f_t * v2 = (vec3f_t*)ArenaAlloc( g_arena, sizeof( vec3f_t ) );
+			if ( v2 == NULL ) {
+				ok = false;
+				continue;
+			}
 			int okvn = sscanf(ligne, "%s %f %f %f\n", str, &v2->x, &v2->y, &v2->z );
 			//printf("okvn : %d\n", okvn);
 			VectorAdd( g_norm,  v2 );
@@ -78,7 +131,11 @@ while(feof(modele)==0){
 		}
 		else if(strcmp(str,"vt") == 0){
 
-			vec2f_t * u = (vec2f_t*)malloc( sizeof( vec2f_t ) );
+			vec2f_t * u = (vec2f_t*)ArenaAlloc( g_arena, sizeof( vec2f_t ) );
+			if ( u == NULL ) {
+				ok = false;
+				continue;
+			}
 			int okvt = sscanf(ligne, "%s %f %f", str, &u->x, &u->y );
 			//printf("okvt : %d\n", okvt);
 			VectorAdd (g_texcoord,  u);
@@ -87,13 +144,99 @@ while(feof(modele)==0){
 		}
 		else if(strcmp(str,"f") == 0){
 
-			face_t * face = (face_t*)malloc( sizeof( face_t ) );
-			sscanf(ligne, "%s %d/%d/%d %d/%d/%d %d/%d/%d", str, &face->v[0], &face->vn[0], &face->vt[0], &face->v[1], &face->vn[1], &face->vt[1], &face->v[2], &face->vn[2], &face->vt[2]);
-			VectorAdd(g_face, face);
+			// Index vérifiés ici : le soudage et les arêtes les utilisent sans contrôle
+			face_t * face = (face_t*)ArenaAlloc( g_arena, sizeof( face_t ) );
+			if ( face == NULL ) {
+				ok = false;
+				continue;
+			}
+			if ( MeshParseFace( ligne, face, VectorGetLength( g_vertex ), VectorGetLength( g_texcoord ), VectorGetLength( g_norm ) ) ) {
+				VectorAdd(g_face, face);
+			}else {
+				rejected++;
+			}
 			//printf("ligne f : %s %d/%d/%d %d/%d/%d %d/%d/%d\n", str, face->v[0], face->vn[0], face->vt[0], face->v[1], face->vn[1], face->vt[1], face->v[2], face->vn[2], face->vt[2]);
 
 		}
 }
 	fclose(modele);
+	if ( !ok ) {
+		ModelDelete();
+		return false;
+	}
+	if ( rejected > 0 ) {
+		printf( "(EE) %d faces ignored in %s (unsupported format or unknown vertex)\n", rejected, objfilename );
+	}
+	if ( VectorGetLength( g_face ) == 0 ) {
+		printf( "(EE) No faces in %s\n", objfilename );
+		ModelDelete();
+		return false;
+	}
+	printf( "(II) Model arena: %d elements in %d blocks, %.1f KB\n", g_arena->allocations, g_arena->mallocs, g_arena->bytes / 1024.0 );
+
+	// Sommets v/vt/vn soudés en un seul tableau entrelacé et un tampon d'index
+	g_mesh = Mesh( g_vertex, g_norm, g_texcoord, g_face );
+	if ( g_mesh == NULL ) {
+		ModelDelete();
+		return false;
+	}
+	if ( flags & MODEL_OPTIMIZE ) {
+		MeshOptimize( g_mesh );
+	}
+
+	// Hiérarchie de volumes englobants sur les faces, pour le culling et le picking
+	int nfaces = g_mesh->nindices / 3;
+	vec3f_t * corners = (vec3f_t*)malloc( sizeof( vec3f_t ) * 3 * nfaces );
+	if ( corners == NULL ) {
+		printf( "(EE) Unable to allocate %d faces of %s\n", nfaces, objfilename );
+		ModelDelete();
+		return false;
+	}
+	for ( int i = 0; i < g_mesh->nindices; i++ ) {
+		corners[ i ] = g_mesh->vertices[ MeshIndex( g_mesh, i ) ].pos;
+	}
+	g_bvh = Bvh( corners, nfaces );
+
+	// Groupes de triangles voisins pour le rejet grossier avant transformation
+	g_clusters = Clusters( corners, nfaces );
+	free( corners );
+
+	// Versions simplifiées pour les vues lointaines, choisies à chaque trame par le rendu
+	if ( flags & MODEL_LOD ) {
+		g_lods = Lods( g_mesh, g_clusters, ( flags & MODEL_OPTIMIZE ) != 0 );
+	}
+
+	// Arêtes uniques pour le rendu en fil de fer
+	g_edges = Edges( g_vertex, g_face );
+
 	return true;
 }
+
+bool ModelLoadStream( const char * chunkfilename, size_t budget ) {
+	g_stream = Stream( chunkfilename, budget );
+	return g_stream != NULL;
+}
+
+void ModelDelete() {
+	StreamDelete( g_stream );
+	LodsDelete( g_lods );
+	BvhDelete( g_bvh );
+	ClustersDelete( g_clusters );
+	MeshDelete( g_mesh );
+	EdgesDelete( g_edges );
+	// Les éléments des vecteurs appartiennent à l'arène ; un modèle lu par morceaux n'a
+	// ni vecteurs ni arène
+	if ( g_vertex != NULL ) VectorDelete( g_vertex );
+	if ( g_norm != NULL ) VectorDelete( g_norm );
+	if ( g_texcoord != NULL ) VectorDelete( g_texcoord );
+	if ( g_face != NULL ) VectorDelete( g_face );
+	ArenaDelete( g_arena );
+	g_vertex = g_norm = g_texcoord = g_face = NULL;
+	g_stream = NULL;
+	g_lods = NULL;
+	g_bvh = NULL;
+	g_clusters = NULL;
+	g_mesh = NULL;
+	g_edges = NULL;
+	g_arena = NULL;
+}
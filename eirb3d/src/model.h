@@ -3,6 +3,19 @@
 
 #include "vector.h"
 #include "geometry.h"
+#include "bvh.h"
+#include "cluster.h"
+#include "mesh.h"
+#include "edges.h"
+#include "lod.h"
+#include "stream.h"
+#include "arena.h"
+
+/**
+ * Dfinition des options de chargement
+ */
+#define MODEL_OPTIMIZE		1	// Rordonne triangles et sommets pour le cache de sommets
+#define MODEL_LOD		2	// Construit des niveaux de dtail simplifis
 
 /**
  * Dfinition des prototypes de fonctions
@@ -28,6 +41,36 @@ vector_t	*	ModelTexcoords		();
  */
 vector_t	*	ModelFaces		();
 
+/**
+ * Retourne la hirarchie de volumes englobants construite sur les faces du modle
+ */
+bvh_t		*	ModelBvh		();
+
+/**
+ * Retourne le dcoupage des faces du modle en groupes de triangles voisins
+ */
+clusters_t	*	ModelClusters		();
+
+/**
+ * Retourne le maillage index du modle (sommets entrelacs et tampon d'index)
+ */
+mesh_t		*	ModelMesh		();
+
+/**
+ * Retourne les niveaux de dtail du modle, NULL s'il est charg sans MODEL_LOD
+ */
+lods_t		*	ModelLods		();
+
+/**
+ * Retourne le modle lu par morceaux, NULL s'il est charg par ModelLoad
+ */
+stream_t	*	ModelStream		();
+
+/**
+ * Retourne la liste des artes uniques du modle
+ */
+edges_t		*	ModelEdges		();
+
 /**
  * Retourne le sommet du modle  l'index spcifi
  */
@@ -49,8 +92,20 @@ vec3f_t			ModelGetTexcoord	( int idx );
 face_t			ModelGetFace		( int idx );
 
 /**
- * Charge un modle 3D  partir du fichier spcifi
+ * Charge un modle 3D  partir du fichier spcifi (options MODEL_*)
+ */
+bool			ModelLoad		( char * objfilename, int flags );
+
+/**
+ * Ouvre un fichier de morceaux (StreamBuild)  la place d'un modle : aucune donne n'est
+ * charge en entier, les morceaux visibles sont lus pendant le rendu dans la limite de
+ * budget octets. Le modle n'a alors ni hirarchie de volumes, ni artes, ni niveaux de dtail.
+ */
+bool			ModelLoadStream		( const char * chunkfilename, size_t budget );
+
+/**
+ * Supprime le modle charg et tout ce qui en a t dduit ; arrte le chargeur de morceaux
  */
-bool			ModelLoad		( char * objfilename );
+void			ModelDelete		();
 
 #endif // __MODEL_H__
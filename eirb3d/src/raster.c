@@ -0,0 +1,581 @@
+#include "raster.h"
+
+
+#define RASTER_SUBPIXEL_BITS	4
+#define RASTER_SUBPIXEL		( 1 << RASTER_SUBPIXEL_BITS )
+#define RASTER_GUARD_BAND	( 1 << 20 )
+#define RASTER_SAMPLE_SPREAD	6	// Ecart maximal d'un échantillon au centre du pixel, en 1/16 de pixel
+
+// Positions des échantillons autour du centre du pixel (grille tournée), en 1/16 de pixel
+static const int	g_samplex[ WINDOW_SAMPLES ]	= { -2,  6, -6, 2 };
+static const int	g_sampley[ WINDOW_SAMPLES ]	= { -6, -2,  2, 6 };
+
+static int		g_depthtest	= RASTER_DEPTH_LESS;
+static long long	g_fragments	= 0;
+
+/**
+ * Test de profondeur courant ; avec RASTER_DEPTH_EQUAL la profondeur, déjà écrite
+ * par la pré-passe, n'est plus modifiée
+ */
+static inline bool RasterDepthPass( float z, float d, bool equal ) {
+	return equal ? ( z <= d ) : ( z < d );
+}
+
+/**
+ * Une arête est haut-gauche si l'intérieur du triangle est à sa droite, ou si elle
+ * est horizontale avec l'intérieur en dessous (y vers le bas)
+ */
+static bool RasterIsTopLeft( float a, float b ) {
+	return ( a > 0.0f ) || ( a == 0.0f && b > 0.0f );
+}
+
+static void RasterTriangleFloat( window_t * w, vec3f_t v0, vec3f_t v1, vec3f_t v2, Uint32 color ) {
+	float area = ( v1.x - v0.x ) * ( v2.y - v0.y ) - ( v1.y - v0.y ) * ( v2.x - v0.x );
+	if ( area == 0.0f ) {
+		return;
+	}
+	if ( area < 0.0f ) {
+		Vec3fSwap( &v1, &v2 );
+		area = -area;
+	}
+
+	int minx = MAX( (int)floorf( MIN( v0.x, MIN( v1.x, v2.x ) ) ), 0 );
+	int miny = MAX( (int)floorf( MIN( v0.y, MIN( v1.y, v2.y ) ) ), 0 );
+	int maxx = MIN( (int)ceilf( MAX( v0.x, MAX( v1.x, v2.x ) ) ), w->width - 1 );
+	int maxy = MIN( (int)ceilf( MAX( v0.y, MAX( v1.y, v2.y ) ) ), w->height - 1 );
+
+	// Arête i opposée au sommet i : E(p) = A * ( p.x - x ) + B * ( p.y - y )
+	float a0 = v1.y - v2.y, b0 = v2.x - v1.x;
+	float a1 = v2.y - v0.y, b1 = v0.x - v2.x;
+	float a2 = v0.y - v1.y, b2 = v1.x - v0.x;
+	bool t0 = RasterIsTopLeft( a0, b0 ), t1 = RasterIsTopLeft( a1, b1 ), t2 = RasterIsTopLeft( a2, b2 );
+	float inv = 1.0f / area;
+
+	for ( int y = miny; y <= maxy; y++ ) {
+		float py = y + 0.5f;
+		Uint32 * dst = WindowPixels( w, 0, y );
+		float * depth = WindowDepths( w, 0, y );
+		Uint16 * count = ( w->counter != NULL ) ? w->counter + y * w->width : NULL;
+		for ( int x = minx; x <= maxx; x++ ) {
+			float px = x + 0.5f;
+			float e0 = a0 * ( px - v1.x ) + b0 * ( py - v1.y );
+			float e1 = a1 * ( px - v2.x ) + b1 * ( py - v2.y );
+			float e2 = a2 * ( px - v0.x ) + b2 * ( py - v0.y );
+			if ( ( e0 > 0.0f || ( e0 == 0.0f && t0 ) ) && ( e1 > 0.0f || ( e1 == 0.0f && t1 ) ) && ( e2 > 0.0f || ( e2 == 0.0f && t2 ) ) ) {
+				float z = ( e0 * v0.z + e1 * v1.z + e2 * v2.z ) * inv;
+				if ( z < depth[ x ] ) {
+					depth[ x ] = z;
+					dst[ x ] = color;
+					g_fragments++;
+					if ( count != NULL ) count[ x ]++;
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Etat de parcours d'un triangle en virgule fixe, partagé par tous les modes de remplissage
+ */
+typedef struct rastersetup {
+	int			minx, miny, maxx, maxy;
+	long long		w0row, w1row, w2row;
+	long long		dx0, dx1, dx2;
+	long long		dy0, dy1, dy2;
+	float			inv;
+	bool			swapped;
+}rastersetup_t;
+
+/**
+ * Prépare le parcours d'un triangle. Si v1 et v2 sont échangés pour rendre
+ * l'aire positive, swapped est positionné et l'appelant échange ses attributs.
+ * spread élargit la boîte aux pixels dont seul un échantillon peut être couvert.
+ * Retourne faux si aucun pixel ne peut être couvert.
+ */
+static bool RasterSetup( int width, int height, int spread, vec3f_t * v0, vec3f_t * v1, vec3f_t * v2, rastersetup_t * s ) {
+	// Au-delà de la bande de garde, la conversion en virgule fixe n'est plus représentable
+	if ( fabsf( v0->x ) > RASTER_GUARD_BAND || fabsf( v0->y ) > RASTER_GUARD_BAND ||
+	     fabsf( v1->x ) > RASTER_GUARD_BAND || fabsf( v1->y ) > RASTER_GUARD_BAND ||
+	     fabsf( v2->x ) > RASTER_GUARD_BAND || fabsf( v2->y ) > RASTER_GUARD_BAND ) {
+		return false;
+	}
+
+	// Sommets arrondis au 1/16 de pixel : toutes les fonctions d'arête sont exactes
+	int x0 = (int)lrintf( v0->x * RASTER_SUBPIXEL ), y0 = (int)lrintf( v0->y * RASTER_SUBPIXEL );
+	int x1 = (int)lrintf( v1->x * RASTER_SUBPIXEL ), y1 = (int)lrintf( v1->y * RASTER_SUBPIXEL );
+	int x2 = (int)lrintf( v2->x * RASTER_SUBPIXEL ), y2 = (int)lrintf( v2->y * RASTER_SUBPIXEL );
+
+	long long area = (long long)( x1 - x0 ) * ( y2 - y0 ) - (long long)( y1 - y0 ) * ( x2 - x0 );
+	if ( area == 0 ) {
+		return false;
+	}
+	s->swapped = ( area < 0 );
+	if ( s->swapped ) {
+		swap( &x1, &x2 );
+		swap( &y1, &y2 );
+		Vec3fSwap( v1, v2 );
+		area = -area;
+	}
+
+	// Pixels dont le centre ( x * 16 + 8 ), à spread près, est dans la boîte englobante
+	s->minx = MAX( ( MIN( x0, MIN( x1, x2 ) ) + 7 - spread ) >> RASTER_SUBPIXEL_BITS, 0 );
+	s->miny = MAX( ( MIN( y0, MIN( y1, y2 ) ) + 7 - spread ) >> RASTER_SUBPIXEL_BITS, 0 );
+	s->maxx = MIN( ( MAX( x0, MAX( x1, x2 ) ) - 8 + spread ) >> RASTER_SUBPIXEL_BITS, width - 1 );
+	s->maxy = MIN( ( MAX( y0, MAX( y1, y2 ) ) - 8 + spread ) >> RASTER_SUBPIXEL_BITS, height - 1 );
+	if ( s->minx > s->maxx || s->miny > s->maxy ) {
+		return false;
+	}
+
+	int a0 = y1 - y2, b0 = x2 - x1;
+	int a1 = y2 - y0, b1 = x0 - x2;
+	int a2 = y0 - y1, b2 = x1 - x0;
+
+	// Fonctions d'arête au centre du premier pixel ; la règle haut-gauche devient
+	// un biais de -1 sur les arêtes qui ne sont ni en haut ni à gauche
+	long long px = ( (long long)s->minx << RASTER_SUBPIXEL_BITS ) + RASTER_SUBPIXEL / 2;
+	long long py = ( (long long)s->miny << RASTER_SUBPIXEL_BITS ) + RASTER_SUBPIXEL / 2;
+	s->w0row = a0 * ( px - x1 ) + b0 * ( py - y1 ) - ( RasterIsTopLeft( a0, b0 ) ? 0 : 1 );
+	s->w1row = a1 * ( px - x2 ) + b1 * ( py - y2 ) - ( RasterIsTopLeft( a1, b1 ) ? 0 : 1 );
+	s->w2row = a2 * ( px - x0 ) + b2 * ( py - y0 ) - ( RasterIsTopLeft( a2, b2 ) ? 0 : 1 );
+	// Multiplications et non décalages : les coefficients sont souvent négatifs
+	s->dx0 = (long long)a0 * RASTER_SUBPIXEL; s->dy0 = (long long)b0 * RASTER_SUBPIXEL;
+	s->dx1 = (long long)a1 * RASTER_SUBPIXEL; s->dy1 = (long long)b1 * RASTER_SUBPIXEL;
+	s->dx2 = (long long)a2 * RASTER_SUBPIXEL; s->dy2 = (long long)b2 * RASTER_SUBPIXEL;
+	s->inv = 1.0f / (float)area;
+	return true;
+}
+
+/**
+ * Equation de plan d'un attribut a = a0 + l1 * ( a1 - a0 ) + l2 * ( a2 - a0 ) :
+ * valeur au premier pixel et incréments par colonne et par ligne
+ */
+static void RasterPlane( const rastersetup_t * s, float a0, float a1, float a2, float * row, float * dx, float * dy ) {
+	float d1 = a1 - a0, d2 = a2 - a0;
+	*dx  = ( s->dx1 * d1 + s->dx2 * d2 ) * s->inv;
+	*dy  = ( s->dy1 * d1 + s->dy2 * d2 ) * s->inv;
+	*row = a0 + ( s->w1row * d1 + s->w2row * d2 ) * s->inv;
+}
+
+/**
+ * Correction de perspective : a / w et 1 / w sont linéaires à l'écran, contrairement
+ * à a. Les attributs passés à RasterPlane sont donc prémultipliés par les q = 1 / w des
+ * sommets, et l'attribut d'un pixel est retrouvé en divisant par q interpolé.
+ */
+static inline void RasterSwapQ( bool swapped, float * qb, float * qc ) {
+	if ( swapped ) {
+		float q = *qb; *qb = *qc; *qc = q;
+	}
+}
+
+/**
+ * Multi-échantillonnage : décalages des fonctions d'arête et de la profondeur de
+ * chaque échantillon par rapport au centre du pixel
+ */
+typedef struct rastersamples {
+	long long		o0[ WINDOW_SAMPLES ], o1[ WINDOW_SAMPLES ], o2[ WINDOW_SAMPLES ];
+	long long		r0, r1, r2;	// Plus grand décalage de chaque arête, en valeur absolue
+	float			z[ WINDOW_SAMPLES ];
+}rastersamples_t;
+
+static void RasterSamplesSetup( const rastersetup_t * s, float zdx, float zdy, rastersamples_t * m ) {
+	m->r0 = m->r1 = m->r2 = 0;
+	for ( int k = 0; k < WINDOW_SAMPLES; k++ ) {
+		// Les pas par pixel valent 16 fois les coefficients des arêtes : divisions exactes
+		m->o0[ k ] = ( s->dx0 * g_samplex[ k ] + s->dy0 * g_sampley[ k ] ) / RASTER_SUBPIXEL;
+		m->o1[ k ] = ( s->dx1 * g_samplex[ k ] + s->dy1 * g_sampley[ k ] ) / RASTER_SUBPIXEL;
+		m->o2[ k ] = ( s->dx2 * g_samplex[ k ] + s->dy2 * g_sampley[ k ] ) / RASTER_SUBPIXEL;
+		m->z[ k ]  = ( zdx * g_samplex[ k ] + zdy * g_sampley[ k ] ) / RASTER_SUBPIXEL;
+		m->r0 = MAX( m->r0, llabs( m->o0[ k ] ) );
+		m->r1 = MAX( m->r1, llabs( m->o1[ k ] ) );
+		m->r2 = MAX( m->r2, llabs( m->o2[ k ] ) );
+	}
+}
+
+/**
+ * Couverture et test de profondeur des échantillons du pixel dont le centre a pour
+ * fonctions d'arête e0, e1, e2 et pour profondeur z. Retourne le masque des échantillons
+ * retenus, dont la profondeur est mise à jour.
+ */
+static inline int RasterSamplesPass( const rastersamples_t * m, long long e0, long long e1, long long e2, float z, float * depth, bool equal ) {
+	// Pixels loin des arêtes : aucun échantillon, ou tous, sans tester chacun
+	if ( e0 < -m->r0 || e1 < -m->r1 || e2 < -m->r2 ) {
+		return 0;
+	}
+	int covered = 0;
+	if ( e0 >= m->r0 && e1 >= m->r1 && e2 >= m->r2 ) {
+		covered = ( 1 << WINDOW_SAMPLES ) - 1;
+	}else {
+		for ( int k = 0; k < WINDOW_SAMPLES; k++ ) {
+			covered |= ( ( ( e0 + m->o0[ k ] ) | ( e1 + m->o1[ k ] ) | ( e2 + m->o2[ k ] ) ) >= 0 ) << k;
+		}
+		if ( covered == 0 ) {
+			return 0;
+		}
+	}
+#if defined( __SSE2__ )
+	// Les quatre profondeurs testées et mises à jour ensemble
+	__m128 zs = _mm_add_ps( _mm_set1_ps( z ), _mm_loadu_ps( m->z ) );
+	__m128 d = _mm_loadu_ps( depth );
+	int mask = _mm_movemask_ps( equal ? _mm_cmple_ps( zs, d ) : _mm_cmplt_ps( zs, d ) ) & covered;
+	if ( mask != 0 ) {
+		__m128i bits = _mm_set_epi32( 8, 4, 2, 1 );
+		__m128 keep = _mm_castsi128_ps( _mm_cmpeq_epi32( _mm_and_si128( _mm_set1_epi32( mask ), bits ), bits ) );
+		_mm_storeu_ps( depth, _mm_or_ps( _mm_and_ps( keep, zs ), _mm_andnot_ps( keep, d ) ) );
+	}
+	return mask;
+#else
+	int mask = 0;
+	for ( int k = 0; k < WINDOW_SAMPLES; k++ ) {
+		float zs = z + m->z[ k ];
+		if ( ( covered & ( 1 << k ) ) && RasterDepthPass( zs, depth[ k ], equal ) ) {
+			depth[ k ] = zs;
+			mask |= 1 << k;
+		}
+	}
+	return mask;
+#endif
+}
+
+/**
+ * Ecrit la couleur, calculée une seule fois pour le pixel, dans les échantillons retenus
+ */
+static inline void RasterSamplesWrite( Uint32 * dst, int mask, Uint32 color ) {
+	for ( int k = 0; k < WINDOW_SAMPLES; k++ ) {
+		if ( mask & ( 1 << k ) ) {
+			dst[ k ] = color;
+		}
+	}
+}
+
+/**
+ * Ecart des échantillons au centre du pixel pour la fenêtre, à passer à RasterSetup
+ */
+static inline int RasterSpread( const window_t * w ) {
+	return ( w->samples > 1 ) ? RASTER_SAMPLE_SPREAD : 0;
+}
+
+static void RasterTriangleFixed( window_t * w, vec3f_t v0, vec3f_t v1, vec3f_t v2, Uint32 color ) {
+	rastersetup_t s;
+	if ( !RasterSetup( w->width, w->height, RasterSpread( w ), &v0, &v1, &v2, &s ) ) {
+		return;
+	}
+	float zrow, zdx, zdy;
+	RasterPlane( &s, v0.z, v1.z, v2.z, &zrow, &zdx, &zdy );
+	bool ms = ( w->samples > 1 );
+	rastersamples_t m;
+	if ( ms ) {
+		RasterSamplesSetup( &s, zdx, zdy, &m );
+	}
+
+	bool equal = ( g_depthtest == RASTER_DEPTH_EQUAL );
+	int shaded = 0;
+	for ( int y = s.miny; y <= s.maxy; y++ ) {
+		long long e0 = s.w0row, e1 = s.w1row, e2 = s.w2row;
+		Uint32 * dst = WindowPixels( w, 0, y );
+		float * depth = WindowDepths( w, 0, y );
+		Uint32 * sdst = ms ? WindowSamplePixels( w, 0, y ) : NULL;
+		float * sdepth = ms ? WindowSampleDepths( w, 0, y ) : NULL;
+		Uint16 * count = ( w->counter != NULL ) ? w->counter + y * w->width : NULL;
+		for ( int x = s.minx; x <= s.maxx; x++ ) {
+			// z évalué comme dans RasterTriangleDepth, pour une égalité exacte après la pré-passe
+			float z = zrow + ( x - s.minx ) * zdx;
+			if ( ms ) {
+				int mask = RasterSamplesPass( &m, e0, e1, e2, z, sdepth + x * WINDOW_SAMPLES, equal );
+				if ( mask != 0 ) {
+					RasterSamplesWrite( sdst + x * WINDOW_SAMPLES, mask, color );
+					shaded++;
+					if ( count != NULL ) count[ x ]++;
+				}
+			}else if ( ( e0 | e1 | e2 ) >= 0 && RasterDepthPass( z, depth[ x ], equal ) ) {
+				depth[ x ] = z;
+				dst[ x ] = color;
+				shaded++;
+				if ( count != NULL ) count[ x ]++;
+			}
+			e0 += s.dx0; e1 += s.dx1; e2 += s.dx2;
+		}
+		s.w0row += s.dy0; s.w1row += s.dy1; s.w2row += s.dy2;
+		zrow += zdy;
+	}
+	g_fragments += shaded;
+}
+
+void RasterTriangle( window_t * w, vec3f_t a, vec3f_t b, vec3f_t c, Uint32 color, int mode ) {
+	if ( mode == RASTER_FIXED ) {
+		RasterTriangleFixed( w, a, b, c, color );
+	}else {
+		RasterTriangleFloat( w, a, b, c, color );
+	}
+}
+
+void RasterTriangleGouraud( window_t * w, vec3f_t a, vec3f_t b, vec3f_t c, float qa, float qb, float qc, vec3f_t ca, vec3f_t cb, vec3f_t cc ) {
+	rastersetup_t s;
+	if ( !RasterSetup( w->width, w->height, RasterSpread( w ), &a, &b, &c, &s ) ) {
+		return;
+	}
+	if ( s.swapped ) {
+		Vec3fSwap( &cb, &cc );
+	}
+	RasterSwapQ( s.swapped, &qb, &qc );
+	float zrow, zdx, zdy, qrow, qdx, qdy, rrow, rdx, rdy, grow, gdx, gdy, brow, bdx, bdy;
+	RasterPlane( &s, a.z, b.z, c.z, &zrow, &zdx, &zdy );
+	RasterPlane( &s, qa, qb, qc, &qrow, &qdx, &qdy );
+	RasterPlane( &s, ca.x * qa, cb.x * qb, cc.x * qc, &rrow, &rdx, &rdy );
+	RasterPlane( &s, ca.y * qa, cb.y * qb, cc.y * qc, &grow, &gdx, &gdy );
+	RasterPlane( &s, ca.z * qa, cb.z * qb, cc.z * qc, &brow, &bdx, &bdy );
+	bool ms = ( w->samples > 1 );
+	rastersamples_t m;
+	if ( ms ) {
+		RasterSamplesSetup( &s, zdx, zdy, &m );
+	}
+
+	bool equal = ( g_depthtest == RASTER_DEPTH_EQUAL );
+	int shaded = 0;
+	for ( int y = s.miny; y <= s.maxy; y++ ) {
+		long long e0 = s.w0row, e1 = s.w1row, e2 = s.w2row;
+		float q = qrow, r = rrow, g = grow, bl = brow;
+		Uint32 * dst = WindowPixels( w, 0, y );
+		float * depth = WindowDepths( w, 0, y );
+		Uint32 * sdst = ms ? WindowSamplePixels( w, 0, y ) : NULL;
+		float * sdepth = ms ? WindowSampleDepths( w, 0, y ) : NULL;
+		Uint16 * count = ( w->counter != NULL ) ? w->counter + y * w->width : NULL;
+		for ( int x = s.minx; x <= s.maxx; x++ ) {
+			float z = zrow + ( x - s.minx ) * zdx;
+			int mask = 0;
+			if ( ms ) {
+				mask = RasterSamplesPass( &m, e0, e1, e2, z, sdepth + x * WINDOW_SAMPLES, equal );
+			}else if ( ( e0 | e1 | e2 ) >= 0 && RasterDepthPass( z, depth[ x ], equal ) ) {
+				depth[ x ] = z;
+				mask = 1;
+			}
+			if ( mask != 0 ) {
+				shaded++;
+				if ( count != NULL ) count[ x ]++;
+				// Une seule division par fragment visible, partagée par les trois composantes ;
+				// bornée car le centre d'un pixel multi-échantillonné peut sortir du triangle
+				float inv = 1.0f / q;
+				Uint32 color = WindowColor( (Uint8)MIN( MAX( r * inv, 0.0f ), 255.0f ), (Uint8)MIN( MAX( g * inv, 0.0f ), 255.0f ), (Uint8)MIN( MAX( bl * inv, 0.0f ), 255.0f ) );
+				if ( ms ) {
+					RasterSamplesWrite( sdst + x * WINDOW_SAMPLES, mask, color );
+				}else {
+					dst[ x ] = color;
+				}
+			}
+			e0 += s.dx0; e1 += s.dx1; e2 += s.dx2;
+			q += qdx; r += rdx; g += gdx; bl += bdx;
+		}
+		s.w0row += s.dy0; s.w1row += s.dy1; s.w2row += s.dy2;
+		zrow += zdy; qrow += qdy; rrow += rdy; grow += gdy; brow += bdy;
+	}
+	g_fragments += shaded;
+}
+
+
+void RasterTrianglePhong( window_t * w, vec3f_t a, vec3f_t b, vec3f_t c, float qa, float qb, float qc, vec3f_t na, vec3f_t nb, vec3f_t nc, const light_t * l ) {
+	rastersetup_t s;
+	if ( !RasterSetup( w->width, w->height, RasterSpread( w ), &a, &b, &c, &s ) ) {
+		return;
+	}
+	if ( s.swapped ) {
+		Vec3fSwap( &nb, &nc );
+	}
+	RasterSwapQ( s.swapped, &qb, &qc );
+	// L'éclairage normalise la normale : n / w a la bonne direction, sans aucune division
+	float zrow, zdx, zdy, xrow, xdx, xdy, yrow, ydx, ydy, nzrow, nzdx, nzdy;
+	RasterPlane( &s, a.z, b.z, c.z, &zrow, &zdx, &zdy );
+	RasterPlane( &s, na.x * qa, nb.x * qb, nc.x * qc, &xrow, &xdx, &xdy );
+	RasterPlane( &s, na.y * qa, nb.y * qb, nc.y * qc, &yrow, &ydx, &ydy );
+	RasterPlane( &s, na.z * qa, nb.z * qb, nc.z * qc, &nzrow, &nzdx, &nzdy );
+	bool ms = ( w->samples > 1 );
+	rastersamples_t m;
+	if ( ms ) {
+		RasterSamplesSetup( &s, zdx, zdy, &m );
+	}
+
+	bool equal = ( g_depthtest == RASTER_DEPTH_EQUAL );
+	int shaded = 0;
+	for ( int y = s.miny; y <= s.maxy; y++ ) {
+		long long e0 = s.w0row, e1 = s.w1row, e2 = s.w2row;
+		Uint32 * dst = WindowPixels( w, 0, y );
+		float * depth = WindowDepths( w, 0, y );
+		Uint32 * sdst = ms ? WindowSamplePixels( w, 0, y ) : NULL;
+		float * sdepth = ms ? WindowSampleDepths( w, 0, y ) : NULL;
+		Uint16 * count = ( w->counter != NULL ) ? w->counter + y * w->width : NULL;
+#if defined( __SSE2__ )
+		// Couverture et profondeur testées par pixel, éclairage par groupes de quatre pixels
+		__m128 lane = _mm_set_ps( 3.0f, 2.0f, 1.0f, 0.0f );
+		__m128 nx = _mm_add_ps( _mm_set1_ps( xrow ), _mm_mul_ps( lane, _mm_set1_ps( xdx ) ) );
+		__m128 ny = _mm_add_ps( _mm_set1_ps( yrow ), _mm_mul_ps( lane, _mm_set1_ps( ydx ) ) );
+		__m128 nz = _mm_add_ps( _mm_set1_ps( nzrow ), _mm_mul_ps( lane, _mm_set1_ps( nzdx ) ) );
+		__m128 nxstep = _mm_set1_ps( 4.0f * xdx ), nystep = _mm_set1_ps( 4.0f * ydx ), nzstep = _mm_set1_ps( 4.0f * nzdx );
+		for ( int x = s.minx; x <= s.maxx; x += 4 ) {
+			int mask = 0;
+			int samples[ 4 ];
+			int n = MIN( 4, s.maxx - x + 1 );
+			for ( int k = 0; k < n; k++ ) {
+				float z = zrow + ( x + k - s.minx ) * zdx;
+				samples[ k ] = 0;
+				if ( ms ) {
+					samples[ k ] = RasterSamplesPass( &m, e0, e1, e2, z, sdepth + ( x + k ) * WINDOW_SAMPLES, equal );
+				}else if ( ( e0 | e1 | e2 ) >= 0 && RasterDepthPass( z, depth[ x + k ], equal ) ) {
+					depth[ x + k ] = z;
+					samples[ k ] = 1;
+				}
+				if ( samples[ k ] != 0 ) {
+					mask |= 1 << k;
+					shaded++;
+					if ( count != NULL ) count[ x + k ]++;
+				}
+				e0 += s.dx0; e1 += s.dx1; e2 += s.dx2;
+			}
+			if ( mask != 0 ) {
+				Uint32 colors[ 4 ] __attribute__( ( aligned( 16 ) ) );
+				_mm_store_si128( (__m128i*)colors, LightShade4( l, nx, ny, nz ) );
+				for ( int k = 0; k < n; k++ ) {
+					if ( !( mask & ( 1 << k ) ) ) {
+						continue;
+					}
+					if ( ms ) {
+						RasterSamplesWrite( sdst + ( x + k ) * WINDOW_SAMPLES, samples[ k ], colors[ k ] );
+					}else {
+						dst[ x + k ] = colors[ k ];
+					}
+				}
+			}
+			nx = _mm_add_ps( nx, nxstep ); ny = _mm_add_ps( ny, nystep ); nz = _mm_add_ps( nz, nzstep );
+		}
+#else
+		vec3f_t n = Vec3f( xrow, yrow, nzrow );
+		for ( int x = s.minx; x <= s.maxx; x++ ) {
+			float z = zrow + ( x - s.minx ) * zdx;
+			int mask = 0;
+			if ( ms ) {
+				mask = RasterSamplesPass( &m, e0, e1, e2, z, sdepth + x * WINDOW_SAMPLES, equal );
+			}else if ( ( e0 | e1 | e2 ) >= 0 && RasterDepthPass( z, depth[ x ], equal ) ) {
+				depth[ x ] = z;
+				mask = 1;
+			}
+			if ( mask != 0 ) {
+				vec3f_t col = LightShade( l, n );
+				Uint32 color = WindowColor( (Uint8)col.x, (Uint8)col.y, (Uint8)col.z );
+				if ( ms ) {
+					RasterSamplesWrite( sdst + x * WINDOW_SAMPLES, mask, color );
+				}else {
+					dst[ x ] = color;
+				}
+				shaded++;
+				if ( count != NULL ) count[ x ]++;
+			}
+			e0 += s.dx0; e1 += s.dx1; e2 += s.dx2;
+			n.x += xdx; n.y += ydx; n.z += nzdx;
+		}
+#endif
+		s.w0row += s.dy0; s.w1row += s.dy1; s.w2row += s.dy2;
+		zrow += zdy; xrow += xdy; yrow += ydy; nzrow += nzdy;
+	}
+	g_fragments += shaded;
+}
+
+void RasterTriangleGBuffer( window_t * w, gbuffer_t * g, vec3f_t a, vec3f_t b, vec3f_t c, float qa, float qb, float qc, vec3f_t na, vec3f_t nb, vec3f_t nc, vec2f_t ta, vec2f_t tb, vec2f_t tc, int material ) {
+	rastersetup_t s;
+	if ( !RasterSetup( w->width, w->height, 0, &a, &b, &c, &s ) ) {
+		return;
+	}
+	if ( s.swapped ) {
+		Vec3fSwap( &nb, &nc );
+		Vec2fSwap( &tb, &tc );
+	}
+	RasterSwapQ( s.swapped, &qb, &qc );
+	// La normale est normalisée à la compression : seules les coordonnées de texture sont divisées par q
+	float zrow, zdx, zdy, qrow, qdx, qdy, xrow, xdx, xdy, yrow, ydx, ydy, nzrow, nzdx, nzdy, urow, udx, udy, vrow, vdx, vdy;
+	RasterPlane( &s, a.z, b.z, c.z, &zrow, &zdx, &zdy );
+	RasterPlane( &s, qa, qb, qc, &qrow, &qdx, &qdy );
+	RasterPlane( &s, na.x * qa, nb.x * qb, nc.x * qc, &xrow, &xdx, &xdy );
+	RasterPlane( &s, na.y * qa, nb.y * qb, nc.y * qc, &yrow, &ydx, &ydy );
+	RasterPlane( &s, na.z * qa, nb.z * qb, nc.z * qc, &nzrow, &nzdx, &nzdy );
+	RasterPlane( &s, ta.x * qa, tb.x * qb, tc.x * qc, &urow, &udx, &udy );
+	RasterPlane( &s, ta.y * qa, tb.y * qb, tc.y * qc, &vrow, &vdx, &vdy );
+
+	bool equal = ( g_depthtest == RASTER_DEPTH_EQUAL );
+	int shaded = 0;
+	for ( int y = s.miny; y <= s.maxy; y++ ) {
+		long long e0 = s.w0row, e1 = s.w1row, e2 = s.w2row;
+		float * depth = WindowDepths( w, 0, y );
+		Uint16 * count = ( w->counter != NULL ) ? w->counter + y * w->width : NULL;
+		Uint32 * normal = g->normal + y * g->width;
+		Uint32 * surface = g->surface + y * g->width;
+		for ( int x = s.minx; x <= s.maxx; x++ ) {
+			// Les attributs ne sont évalués que pour les fragments qui passent le test de profondeur
+			if ( ( e0 | e1 | e2 ) >= 0 ) {
+				float dx = (float)( x - s.minx );
+				float z = zrow + dx * zdx;
+				if ( RasterDepthPass( z, depth[ x ], equal ) ) {
+					depth[ x ] = z;
+					shaded++;
+					if ( count != NULL ) count[ x ]++;
+					float inv = 1.0f / ( qrow + dx * qdx );
+					normal[ x ]  = GBufferPackNormal( Vec3f( xrow + dx * xdx, yrow + dx * ydx, nzrow + dx * nzdx ) );
+					surface[ x ] = GBufferPackSurface( ( urow + dx * udx ) * inv, ( vrow + dx * vdx ) * inv, material );
+				}
+			}
+			e0 += s.dx0; e1 += s.dx1; e2 += s.dx2;
+		}
+		s.w0row += s.dy0; s.w1row += s.dy1; s.w2row += s.dy2;
+		zrow += zdy; qrow += qdy; xrow += xdy; yrow += ydy; nzrow += nzdy; urow += udy; vrow += vdy;
+	}
+	g_fragments += shaded;
+}
+
+/**
+ * Premier et dernier pas k >= 0 tels que row + k * dx >= 0, bornés à [0, n]
+ * (kmin > kmax si aucun)
+ */
+static void RasterEdgeSpan( long long row, long long dx, int n, int * kmin, int * kmax ) {
+	if ( dx > 0 ) {
+		if ( row < 0 ) {
+			*kmin = MAX( *kmin, (int)MIN( ( -row + dx - 1 ) / dx, (long long)n + 1 ) );
+		}
+	}else if ( dx < 0 ) {
+		*kmax = ( row < 0 ) ? -1 : MIN( *kmax, (int)MIN( row / -dx, (long long)n ) );
+	}else if ( row < 0 ) {
+		*kmax = -1;
+	}
+}
+
+void RasterTriangleDepth( float * depth, int width, int height, vec3f_t a, vec3f_t b, vec3f_t c ) {
+	rastersetup_t s;
+	if ( !RasterSetup( width, height, 0, &a, &b, &c, &s ) ) {
+		return;
+	}
+	float zrow, zdx, zdy;
+	RasterPlane( &s, a.z, b.z, c.z, &zrow, &zdx, &zdy );
+
+	int n = s.maxx - s.minx;
+	for ( int y = s.miny; y <= s.maxy; y++ ) {
+		// L'intervalle couvert de la ligne est résolu pour les trois arêtes :
+		// la boucle interne ne fait plus que le test de profondeur
+		int kmin = 0, kmax = n;
+		RasterEdgeSpan( s.w0row, s.dx0, n, &kmin, &kmax );
+		RasterEdgeSpan( s.w1row, s.dx1, n, &kmin, &kmax );
+		RasterEdgeSpan( s.w2row, s.dx2, n, &kmin, &kmax );
+		float * row = depth + y * width + s.minx;
+		for ( int k = kmin; k <= kmax; k++ ) {
+			float z = zrow + k * zdx;
+			row[ k ] = ( z < row[ k ] ) ? z : row[ k ];
+		}
+		s.w0row += s.dy0; s.w1row += s.dy1; s.w2row += s.dy2;
+		zrow += zdy;
+	}
+}
+
+void RasterDepthTest( int test ) {
+	g_depthtest = test;
+}
+
+long long RasterFragments() {
+	return g_fragments;
+}
+
+void RasterResetFragments() {
+	g_fragments = 0;
+}
@@ -0,0 +1,82 @@
+#ifndef __RASTER_H__
+#define __RASTER_H__
+
+#include "window.h"
+#include "geometry.h"
+#include "light.h"
+#include "gbuffer.h"
+
+/**
+ * Dfinition des modes de rasterisation
+ */
+#define RASTER_FLOAT		0	// Fonctions d'arte flottantes
+#define RASTER_FIXED		1	// Sommets en virgule fixe 28.4, fonctions d'arte entires exactes
+
+/**
+ * Dfinition des tests de profondeur des remplissages en virgule fixe
+ */
+#define RASTER_DEPTH_LESS	0	// Plus proche que le zbuffer, qui est mis  jour
+#define RASTER_DEPTH_EQUAL	1	// Egal au zbuffer rempli par une pr-passe RasterTriangleDepth
+
+/**
+ * Dfinition des prototypes de fonctions
+ */
+
+/**
+ * Remplit un triangle en coordonnes cran (x, y en pixels, z profondeur dans [0,1])
+ * avec test de profondeur. Les pixels dont le centre est sur une arte partage ne
+ * sont dessins que par l'un des deux triangles (rgle haut-gauche).
+ *
+ * Si la fentre est multi-chantillonne, les remplissages en virgule fixe (sauf
+ * RasterTriangleGBuffer) testent couverture et profondeur par chantillon mais ne
+ * calculent qu'une couleur par pixel, au centre ; le mode RASTER_FLOAT l'ignore.
+ */
+void			RasterTriangle		( window_t * w, vec3f_t a, vec3f_t b, vec3f_t c, Uint32 color, int mode );
+
+/**
+ * Les remplissages suivants interpolent leurs attributs avec correction de perspective :
+ * qa, qb et qc sont les inverses des w de clip des sommets a, b et c
+ */
+
+/**
+ * Remplit un triangle en virgule fixe en interpolant les couleurs de ses sommets
+ * (composantes dans [0,255])
+ */
+void			RasterTriangleGouraud	( window_t * w, vec3f_t a, vec3f_t b, vec3f_t c, float qa, float qb, float qc, vec3f_t ca, vec3f_t cb, vec3f_t cc );
+
+/**
+ * Remplit un triangle en virgule fixe en interpolant les normales de ses sommets
+ * et en clairant chaque pixel
+ */
+void			RasterTrianglePhong	( window_t * w, vec3f_t a, vec3f_t b, vec3f_t c, float qa, float qb, float qc, vec3f_t na, vec3f_t nb, vec3f_t nc, const light_t * l );
+
+/**
+ * Remplit un triangle en virgule fixe dans le tampon gomtrique : profondeur,
+ * normale interpole et surface, sans aucun clairage
+ */
+void			RasterTriangleGBuffer	( window_t * w, gbuffer_t * g, vec3f_t a, vec3f_t b, vec3f_t c, float qa, float qb, float qc, vec3f_t na, vec3f_t nb, vec3f_t nc, vec2f_t ta, vec2f_t tb, vec2f_t tc, int material );
+
+/**
+ * Remplit un triangle en virgule fixe dans un tampon de profondeur seul (carte d'ombre,
+ * pr-passe de profondeur) : ni couleur ni attribut, l'intervalle couvert de chaque
+ * ligne est calcul directement
+ */
+void			RasterTriangleDepth	( float * depth, int width, int height, vec3f_t a, vec3f_t b, vec3f_t c );
+
+/**
+ * Choisit le test de profondeur des remplissages en virgule fixe
+ */
+void			RasterDepthTest		( int test );
+
+/**
+ * Retourne le nombre de fragments colors (ou crits dans le tampon gomtrique)
+ * depuis la dernire remise  zro
+ */
+long long		RasterFragments		();
+
+/**
+ * Remet  zro le compteur de fragments
+ */
+void			RasterResetFragments	();
+
+#endif //__RASTER_H__
@@ -0,0 +1,526 @@
+#include "render.h"
+#include "raster.h"
+#include "model.h"
+#include "deferred.h"
+#include "arena.h"
+#include "bvh.h"
+
+render_t g_render = { RASTER_FIXED, false, false, RENDER_PHONG, { 0.5f, 0.8f, 1.0f }, false, NULL, 0, true, false, false, false, false, false, false, false, RENDER_LOD_AUTO };
+renderstats_t g_stats = { 0, 0, 0, { 0, 0, 0, 0 }, 0, 0 };
+
+// Etat de la dernière trame vérifiée par RenderChanged
+static camera_t		g_lastcamera;
+static render_t		g_lastrender;
+static int		g_lastwidth	= 0;
+static int		g_lastheight	= 0;
+static bool		g_invalid	= true;
+
+// Sommets transformés de la trame courante, calculés à la demande
+static vec4f_t	*	g_transformed	= NULL;
+static vec3f_t	*	g_lit		= NULL;
+static int	*	g_stamp		= NULL;
+static int		g_capacity	= 0;
+static int		g_frame		= 0;
+
+// Maillages dessinés par la trame : le niveau de détail choisi, ou les morceaux chargés,
+// avec leurs groupes visibles
+typedef struct renderpart {
+	mesh_t		*	mesh;
+	clusters_t	*	clusters;
+	int		*	visible;
+	int			nvisible;
+}renderpart_t;
+static renderpart_t	*	g_parts		= NULL;
+
+// Sommet d'un triangle à découper, avec les attributs interpolés par les remplissages
+typedef struct renderclip {
+	vec4f_t			pos;
+	vec3f_t			norm;
+	vec2f_t			uv;
+	vec3f_t			color;		// Eclairage aux sommets (Gouraud)
+}renderclip_t;
+
+// Listes de la trame, dont la taille varie d'une trame à l'autre : l'arène est remise à
+// zéro au début de chaque trame
+static arena_t		*	g_framearena	= NULL;
+
+// Extrémités des arêtes projetées pour le mode fil de fer
+static vec4f_t	*	g_wirepos	= NULL;
+static vec2i_t	*	g_wirelines	= NULL;
+static vec2f_t	*	g_wirelinesf	= NULL;
+static int		g_wirecapacity	= 0;
+static int		g_wirepositions	= 0;
+
+// Tampon géométrique du rendu différé, à la taille de la fenêtre
+static gbuffer_t	*	g_gbuffer	= NULL;
+static shadowmap_t	*	g_shadow	= NULL;
+
+render_t * RenderOptions() {
+	return &g_render;
+}
+
+renderstats_t * RenderStats() {
+	return &g_stats;
+}
+
+bool RenderChanged( window_t * w, camera_t * c ) {
+	bool resized = ( w->width != g_lastwidth || w->height != g_lastheight );
+	bool changed = g_invalid || resized || memcmp( c, &g_lastcamera, sizeof( camera_t ) ) != 0 || memcmp( &g_render, &g_lastrender, sizeof( render_t ) ) != 0;
+	// Un framebuffer réalloué ne contient plus rien de la trame précédente
+	if ( resized ) {
+		g_stats.drawn.x = 0;
+		g_stats.drawn.y = 0;
+		g_stats.drawn.w = w->width;
+		g_stats.drawn.h = w->height;
+	}
+	memcpy( &g_lastcamera, c, sizeof( camera_t ) );
+	memcpy( &g_lastrender, &g_render, sizeof( render_t ) );
+	g_lastwidth  = w->width;
+	g_lastheight = w->height;
+	g_invalid    = false;
+	return changed;
+}
+
+void RenderInvalidate() {
+	g_invalid = true;
+}
+
+/**
+ * Rectangle écran [x0, x1] x [y0, y1] élargi de la marge, arrondi aux tuiles englobantes
+ * et découpé contre la fenêtre ; vide si x0 > x1
+ */
+static SDL_Rect RenderTiles( window_t * w, float x0, float y0, float x1, float y1 ) {
+	SDL_Rect r = { 0, 0, 0, 0 };
+	if ( x0 > x1 || y0 > y1 ) {
+		return r;
+	}
+	// Bornes flottantes ramenées près de la fenêtre avant conversion en entiers
+	int ix0 = (int)floorf( MAX( x0, -1.0f ) ) - RENDER_DIRTY_MARGIN;
+	int iy0 = (int)floorf( MAX( y0, -1.0f ) ) - RENDER_DIRTY_MARGIN;
+	int ix1 = (int)ceilf( MIN( x1, (float)w->width ) ) + RENDER_DIRTY_MARGIN + 1;
+	int iy1 = (int)ceilf( MIN( y1, (float)w->height ) ) + RENDER_DIRTY_MARGIN + 1;
+	r.x = MAX( ix0, 0 ) / RENDER_DIRTY_TILE * RENDER_DIRTY_TILE;
+	r.y = MAX( iy0, 0 ) / RENDER_DIRTY_TILE * RENDER_DIRTY_TILE;
+	r.w = MIN( ( ix1 + RENDER_DIRTY_TILE - 1 ) / RENDER_DIRTY_TILE * RENDER_DIRTY_TILE, w->width ) - r.x;
+	r.h = MIN( ( iy1 + RENDER_DIRTY_TILE - 1 ) / RENDER_DIRTY_TILE * RENDER_DIRTY_TILE, w->height ) - r.y;
+	if ( r.w <= 0 || r.h <= 0 ) {
+		r.w = r.h = 0;
+	}
+	return r;
+}
+
+/**
+ * Agrandit les tableaux de sommets transformés pour le maillage m. En cas d'échec ils sont
+ * vidés : seuls les maillages d'au plus g_capacity sommets peuvent être dessinés.
+ */
+static void RenderReserve( mesh_t * m ) {
+	// Les niveaux de détail et les morceaux se partagent ces tableaux : seul le plus grand compte
+	if ( g_capacity < m->nvertices ) {
+		free( g_transformed );
+		free( g_lit );
+		free( g_stamp );
+		g_transformed = (vec4f_t*)malloc( sizeof( vec4f_t ) * m->nvertices );
+		g_lit         = (vec3f_t*)malloc( sizeof( vec3f_t ) * m->nvertices );
+		g_stamp       = (int*)calloc( m->nvertices, sizeof( int ) );
+		if ( g_transformed == NULL || g_lit == NULL || g_stamp == NULL ) {
+			printf( "(EE) Unable to allocate %d transformed vertices\n", m->nvertices );
+			free( g_transformed );
+			free( g_lit );
+			free( g_stamp );
+			g_transformed = NULL;
+			g_lit         = NULL;
+			g_stamp       = NULL;
+			g_capacity    = 0;
+			return;
+		}
+		g_capacity    = m->nvertices;
+	}
+}
+
+/**
+ * Découpe un triangle contre le plan proche ( z >= 0 après viewport ).
+ * Retourne le nombre de sommets du polygone obtenu (0, 3 ou 4), dont les attributs sont
+ * interpolés avec le même t que la position, avant la division perspective.
+ */
+static int RenderClipNear( const renderclip_t * in, renderclip_t * out ) {
+	int n = 0;
+	for ( int i = 0; i < 3; i++ ) {
+		const renderclip_t * a = &in[ i ];
+		const renderclip_t * b = &in[ ( i + 1 ) % 3 ];
+		if ( a->pos.z >= 0.0f ) {
+			out[ n++ ] = *a;
+		}
+		if ( ( a->pos.z >= 0.0f ) != ( b->pos.z >= 0.0f ) ) {
+			float t = a->pos.z / ( a->pos.z - b->pos.z );
+			out[ n ].pos.x = a->pos.x + t * ( b->pos.x - a->pos.x );
+			out[ n ].pos.y = a->pos.y + t * ( b->pos.y - a->pos.y );
+			out[ n ].pos.z = 0.0f;
+			out[ n ].pos.w = a->pos.w + t * ( b->pos.w - a->pos.w );
+			out[ n ].norm  = Vec3fAdd( a->norm, Vec3fScale( Vec3fSub( b->norm, a->norm ), t ) );
+			out[ n ].color = Vec3fAdd( a->color, Vec3fScale( Vec3fSub( b->color, a->color ), t ) );
+			out[ n ].uv.x  = a->uv.x + t * ( b->uv.x - a->uv.x );
+			out[ n ].uv.y  = a->uv.y + t * ( b->uv.y - a->uv.y );
+			n++;
+		}
+	}
+	return n;
+}
+
+static vec3f_t RenderProject( vec4f_t v ) {
+	float inv = 1.0f / v.w;
+	return Vec3f( v.x * inv, v.y * inv, v.z * inv );
+}
+
+/**
+ * Dessine chaque arête unique du modèle une seule fois : toutes les positions sont
+ * transformées en bloc, puis les segments sont tracés en un seul lot
+ */
+static void RenderWireframe( window_t * w, camera_t * c ) {
+	edges_t * e = ModelEdges();
+	// Positions et arêtes sont agrandies séparément, leurs nombres ne varient pas ensemble
+	if ( g_wirepositions < e->npositions || g_wirepos == NULL ) {
+		free( g_wirepos );
+		g_wirepos       = (vec4f_t*)malloc( sizeof( vec4f_t ) * MAX( e->npositions, 1 ) );
+		g_wirepositions = ( g_wirepos != NULL ) ? e->npositions : 0;
+	}
+	if ( g_wirecapacity < e->count || g_wirelines == NULL || g_wirelinesf == NULL ) {
+		free( g_wirelines );
+		free( g_wirelinesf );
+		g_wirelines    = (vec2i_t*)malloc( sizeof( vec2i_t ) * 2 * MAX( e->count, 1 ) );
+		g_wirelinesf   = (vec2f_t*)malloc( sizeof( vec2f_t ) * 2 * MAX( e->count, 1 ) );
+		g_wirecapacity = e->count;
+		if ( g_wirelines == NULL || g_wirelinesf == NULL ) {
+			free( g_wirelines );
+			free( g_wirelinesf );
+			g_wirelines    = NULL;
+			g_wirelinesf   = NULL;
+			g_wirecapacity = 0;
+		}
+	}
+	if ( g_wirepos == NULL || g_wirelines == NULL || g_wirelinesf == NULL ) {
+		printf( "(EE) Unable to allocate wireframe of %d edges\n", e->count );
+		g_stats.drawn.x = g_stats.drawn.y = g_stats.drawn.w = g_stats.drawn.h = 0;
+		return;
+	}
+
+	matrixf_t screen = CameraScreen( c, w->width, w->height );
+	for ( int i = 0; i < e->npositions; i++ ) {
+		g_wirepos[ i ] = MatrixfTransform( screen, e->positions[ i ] );
+	}
+	MatrixfDelete( screen, 4 );
+
+	int n = 0;
+	for ( int i = 0; i < e->count; i++ ) {
+		vec4f_t a = g_wirepos[ e->indices[ i * 2 ] ];
+		vec4f_t b = g_wirepos[ e->indices[ i * 2 + 1 ] ];
+		if ( a.z < 0.0f && b.z < 0.0f ) {
+			continue;
+		}
+		// Découpe contre le plan proche ( z >= 0 après viewport )
+		if ( a.z < 0.0f || b.z < 0.0f ) {
+			float t = a.z / ( a.z - b.z );
+			vec4f_t p;
+			p.x = a.x + t * ( b.x - a.x );
+			p.y = a.y + t * ( b.y - a.y );
+			p.z = 0.0f;
+			p.w = a.w + t * ( b.w - a.w );
+			if ( a.z < 0.0f ) a = p; else b = p;
+		}
+		vec3f_t sa = RenderProject( a ), sb = RenderProject( b );
+		g_wirelinesf[ n * 2 ].x = sa.x;		g_wirelinesf[ n * 2 ].y = sa.y;
+		g_wirelinesf[ n * 2 + 1 ].x = sb.x;	g_wirelinesf[ n * 2 + 1 ].y = sb.y;
+		n++;
+	}
+
+	float minx = HUGE_VALF, miny = HUGE_VALF, maxx = -HUGE_VALF, maxy = -HUGE_VALF;
+	for ( int i = 0; i < n * 2; i++ ) {
+		minx = MIN( minx, g_wirelinesf[ i ].x );
+		miny = MIN( miny, g_wirelinesf[ i ].y );
+		maxx = MAX( maxx, g_wirelinesf[ i ].x );
+		maxy = MAX( maxy, g_wirelinesf[ i ].y );
+	}
+	g_stats.drawn = RenderTiles( w, minx, miny, maxx, maxy );
+
+	Uint32 color = WindowColor( 200, 200, 200 );
+	if ( g_render.antialias ) {
+		WindowDrawLinesAA( w, g_wirelinesf, n, color );
+	}else {
+		// Les coordonnées sont bornées avant conversion, le découpage se fait ensuite en entiers
+		for ( int i = 0; i < n * 2; i++ ) {
+			g_wirelines[ i ].x = (int)lrintf( MIN( MAX( g_wirelinesf[ i ].x, -1e6f ), 1e6f ) );
+			g_wirelines[ i ].y = (int)lrintf( MIN( MAX( g_wirelinesf[ i ].y, -1e6f ), 1e6f ) );
+		}
+		WindowDrawLines( w, g_wirelines, n, color );
+	}
+}
+
+/**
+ * Remplit g_parts avec les maillages à dessiner et retourne leur nombre, -1 sans modèle
+ */
+static int RenderParts( window_t * w, camera_t * c ) {
+	g_stats.lod = 0;
+
+	// Modèle lu par morceaux : seuls ceux déjà chargés et dans le champ sont dessinés, du
+	// plus proche au plus lointain, les autres sont demandés au chargeur sans l'attendre
+	stream_t * s = ModelStream();
+	if ( s != NULL ) {
+		StreamUpdate( s, c );
+		g_parts = (renderpart_t*)ArenaAlloc( g_framearena, sizeof( renderpart_t ) * MAX( s->ndrawn, 1 ) );
+		if ( g_parts == NULL ) {
+			return -1;
+		}
+		for ( int i = 0; i < s->ndrawn; i++ ) {
+			g_parts[ i ].mesh     = s->chunks[ s->drawn[ i ] ].mesh;
+			g_parts[ i ].clusters = s->chunks[ s->drawn[ i ] ].clusters;
+		}
+		return s->ndrawn;
+	}
+
+	mesh_t * m = ModelMesh();
+	clusters_t * cl = ModelClusters();
+	if ( m == NULL || cl == NULL ) {
+		return -1;
+	}
+	// Niveau de détail le plus simple dont l'écart reste invisible à cette distance
+	lods_t * lods = ModelLods();
+	if ( lods != NULL ) {
+		g_stats.lod = ( g_render.lod == RENDER_LOD_AUTO ) ? LodsSelect( lods, c, w->height ) : MIN( g_render.lod, lods->count - 1 );
+		m  = lods->levels[ g_stats.lod ].mesh;
+		cl = lods->levels[ g_stats.lod ].clusters;
+	}
+	g_parts = (renderpart_t*)ArenaAlloc( g_framearena, sizeof( renderpart_t ) );
+	if ( g_parts == NULL ) {
+		return -1;
+	}
+	g_parts[ 0 ].mesh     = m;
+	g_parts[ 0 ].clusters = cl;
+	return 1;
+}
+
+void RenderModel( window_t * w, camera_t * c ) {
+	// Seuls les remplissages directs savent écrire dans les échantillons : les autres modes
+	// repassent à un échantillon par pixel
+	// Sans arêtes (modèle lu par morceaux), le fil de fer se rabat sur les faces pleines
+	bool wireframe = g_render.wireframe && ModelEdges() != NULL;
+	bool msaa = g_render.msaa && !wireframe && !g_render.deferred && !g_render.heatmap;
+	WindowSamples( w, msaa ? WINDOW_SAMPLES : 1 );
+	if ( wireframe ) {
+		RenderWireframe( w, c );
+		return;
+	}
+	if ( g_framearena == NULL && ( g_framearena = Arena( ARENA_BLOCK ) ) == NULL ) {
+		return;
+	}
+	ArenaReset( g_framearena );
+	int nparts = RenderParts( w, c );
+	if ( nparts < 0 ) {
+		return;
+	}
+	g_stats.triangles = 0;
+	for ( int p = 0; p < nparts; p++ ) {
+		g_stats.triangles += g_parts[ p ].mesh->nindices / 3;
+		RenderReserve( g_parts[ p ].mesh );
+	}
+	// Les index de sommets sont propres à chaque maillage : chacun a sa marque de trame
+	// pour les sommets transformés, gardée d'une passe à l'autre
+	int stamp = g_frame + 1;
+	g_frame += MAX( nparts, 1 );
+
+	matrixf_t screen = CameraScreen( c, w->width, w->height );
+	frustum_t f = CameraFrustum( c );
+	light_t light = Light( g_render.light, Vec3fSub( c->eye, c->center ), Vec3f( 1.0f, 1.0f, 1.0f ) );
+	bool gouraud = ( g_render.shading == RENDER_GOURAUD ) && !g_render.deferred;
+	if ( g_render.deferred && ( g_gbuffer == NULL || g_gbuffer->width != w->width || g_gbuffer->height != w->height ) ) {
+		GBufferDelete( g_gbuffer );
+		g_gbuffer = GBuffer( w->width, w->height );
+		if ( g_gbuffer == NULL ) {
+			MatrixfDelete( screen, 4 );
+			return;
+		}
+	}
+
+	// Seuls les groupes visibles et non entièrement de dos sont transformés
+	for ( int p = 0; p < nparts; p++ ) {
+		renderpart_t * part = &g_parts[ p ];
+		// Partie sautée si les sommets transformés n'ont pas pu être alloués pour elle
+		if ( part->mesh->nvertices > g_capacity ) {
+			part->visible  = NULL;
+			part->nvisible = 0;
+			continue;
+		}
+		part->visible  = (int*)ArenaAlloc( g_framearena, sizeof( int ) * MAX( part->clusters->count, 1 ) );
+		part->nvisible = ( part->visible != NULL ) ? BvhCullClusters( part->clusters->bvh, part->clusters, &f, c->eye, part->visible ) : 0;
+	}
+
+	// Les remplissages en virgule fixe évaluent z exactement comme la pré-passe
+	// (la pré-passe n'écrit qu'un zbuffer par pixel, elle est ignorée en multi-échantillonnage)
+	bool zprepass = g_render.zprepass && !msaa;
+	int raster = ( zprepass || msaa ) ? RASTER_FIXED : g_render.raster;
+	RasterResetFragments();
+	WindowResetCounter( w, g_render.heatmap );
+	float minx = HUGE_VALF, miny = HUGE_VALF, maxx = -HUGE_VALF, maxy = -HUGE_VALF;
+	for ( int pass = zprepass ? 0 : 1; pass < 2; pass++ ) {
+		RasterDepthTest( ( pass == 1 && zprepass ) ? RASTER_DEPTH_EQUAL : RASTER_DEPTH_LESS );
+		for ( int p = 0; p < nparts; p++ ) {
+			mesh_t * m = g_parts[ p ].mesh;
+			clusters_t * cl = g_parts[ p ].clusters;
+			for ( int k = 0; k < g_parts[ p ].nvisible; k++ ) {
+				cluster_t * cluster = &cl->data[ g_parts[ p ].visible[ k ] ];
+				for ( int i = cluster->offset; i < cluster->offset + cluster->count; i++ ) {
+					int t = cl->faces[ i ];
+					int idx[ 3 ];
+					renderclip_t tv[ 3 ];
+					for ( int j = 0; j < 3; j++ ) {
+						idx[ j ] = MeshIndex( m, t * 3 + j );
+						if ( g_stamp[ idx[ j ] ] != stamp + p ) {
+							g_stamp[ idx[ j ] ] = stamp + p;
+							g_transformed[ idx[ j ] ] = MatrixfTransform( screen, m->vertices[ idx[ j ] ].pos );
+							// L'éclairage aux sommets est calculé une fois par sommet, dans la même passe
+							if ( gouraud ) {
+								g_lit[ idx[ j ] ] = LightShade( &light, m->vertices[ idx[ j ] ].norm );
+							}
+						}
+						tv[ j ].pos   = g_transformed[ idx[ j ] ];
+						tv[ j ].norm  = m->vertices[ idx[ j ] ].norm;
+						tv[ j ].uv    = m->vertices[ idx[ j ] ].uv;
+						tv[ j ].color = gouraud ? g_lit[ idx[ j ] ] : Vec3f( 0.0f, 0.0f, 0.0f );
+					}
+
+					renderclip_t poly[ 4 ];
+					int n = 3;
+					if ( tv[ 0 ].pos.z < 0.0f || tv[ 1 ].pos.z < 0.0f || tv[ 2 ].pos.z < 0.0f ) {
+						n = RenderClipNear( tv, poly );
+					}else {
+						poly[ 0 ] = tv[ 0 ]; poly[ 1 ] = tv[ 1 ]; poly[ 2 ] = tv[ 2 ];
+					}
+					if ( n < 3 ) {
+						continue;
+					}
+
+					// q = 1 / w conservé pour la correction de perspective des attributs
+					vec3f_t s[ 4 ];
+					float q[ 4 ];
+					for ( int j = 0; j < n; j++ ) {
+						q[ j ] = 1.0f / poly[ j ].pos.w;
+						s[ j ] = Vec3f( poly[ j ].pos.x * q[ j ], poly[ j ].pos.y * q[ j ], poly[ j ].pos.z * q[ j ] );
+					}
+					// Faces avant dans le sens trigonométrique, donc horaires à l'écran (y vers le bas)
+					float area = ( s[ 1 ].x - s[ 0 ].x ) * ( s[ 2 ].y - s[ 0 ].y ) - ( s[ 1 ].y - s[ 0 ].y ) * ( s[ 2 ].x - s[ 0 ].x );
+					if ( area >= 0.0f ) {
+						continue;
+					}
+					for ( int j = 0; j < n; j++ ) {
+						minx = MIN( minx, s[ j ].x );
+						miny = MIN( miny, s[ j ].y );
+						maxx = MAX( maxx, s[ j ].x );
+						maxy = MAX( maxy, s[ j ].y );
+					}
+
+					// Pré-passe : profondeur seule, le zbuffer final est connu avant tout éclairage
+					if ( pass == 0 ) {
+						RasterTriangleDepth( w->zbuffer, w->width, w->height, s[ 0 ], s[ 1 ], s[ 2 ] );
+						if ( n == 4 ) {
+							RasterTriangleDepth( w->zbuffer, w->width, w->height, s[ 0 ], s[ 2 ], s[ 3 ] );
+						}
+						continue;
+					}
+
+					if ( g_render.deferred ) {
+						RasterTriangleGBuffer( w, g_gbuffer, s[ 0 ], s[ 1 ], s[ 2 ], q[ 0 ], q[ 1 ], q[ 2 ], poly[ 0 ].norm, poly[ 1 ].norm, poly[ 2 ].norm, poly[ 0 ].uv, poly[ 1 ].uv, poly[ 2 ].uv, 0 );
+						if ( n == 4 ) {
+							RasterTriangleGBuffer( w, g_gbuffer, s[ 0 ], s[ 2 ], s[ 3 ], q[ 0 ], q[ 2 ], q[ 3 ], poly[ 0 ].norm, poly[ 2 ].norm, poly[ 3 ].norm, poly[ 0 ].uv, poly[ 2 ].uv, poly[ 3 ].uv, 0 );
+						}
+					}else if ( g_render.shading == RENDER_PHONG ) {
+						RasterTrianglePhong( w, s[ 0 ], s[ 1 ], s[ 2 ], q[ 0 ], q[ 1 ], q[ 2 ], poly[ 0 ].norm, poly[ 1 ].norm, poly[ 2 ].norm, &light );
+						if ( n == 4 ) {
+							RasterTrianglePhong( w, s[ 0 ], s[ 2 ], s[ 3 ], q[ 0 ], q[ 2 ], q[ 3 ], poly[ 0 ].norm, poly[ 2 ].norm, poly[ 3 ].norm, &light );
+						}
+					}else if ( gouraud ) {
+						RasterTriangleGouraud( w, s[ 0 ], s[ 1 ], s[ 2 ], q[ 0 ], q[ 1 ], q[ 2 ], poly[ 0 ].color, poly[ 1 ].color, poly[ 2 ].color );
+						if ( n == 4 ) {
+							RasterTriangleGouraud( w, s[ 0 ], s[ 2 ], s[ 3 ], q[ 0 ], q[ 2 ], q[ 3 ], poly[ 0 ].color, poly[ 2 ].color, poly[ 3 ].color );
+						}
+					}else {
+						vec3f_t p0 = m->vertices[ idx[ 0 ] ].pos;
+						vec3f_t normal = Vec3fCross( Vec3fSub( m->vertices[ idx[ 1 ] ].pos, p0 ), Vec3fSub( m->vertices[ idx[ 2 ] ].pos, p0 ) );
+						vec3f_t shade = LightShade( &light, normal );
+						Uint32 color = WindowColor( (Uint8)shade.x, (Uint8)shade.y, (Uint8)shade.z );
+						RasterTriangle( w, s[ 0 ], s[ 1 ], s[ 2 ], color, raster );
+						if ( n == 4 ) {
+							RasterTriangle( w, s[ 0 ], s[ 2 ], s[ 3 ], color, raster );
+						}
+					}
+				}
+			}
+		}
+	}
+	RasterDepthTest( RASTER_DEPTH_LESS );
+
+	// La géométrie ne touche que ces tuiles : le reste du framebuffer est resté au fond
+	g_stats.drawn = RenderTiles( w, minx, miny, maxx, maxy );
+	SDL_Rect * d = &g_stats.drawn;
+
+	// Statistiques de surcharge : fragments éclairés rapportés aux pixels couverts
+	g_stats.fragments = RasterFragments();
+	g_stats.pixels = 0;
+	for ( int y = d->y; y < d->y + d->h; y++ ) {
+		for ( int x = d->x; x < d->x + d->w; x++ ) {
+			if ( w->samples > 1 ) {
+				const float * z = WindowSampleDepths( w, x, y );
+				g_stats.pixels += ( MIN( MIN( z[ 0 ], z[ 1 ] ), MIN( z[ 2 ], z[ 3 ] ) ) < 1.0f );
+			}else {
+				g_stats.pixels += ( *WindowDepths( w, x, y ) < 1.0f );
+			}
+		}
+	}
+
+	// Chaque pixel visible n'est éclairé qu'une fois, quelle que soit la complexité de profondeur
+	if ( g_render.deferred ) {
+		bool shadows = g_render.shadows && ModelBvh() != NULL;
+		if ( shadows && g_shadow == NULL ) {
+			g_shadow = ShadowMap( SHADOW_SIZE );
+			// Sans carte, l'image est éclairée sans ombres
+			shadows = ( g_shadow != NULL );
+		}
+		if ( shadows ) {
+			ShadowMapRender( g_shadow, g_parts[ 0 ].mesh, ModelBvh()->nodes[ 0 ].box, g_render.light );
+		}
+		DeferredShade( w, g_gbuffer, c, &light, g_render.lights, g_render.nlights, g_render.lightculling, shadows ? g_shadow : NULL );
+	}
+
+	// La carte de surcharge remplace l'image une fois l'éclairage terminé, fond compris
+	g_stats.maxwrites = g_render.heatmap ? WindowDrawHeatmap( w ) : 0;
+	if ( g_render.heatmap ) {
+		d->x = d->y = 0;
+		d->w = w->width;
+		d->h = w->height;
+	}
+
+	MatrixfDelete( screen, 4 );
+}
+
+void RenderQuit() {
+	free( g_transformed );
+	free( g_lit );
+	free( g_stamp );
+	g_transformed = NULL;
+	g_lit         = NULL;
+	g_stamp       = NULL;
+	g_capacity    = 0;
+	free( g_wirepos );
+	free( g_wirelines );
+	free( g_wirelinesf );
+	g_wirepos      = NULL;
+	g_wirelines    = NULL;
+	g_wirelinesf   = NULL;
+	g_wirecapacity  = 0;
+	g_wirepositions = 0;
+	ArenaDelete( g_framearena );
+	g_framearena = NULL;
+	g_parts      = NULL;
+	GBufferDelete( g_gbuffer );
+	ShadowMapDelete( g_shadow );
+	g_gbuffer = NULL;
+	g_shadow  = NULL;
+	DeferredQuit();
+}
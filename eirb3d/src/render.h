@@ -0,0 +1,109 @@
+#ifndef __RENDER_H__
+#define __RENDER_H__
+
+#include "window.h"
+#include "camera.h"
+#include "light.h"
+
+/**
+ * Dfinition des modes d'clairage
+ */
+#define RENDER_FLAT		0	// Une couleur par face
+#define RENDER_GOURAUD		1	// Eclairage aux sommets, couleurs interpoles
+#define RENDER_PHONG		2	// Normales interpoles, clairage par pixel
+
+/**
+ * Nombre de lumires ponctuelles de la scne de test
+ */
+#define RENDER_POINT_LIGHTS	256
+
+/**
+ * Niveau de dtail choisi  chaque trame selon la taille projete du modle
+ */
+#define RENDER_LOD_AUTO		-1
+
+/**
+ * Ct des tuiles auxquelles est arrondie la zone dessine d'une trame, et marge autour
+ * de la gomtrie (lignes anti-crneles, voisinage du FXAA)
+ */
+#define RENDER_DIRTY_TILE	32
+#define RENDER_DIRTY_MARGIN	2
+
+/**
+ * Dfinition des types
+ */
+
+/**
+ * Options de rendu, modifiables  chaud (touches gres par EventsUpdate)
+ */
+typedef struct render {
+	int			raster;
+	bool			wireframe;
+	bool			antialias;
+	int			shading;
+	vec3f_t			light;
+	bool			deferred;
+	pointlight_t	*	lights;		// Lumires ponctuelles, values par le rendu diffr
+	int			nlights;
+	bool			lightculling;
+	bool			shadows;	// Carte d'ombre de la lumire directionnelle, en rendu diffr
+	bool			zprepass;	// Profondeur seule d'abord, puis clairage des seuls fragments visibles
+	bool			heatmap;	// Affiche le nombre d'critures par pixel  la place de l'image
+	bool			msaa;		// Multi-chantillonnage 4x des rendus directs (ni diffr, ni fil de fer)
+	bool			fxaa;		// Anti-crnelage en post-traitement, appliqu par la boucle principale
+	bool			dynamic;	// Rsolution interne adapte  la dure de trame vise, par la boucle principale
+	bool			continuous;	// Boucle redessinant chaque trame (animations), sinon en attente des vnements
+	int			lod;		// Niveau de dtail impos, ou RENDER_LOD_AUTO (sans effet sur le fil de fer)
+}render_t;
+
+/**
+ * Statistiques de la dernire trame dessine
+ */
+typedef struct renderstats {
+	long long		fragments;	// Fragments clairs (ou crits dans le tampon gomtrique)
+	int			pixels;		// Pixels couverts par la gomtrie
+	int			maxwrites;	// Ecritures du pixel le plus charg (carte de surcharge active uniquement)
+	SDL_Rect		drawn;		// Tuiles du framebuffer o la trame peut diffrer du fond
+	int			lod;		// Niveau de dtail dessin
+	int			triangles;	// Triangles de ce niveau
+}renderstats_t;
+
+/**
+ * Dfinition des prototypes de fonctions
+ */
+
+/**
+ * Retourne les options de rendu courantes
+ */
+render_t		*	RenderOptions		();
+
+/**
+ * Retourne les statistiques de la dernire trame
+ */
+renderstats_t		*	RenderStats		();
+
+/**
+ * Retourne vrai si la camra, les options de rendu ou la taille du framebuffer ont chang
+ * depuis l'appel prcdent, ou si RenderInvalidate a t appele : sinon la trame
+ * prcdente peut tre prsente  nouveau telle quelle. Aprs un redimensionnement,
+ * tout le framebuffer est considr comme dessin.
+ */
+bool				RenderChanged		( window_t * w, camera_t * c );
+
+/**
+ * Force le prochain RenderChanged  retourner vrai (modle modifi)
+ */
+void				RenderInvalidate	();
+
+/**
+ * Dessine le modle charg vu depuis la camra. Seul le rectangle drawn des statistiques
+ * de la trame prcdente a besoin d'tre effac avant l'appel.
+ */
+void				RenderModel		( window_t * w, camera_t * c );
+
+/**
+ * Libre les tableaux et tampons gards d'une trame  l'autre
+ */
+void				RenderQuit		();
+
+#endif //__RENDER_H__
@@ -0,0 +1,56 @@
+#include "resolution.h"
+
+// Poids de la dernière trame dans la moyenne glissante
+#define RESOLUTION_SMOOTHING	0.1f
+
+resolution_t Resolution( float target ) {
+	resolution_t r = { target, RESOLUTION_LEVELS, 0.0f, RESOLUTION_SETTLE };
+	return r;
+}
+
+/**
+ * Redimensionne le framebuffer à level seizièmes de la fenêtre. La moyenne est
+ * extrapolée à la nouvelle échelle, la durée d'une trame étant supposée
+ * proportionnelle à son nombre de pixels, puis corrigée par les mesures suivantes.
+ */
+static bool ResolutionApply( resolution_t * r, window_t * w, int level ) {
+	int width  = ( w->displaywidth  * level + RESOLUTION_LEVELS / 2 ) / RESOLUTION_LEVELS;
+	int height = ( w->displayheight * level + RESOLUTION_LEVELS / 2 ) / RESOLUTION_LEVELS;
+	r->settle = RESOLUTION_SETTLE;
+	if ( !WindowResize( w, width, height ) ) {
+		return false;
+	}
+	float ratio = (float)level / r->level;
+	r->average *= ratio * ratio;
+	r->level = level;
+	return true;
+}
+
+bool ResolutionUpdate( resolution_t * r, window_t * w, float frametime ) {
+	r->average = ( r->average > 0.0f ) ? r->average + RESOLUTION_SMOOTHING * ( frametime - r->average ) : frametime;
+	if ( r->settle > 0 ) {
+		r->settle--;
+		return false;
+	}
+
+	// Trop lent : baisse d'autant de niveaux que nécessaire pour revenir sous la marge
+	if ( r->average > r->target && r->level > RESOLUTION_MIN_LEVEL ) {
+		int level = (int)( r->level * sqrtf( RESOLUTION_HEADROOM * r->target / r->average ) );
+		return ResolutionApply( r, w, MAX( MIN( level, r->level - 1 ), RESOLUTION_MIN_LEVEL ) );
+	}
+
+	// Assez rapide : remonte d'un seul niveau, si la durée prévue y reste sous la marge
+	if ( r->level < RESOLUTION_LEVELS ) {
+		float ratio = (float)( r->level + 1 ) / r->level;
+		if ( r->average * ratio * ratio < RESOLUTION_HEADROOM * r->target ) {
+			return ResolutionApply( r, w, r->level + 1 );
+		}
+	}
+	return false;
+}
+
+void ResolutionReset( resolution_t * r, window_t * w ) {
+	if ( r->level != RESOLUTION_LEVELS ) {
+		ResolutionApply( r, w, RESOLUTION_LEVELS );
+	}
+}
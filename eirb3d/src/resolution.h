@@ -0,0 +1,57 @@
+#ifndef __RESOLUTION_H__
+#define __RESOLUTION_H__
+
+#include "window.h"
+
+/**
+ * Dure de trame vise par dfaut, en millisecondes (60 images par seconde)
+ */
+#define RESOLUTION_TARGET	16.6f
+
+/**
+ * Echelles possibles de la rsolution interne : RESOLUTION_MIN_LEVEL  RESOLUTION_LEVELS
+ * seizimes de la taille de la fentre, soit de 50 %  100 %
+ */
+#define RESOLUTION_LEVELS	16
+#define RESOLUTION_MIN_LEVEL	8
+
+/**
+ * Hystrsis : la rsolution baisse ds que la moyenne dpasse la cible, mais ne remonte
+ * que si la dure prvue  l'chelle suprieure reste sous RESOLUTION_HEADROOM fois la
+ * cible. Aprs chaque changement, RESOLUTION_SETTLE trames sont mesures avant de dcider.
+ */
+#define RESOLUTION_HEADROOM	0.85f
+#define RESOLUTION_SETTLE	30
+
+/**
+ * Dfinition des types
+ */
+typedef struct resolution {
+	float			target;		// Dure de trame vise, en millisecondes
+	int			level;		// Echelle courante, en seizimes de la taille de la fentre
+	float			average;	// Moyenne glissante des dures de trame  cette chelle
+	int			settle;		// Trames restant  mesurer avant la prochaine dcision
+}resolution_t;
+
+/**
+ * Dfinition des prototypes de fonctions
+ */
+
+/**
+ * Contrleur de rsolution dynamique visant target millisecondes par trame,  pleine rsolution
+ */
+resolution_t			Resolution		( float target );
+
+/**
+ * Prend en compte la dure de la trame qui vient d'tre dessine et redimensionne le
+ * framebuffer de la fentre si besoin, avant la trame suivante. Retourne vrai si la
+ * rsolution interne a chang.
+ */
+bool				ResolutionUpdate	( resolution_t * r, window_t * w, float frametime );
+
+/**
+ * Revient  la pleine rsolution de la fentre
+ */
+void				ResolutionReset		( resolution_t * r, window_t * w );
+
+#endif //__RESOLUTION_H__
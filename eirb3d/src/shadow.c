@@ -0,0 +1,75 @@
+#include "shadow.h"
+#include "raster.h"
+
+shadowmap_t * ShadowMap( int size ) {
+	shadowmap_t * s = (shadowmap_t*)malloc( sizeof( shadowmap_t ) );
+	float * depth = (float*)malloc( sizeof( float ) * size * size );
+	if ( s == NULL || depth == NULL ) {
+		printf( "(EE) Unable to allocate %dx%d shadow map\n", size, size );
+		free( s ); free( depth );
+		return NULL;
+	}
+	s->size   = size;
+	s->depth  = depth;
+	s->screen = NULL;
+	return s;
+}
+
+void ShadowMapDelete( shadowmap_t * s ) {
+	if ( s == NULL ) {
+		return;
+	}
+	if ( s->screen != NULL ) {
+		MatrixfDelete( s->screen, 4 );
+	}
+	free( s->depth );
+	free( s );
+}
+
+void ShadowMapRender( shadowmap_t * s, mesh_t * m, aabb_t bounds, vec3f_t direction ) {
+	// Projection orthographique englobant la sphère circonscrite à la scène
+	vec3f_t center = Vec3fScale( Vec3fAdd( bounds.min, bounds.max ), 0.5f );
+	float radius = 0.5f * Vec3fLength( Vec3fSub( bounds.max, bounds.min ) );
+	vec3f_t dir = Vec3fNormalize( direction );
+	vec3f_t up = ( fabsf( dir.y ) > 0.99f ) ? Vec3f( 1.0f, 0.0f, 0.0f ) : Vec3f( 0.0f, 1.0f, 0.0f );
+	matrixf_t view = MatrixfLookAt( Vec3fAdd( center, Vec3fScale( dir, radius ) ), center, up );
+	matrixf_t ortho = MatrixfOrtho( -radius, radius, -radius, radius, 0.0f, 2.0f * radius );
+	matrixf_t viewport = MatrixfViewport( 0, 0, s->size, s->size );
+	matrixf_t pv = MatrixfMult( ortho, view, 4, 4 );
+	if ( s->screen != NULL ) {
+		MatrixfDelete( s->screen, 4 );
+	}
+	s->screen = MatrixfMult( viewport, pv, 4, 4 );
+	MatrixfDelete( view, 4 );
+	MatrixfDelete( ortho, 4 );
+	MatrixfDelete( viewport, 4 );
+	MatrixfDelete( pv, 4 );
+
+	for ( int i = 0; i < s->size * s->size; i++ ) {
+		s->depth[ i ] = 1.0f;
+	}
+	// Projection orthographique : w vaut 1, aucune division ni découpage proche
+	for ( int i = 0; i < m->nindices; i += 3 ) {
+		vec3f_t v[ 3 ];
+		for ( int j = 0; j < 3; j++ ) {
+			vec4f_t h = MatrixfTransform( s->screen, m->vertices[ MeshIndex( m, i + j ) ].pos );
+			v[ j ] = Vec3f( h.x, h.y, h.z );
+		}
+		RasterTriangleDepth( s->depth, s->size, s->size, v[ 0 ], v[ 1 ], v[ 2 ] );
+	}
+}
+
+float ShadowMapVisibility( const shadowmap_t * s, vec3f_t p ) {
+	vec4f_t h = MatrixfTransform( s->screen, p );
+	int x = (int)floorf( h.x ), y = (int)floorf( h.y );
+	float z = h.z - SHADOW_BIAS;
+	int lit = 0;
+	for ( int dy = -1; dy <= 1; dy++ ) {
+		int ty = MIN( MAX( y + dy, 0 ), s->size - 1 );
+		for ( int dx = -1; dx <= 1; dx++ ) {
+			int tx = MIN( MAX( x + dx, 0 ), s->size - 1 );
+			lit += ( z <= s->depth[ ty * s->size + tx ] );
+		}
+	}
+	return lit * ( 1.0f / 9.0f );
+}
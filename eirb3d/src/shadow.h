@@ -0,0 +1,52 @@
+#ifndef __SHADOW_H__
+#define __SHADOW_H__
+
+#include "geometry.h"
+#include "mesh.h"
+
+/**
+ * Ct en texels de la carte d'ombre et biais de profondeur contre l'acn
+ */
+#define SHADOW_SIZE		1024
+#define SHADOW_BIAS		0.004f
+
+/**
+ * Dfinition des types
+ */
+
+/**
+ * Carte d'ombre d'une lumire directionnelle : profondeur vue depuis la lumire
+ * par une projection orthographique ajuste aux bornes de la scne
+ */
+typedef struct shadowmap {
+	float		*	depth;
+	int			size;
+	matrixf_t		screen;		// Monde vers texels, profondeur dans [0,1]
+}shadowmap_t;
+
+/**
+ * Dfinition des prototypes de fonctions
+ */
+
+/**
+ * Construit une carte d'ombre de size x size texels, NULL si elle n'a pu tre alloue
+ */
+shadowmap_t		*	ShadowMap		( int size );
+
+/**
+ * Supprime une carte d'ombre
+ */
+void				ShadowMapDelete		( shadowmap_t * s );
+
+/**
+ * Dessine la profondeur du maillage vu depuis une lumire venant de direction
+ */
+void				ShadowMapRender		( shadowmap_t * s, mesh_t * m, aabb_t bounds, vec3f_t direction );
+
+/**
+ * Retourne la part de lumire reue par un point (0 dans l'ombre, 1 clair),
+ * filtre sur 3 x 3 texels (PCF)
+ */
+float				ShadowMapVisibility	( const shadowmap_t * s, vec3f_t p );
+
+#endif //__SHADOW_H__
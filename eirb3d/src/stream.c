@@ -0,0 +1,720 @@
+#include <string.h>
+#include <stdlib.h>
+#include "stream.h"
+#include "events.h"
+#include "bvh.h"
+
+// Positions au-delà de 2 Go dans les fichiers de morceaux et les fichiers temporaires
+#if defined( _WIN32 )
+#define StreamSeek	_fseeki64
+#define StreamTell	_ftelli64
+#else
+#define StreamSeek	fseeko
+#define StreamTell	ftello
+#endif
+
+// Cache des attributs temporaires, lus au hasard pendant la répartition des faces :
+// STREAM_PAGES pages de STREAM_PAGE enregistrements
+#define STREAM_PAGE		4096
+#define STREAM_PAGES		64
+
+// Faces gardées en mémoire par cellule avant d'être ajoutées au fichier temporaire
+#define STREAM_BUCKET		64
+
+/**
+ * En-tête du fichier de morceaux, suivi de count entrées streamrecord_t
+ */
+typedef struct streamheader {
+	int			magic;
+	int			version;
+	int			count;
+	aabb_t			bounds;
+}streamheader_t;
+
+/**
+ * Attribut du fichier OBJ (v, vn ou vt) recopié dans un fichier temporaire
+ */
+typedef struct streamattrib {
+	FILE		*	file;
+	int			size;		// Octets par enregistrement
+	long long		count;
+	char		*	pages;
+	long long		tags[ STREAM_PAGES ];
+}streamattrib_t;
+
+/**
+ * Cellule de la grille : faces en attente d'écriture, puis liste de ses blocs écrits
+ */
+typedef struct streamcell {
+	vertex_t	*	corners;	// STREAM_BUCKET triangles, alloués à la première face
+	int			n;
+	int			total;
+	int			first;		// Premier et dernier bloc, -1 sans bloc
+	int			last;
+}streamcell_t;
+
+/**
+ * Bloc de faces d'une cellule dans le fichier temporaire
+ */
+typedef struct streamblock {
+	long long		offset;
+	int			count;
+	int			next;
+}streamblock_t;
+
+// Morceaux triés par StreamCompare, le tri n'a lieu que dans le fil principal
+static const streamchunk_t * g_sorted = NULL;
+
+static streamattrib_t StreamAttrib( int size ) {
+	streamattrib_t a;
+	a.file  = tmpfile();
+	a.size  = size;
+	a.count = 0;
+	a.pages = (char*)malloc( (size_t)STREAM_PAGES * STREAM_PAGE * size );
+	for ( int i = 0; i < STREAM_PAGES; i++ ) {
+		a.tags[ i ] = -1;
+	}
+	return a;
+}
+
+static void StreamAttribDelete( streamattrib_t * a ) {
+	if ( a->file != NULL ) {
+		fclose( a->file );
+	}
+	free( a->pages );
+}
+
+/**
+ * Enregistrement index (numérotation OBJ : à partir de 1, ou négatif depuis la fin),
+ * mis à zéro s'il n'existe pas
+ */
+static void StreamAttribGet( streamattrib_t * a, long long index, void * out ) {
+	index = ( index > 0 ) ? index - 1 : a->count + index;
+	if ( index < 0 || index >= a->count ) {
+		memset( out, 0, a->size );
+		return;
+	}
+	long long page = index / STREAM_PAGE;
+	int slot = (int)( page % STREAM_PAGES );
+	char * data = a->pages + (size_t)slot * STREAM_PAGE * a->size;
+	if ( a->tags[ slot ] != page ) {
+		StreamSeek( a->file, page * STREAM_PAGE * a->size, SEEK_SET );
+		long long n = MIN( (long long)STREAM_PAGE, a->count - page * STREAM_PAGE );
+		if ( fread( data, a->size, (size_t)n, a->file ) != (size_t)n ) {
+			memset( out, 0, a->size );
+			a->tags[ slot ] = -1;
+			return;
+		}
+		a->tags[ slot ] = page;
+	}
+	memcpy( out, data + ( index % STREAM_PAGE ) * a->size, a->size );
+}
+
+static unsigned int StreamHash( const vertex_t * v ) {
+	const unsigned int * w = (const unsigned int*)v;
+	unsigned int h = 2166136261u;
+	for ( size_t i = 0; i < sizeof( vertex_t ) / sizeof( unsigned int ); i++ ) {
+		h = ( h ^ w[ i ] ) * 16777619u;
+	}
+	return h;
+}
+
+/**
+ * Maillage indexé des sommets identiques soudés, les triangles gardant leur ordre
+ */
+static mesh_t * StreamWeld( const vertex_t * corners, int ncorners ) {
+	int size = 1;
+	while ( size < ncorners * 2 ) {
+		size <<= 1;
+	}
+	int * table = (int*)malloc( sizeof( int ) * size );
+	int * remap = (int*)malloc( sizeof( int ) * ncorners );
+	mesh_t * m = (mesh_t*)malloc( sizeof( mesh_t ) );
+	vertex_t * unique = (vertex_t*)malloc( sizeof( vertex_t ) * ncorners );
+	if ( table == NULL || remap == NULL || m == NULL || unique == NULL ) {
+		free( table ); free( remap ); free( m ); free( unique );
+		return NULL;
+	}
+	memset( table, -1, sizeof( int ) * size );
+	int nunique = 0;
+	for ( int i = 0; i < ncorners; i++ ) {
+		unsigned int h = StreamHash( &corners[ i ] ) & ( size - 1 );
+		while ( table[ h ] >= 0 && memcmp( &unique[ table[ h ] ], &corners[ i ], sizeof( vertex_t ) ) != 0 ) {
+			h = ( h + 1 ) & ( size - 1 );
+		}
+		if ( table[ h ] < 0 ) {
+			table[ h ] = nunique;
+			unique[ nunique++ ] = corners[ i ];
+		}
+		remap[ i ] = table[ h ];
+	}
+	int indexsize = ( nunique <= 65536 ) ? 2 : 4;
+	void * indices = malloc( (size_t)indexsize * (size_t)ncorners );
+	if ( indices == NULL ) {
+		free( table ); free( remap ); free( m ); free( unique );
+		return NULL;
+	}
+	// Ne fait que réduire le bloc : en cas d'échec, l'ancien reste valide
+	vertex_t * vertices = (vertex_t*)realloc( unique, sizeof( vertex_t ) * nunique );
+	m->nvertices = nunique;
+	m->vertices  = ( vertices != NULL ) ? vertices : unique;
+	m->nindices  = ncorners;
+	m->indexsize = indexsize;
+	m->indices   = indices;
+	for ( int i = 0; i < ncorners; i++ ) {
+		MeshSetIndex( m, i, remap[ i ] );
+	}
+	free( table );
+	free( remap );
+	return m;
+}
+
+/**
+ * Ajoute les faces en attente d'une cellule au fichier temporaire
+ */
+static bool StreamFlush( streamcell_t * cell, FILE * spill, streamblock_t ** blocks, int * nblocks, int * capacity ) {
+	if ( cell->n == 0 ) {
+		return true;
+	}
+	if ( *nblocks == *capacity ) {
+		*capacity = MAX( *capacity * 2, 1024 );
+		*blocks = (streamblock_t*)realloc( *blocks, sizeof( streamblock_t ) * *capacity );
+	}
+	streamblock_t * b = &( *blocks )[ *nblocks ];
+	b->offset = StreamTell( spill );
+	b->count  = cell->n;
+	b->next   = -1;
+	if ( fwrite( cell->corners, sizeof( vertex_t ) * 3, cell->n, spill ) != (size_t)cell->n ) {
+		return false;
+	}
+	if ( cell->last >= 0 ) {
+		( *blocks )[ cell->last ].next = *nblocks;
+	}else {
+		cell->first = *nblocks;
+	}
+	cell->last = *nblocks;
+	( *nblocks )++;
+	cell->n = 0;
+	return true;
+}
+
+bool StreamBuild( const char * objfilename, const char * chunkfilename ) {
+	Uint64 start = SDL_GetPerformanceCounter();
+	FILE * obj = fopen( objfilename, "r" );
+	if ( obj == NULL ) {
+		printf( "(EE) Unable to open %s\n", objfilename );
+		return false;
+	}
+	streamattrib_t pos  = StreamAttrib( sizeof( vec3f_t ) );
+	streamattrib_t norm = StreamAttrib( sizeof( vec3f_t ) );
+	streamattrib_t uv   = StreamAttrib( sizeof( vec2f_t ) );
+	FILE * spill = tmpfile();
+	if ( pos.file == NULL || norm.file == NULL || uv.file == NULL || spill == NULL || pos.pages == NULL || norm.pages == NULL || uv.pages == NULL ) {
+		printf( "(EE) Unable to create temporary files\n" );
+		fclose( obj );
+		StreamAttribDelete( &pos ); StreamAttribDelete( &norm ); StreamAttribDelete( &uv );
+		if ( spill != NULL ) fclose( spill );
+		return false;
+	}
+
+	// Première lecture : attributs recopiés tels quels, boîte englobante et nombre de faces
+	char line[ 256 ];
+	char tag[ 8 ];
+	aabb_t bounds = Aabb();
+	long long nfaces = 0;
+	while ( fgets( line, sizeof( line ), obj ) != NULL ) {
+		if ( sscanf( line, "%7s", tag ) != 1 ) {
+			continue;
+		}
+		if ( strcmp( tag, "v" ) == 0 ) {
+			vec3f_t v = Vec3f( 0.0f, 0.0f, 0.0f );
+			sscanf( line, "%*s %f %f %f", &v.x, &v.y, &v.z );
+			AabbExtend( &bounds, v );
+			fwrite( &v, sizeof( v ), 1, pos.file );
+			pos.count++;
+		}else if ( strcmp( tag, "vn" ) == 0 ) {
+			vec3f_t n = Vec3f( 0.0f, 0.0f, 0.0f );
+			sscanf( line, "%*s %f %f %f", &n.x, &n.y, &n.z );
+			fwrite( &n, sizeof( n ), 1, norm.file );
+			norm.count++;
+		}else if ( strcmp( tag, "vt" ) == 0 ) {
+			vec2f_t t;
+			t.x = t.y = 0.0f;
+			sscanf( line, "%*s %f %f", &t.x, &t.y );
+			fwrite( &t, sizeof( t ), 1, uv.file );
+			uv.count++;
+		}else if ( strcmp( tag, "f" ) == 0 ) {
+			nfaces++;
+		}
+	}
+	fflush( pos.file );
+	fflush( norm.file );
+	fflush( uv.file );
+	if ( nfaces == 0 || pos.count == 0 ) {
+		printf( "(EE) No faces in %s\n", objfilename );
+		fclose( obj ); fclose( spill );
+		StreamAttribDelete( &pos ); StreamAttribDelete( &norm ); StreamAttribDelete( &uv );
+		return false;
+	}
+
+	// Grille régulière de cubes, resserrée jusqu'à avoir une cellule par STREAM_CHUNK_TRIANGLES
+	// faces (les cellules vides ne donnent pas de morceau)
+	vec3f_t extent = Vec3fSub( bounds.max, bounds.min );
+	long long target = MAX( nfaces / STREAM_CHUNK_TRIANGLES, 1LL );
+	float side = MAX( extent.x, MAX( extent.y, extent.z ) );
+	int dims[ 3 ] = { 1, 1, 1 };
+	while ( side > 0.0f ) {
+		for ( int a = 0; a < 3; a++ ) {
+			dims[ a ] = MAX( (int)ceilf( Vec3fAxis( extent, a ) / side ), 1 );
+		}
+		if ( (long long)dims[ 0 ] * dims[ 1 ] * dims[ 2 ] >= target ) {
+			break;
+		}
+		side *= 0.9f;
+	}
+	int ncells = dims[ 0 ] * dims[ 1 ] * dims[ 2 ];
+	streamcell_t * cells = (streamcell_t*)calloc( ncells, sizeof( streamcell_t ) );
+	for ( int i = 0; i < ncells; i++ ) {
+		cells[ i ].first = cells[ i ].last = -1;
+	}
+
+	// Deuxième lecture : chaque face, avec ses attributs, rejoint la cellule de son centre
+	streamblock_t * blocks = NULL;
+	int nblocks = 0, capacity = 0;
+	long long rejected = 0;
+	bool ok = ( cells != NULL );
+	rewind( obj );
+	while ( ok && fgets( line, sizeof( line ), obj ) != NULL ) {
+		if ( sscanf( line, "%7s", tag ) != 1 || strcmp( tag, "f" ) != 0 ) {
+			continue;
+		}
+		// Mêmes formes de faces que ModelLoad ; un index d'attribut absent vaut 0 et donne un
+		// attribut nul
+		face_t face;
+		if ( !MeshParseFace( line, &face, (int)pos.count, (int)uv.count, (int)norm.count ) ) {
+			rejected++;
+			continue;
+		}
+		vertex_t tri[ 3 ];
+		vec3f_t center = Vec3f( 0.0f, 0.0f, 0.0f );
+		for ( int j = 0; j < 3; j++ ) {
+			StreamAttribGet( &pos, face.v[ j ], &tri[ j ].pos );
+			StreamAttribGet( &norm, face.vn[ j ], &tri[ j ].norm );
+			StreamAttribGet( &uv, face.vt[ j ], &tri[ j ].uv );
+			center = Vec3fAdd( center, tri[ j ].pos );
+		}
+		center = Vec3fSub( Vec3fScale( center, 1.0f / 3.0f ), bounds.min );
+		int index = 0;
+		for ( int a = 2; a >= 0; a-- ) {
+			int x = ( side > 0.0f ) ? (int)( Vec3fAxis( center, a ) / side ) : 0;
+			index = index * dims[ a ] + MIN( MAX( x, 0 ), dims[ a ] - 1 );
+		}
+		streamcell_t * cell = &cells[ index ];
+		if ( cell->corners == NULL ) {
+			cell->corners = (vertex_t*)malloc( sizeof( vertex_t ) * 3 * STREAM_BUCKET );
+			if ( cell->corners == NULL ) {
+				ok = false;
+				break;
+			}
+		}
+		memcpy( &cell->corners[ cell->n * 3 ], tri, sizeof( tri ) );
+		cell->n++;
+		cell->total++;
+		if ( cell->n == STREAM_BUCKET ) {
+			ok = StreamFlush( cell, spill, &blocks, &nblocks, &capacity );
+		}
+	}
+	fclose( obj );
+	StreamAttribDelete( &pos );
+	StreamAttribDelete( &norm );
+	StreamAttribDelete( &uv );
+	for ( int i = 0; ok && i < ncells; i++ ) {
+		ok = StreamFlush( &cells[ i ], spill, &blocks, &nblocks, &capacity );
+		free( cells[ i ].corners );
+		cells[ i ].corners = NULL;
+	}
+	fflush( spill );
+	if ( rejected > 0 ) {
+		printf( "(EE) %lld faces ignored in %s (unsupported format or unknown vertex)\n", rejected, objfilename );
+	}
+	if ( rejected == nfaces ) {
+		printf( "(EE) No faces in %s\n", objfilename );
+		ok = false;
+	}
+
+	// Dernière étape : chaque cellule non vide est relue, soudée, découpée en groupes de
+	// triangles et écrite comme un morceau. La table est réécrite une fois complète.
+	FILE * out = ok ? fopen( chunkfilename, "wb" ) : NULL;
+	streamheader_t header;
+	header.magic   = STREAM_MAGIC;
+	header.version = STREAM_VERSION;
+	header.count   = 0;
+	header.bounds  = bounds;
+	for ( int i = 0; i < ncells; i++ ) {
+		header.count += ( cells != NULL && cells[ i ].total > 0 );
+	}
+	streamrecord_t * records = (streamrecord_t*)calloc( MAX( header.count, 1 ), sizeof( streamrecord_t ) );
+	if ( out == NULL || records == NULL ) {
+		printf( "(EE) Unable to write %s\n", chunkfilename );
+		ok = false;
+	}else {
+		ok = fwrite( &header, sizeof( header ), 1, out ) == 1 && fwrite( records, sizeof( streamrecord_t ), header.count, out ) == (size_t)header.count;
+	}
+	int chunk = 0;
+	for ( int i = 0; ok && i < ncells; i++ ) {
+		streamcell_t * cell = &cells[ i ];
+		if ( cell->total == 0 ) {
+			continue;
+		}
+		vertex_t * corners = (vertex_t*)malloc( sizeof( vertex_t ) * 3 * cell->total );
+		vec3f_t * positions = (vec3f_t*)malloc( sizeof( vec3f_t ) * 3 * cell->total );
+		int n = 0;
+		for ( int b = cell->first; corners != NULL && b >= 0; b = blocks[ b ].next ) {
+			StreamSeek( spill, blocks[ b ].offset, SEEK_SET );
+			if ( fread( &corners[ n * 3 ], sizeof( vertex_t ) * 3, blocks[ b ].count, spill ) != (size_t)blocks[ b ].count ) {
+				break;
+			}
+			n += blocks[ b ].count;
+		}
+		mesh_t * m = ( corners != NULL && positions != NULL && n == cell->total ) ? StreamWeld( corners, n * 3 ) : NULL;
+		clusters_t * c = NULL;
+		if ( m != NULL ) {
+			// Triangles réordonnés pour le cache de sommets comme ceux de ModelLoad, les
+			// groupes sont construits dans ce nouvel ordre
+			MeshOptimize( m );
+			for ( int j = 0; j < m->nindices; j++ ) {
+				positions[ j ] = m->vertices[ MeshIndex( m, j ) ].pos;
+			}
+			c = Clusters( positions, n );
+		}
+		free( corners );
+		free( positions );
+		if ( c == NULL ) {
+			printf( "(EE) Unable to build chunk %d\n", chunk );
+			MeshDelete( m );
+			ok = false;
+			break;
+		}
+
+		streamrecord_t * r = &records[ chunk++ ];
+		r->box = Aabb();
+		for ( int j = 0; j < m->nvertices; j++ ) {
+			AabbExtend( &r->box, m->vertices[ j ].pos );
+		}
+		r->offset    = StreamTell( out );
+		r->nvertices = m->nvertices;
+		r->nindices  = m->nindices;
+		r->indexsize = m->indexsize;
+		r->nclusters = c->count;
+		ok = fwrite( m->vertices, sizeof( vertex_t ), m->nvertices, out ) == (size_t)m->nvertices
+			&& fwrite( m->indices, m->indexsize, m->nindices, out ) == (size_t)m->nindices
+			&& fwrite( c->data, sizeof( cluster_t ), c->count, out ) == (size_t)c->count
+			&& fwrite( c->faces, sizeof( int ), c->nfaces, out ) == (size_t)c->nfaces;
+		MeshDelete( m );
+		ClustersDelete( c );
+	}
+	long long size = 0;
+	if ( ok ) {
+		size = StreamTell( out );
+		StreamSeek( out, sizeof( header ), SEEK_SET );
+		ok = fwrite( records, sizeof( streamrecord_t ), header.count, out ) == (size_t)header.count;
+	}
+	if ( out != NULL && fclose( out ) != 0 ) {
+		ok = false;
+	}
+	if ( ok ) {
+		printf( "(II) Stream: %lld triangles split into %d chunks (%dx%dx%d grid), %.1f MB written in %.2f s\n",
+			nfaces - rejected, header.count, dims[ 0 ], dims[ 1 ], dims[ 2 ], size / ( 1024.0 * 1024.0 ),
+			(double)( SDL_GetPerformanceCounter() - start ) / SDL_GetPerformanceFrequency() );
+	}else {
+		printf( "(EE) Unable to split %s into chunks\n", objfilename );
+	}
+	fclose( spill );
+	free( cells );
+	free( blocks );
+	free( records );
+	return ok;
+}
+
+/**
+ * Lit un morceau depuis le fil du chargeur, sans verrou : seule la table, qui ne change
+ * pas, est consultée
+ */
+static bool StreamRead( stream_t * s, const streamrecord_t * r, mesh_t ** mesh, clusters_t ** clusters ) {
+	int nfaces = r->nindices / 3;
+	mesh_t * m = (mesh_t*)malloc( sizeof( mesh_t ) );
+	clusters_t * c = (clusters_t*)malloc( sizeof( clusters_t ) );
+	if ( m == NULL || c == NULL ) {
+		free( m ); free( c );
+		return false;
+	}
+	m->nvertices = r->nvertices;
+	m->nindices  = r->nindices;
+	m->indexsize = r->indexsize;
+	m->vertices  = (vertex_t*)malloc( sizeof( vertex_t ) * r->nvertices );
+	m->indices   = malloc( (size_t)r->indexsize * r->nindices );
+	c->count  = r->nclusters;
+	c->nfaces = nfaces;
+	c->bvh    = NULL;
+	c->data   = (cluster_t*)malloc( sizeof( cluster_t ) * r->nclusters );
+	c->faces  = (int*)malloc( sizeof( int ) * nfaces );
+	bool ok = m->vertices != NULL && m->indices != NULL && c->data != NULL && c->faces != NULL
+		&& StreamSeek( s->file, r->offset, SEEK_SET ) == 0
+		&& fread( m->vertices, sizeof( vertex_t ), r->nvertices, s->file ) == (size_t)r->nvertices
+		&& fread( m->indices, r->indexsize, r->nindices, s->file ) == (size_t)r->nindices
+		&& fread( c->data, sizeof( cluster_t ), r->nclusters, s->file ) == (size_t)r->nclusters
+		&& fread( c->faces, sizeof( int ), nfaces, s->file ) == (size_t)nfaces;
+	if ( !ok ) {
+		MeshDelete( m );
+		ClustersDelete( c );
+		return false;
+	}
+	// La hiérarchie des groupes n'est pas dans le fichier : sans elle, ils sont tous testés
+	c->bvh = BvhClusters( c );
+	*mesh = m;
+	*clusters = c;
+	return true;
+}
+
+/**
+ * Fil du chargeur : sert la file du plus proche au plus lointain, et réveille la boucle
+ * principale à chaque morceau prêt
+ */
+static int StreamLoader( void * data ) {
+	stream_t * s = (stream_t*)data;
+	SDL_LockMutex( s->mutex );
+	for ( ;; ) {
+		while ( !s->quit && s->next >= s->nqueue ) {
+			SDL_CondWait( s->wake, s->mutex );
+		}
+		if ( s->quit ) {
+			break;
+		}
+		int index = s->queue[ s->next++ ];
+		streamchunk_t * k = &s->chunks[ index ];
+		k->state = STREAM_LOADING;
+		SDL_UnlockMutex( s->mutex );
+
+		Uint64 start = SDL_GetPerformanceCounter();
+		mesh_t * mesh = NULL;
+		clusters_t * clusters = NULL;
+		bool ok = StreamRead( s, &k->record, &mesh, &clusters );
+		double seconds = (double)( SDL_GetPerformanceCounter() - start ) / SDL_GetPerformanceFrequency();
+
+		SDL_LockMutex( s->mutex );
+		s->loadtime += seconds;
+		if ( ok ) {
+			k->mesh     = mesh;
+			k->clusters = clusters;
+			k->state    = STREAM_READY;
+			s->loads++;
+			s->bytesread += k->bytes;
+		}else {
+			printf( "(EE) Unable to read chunk %d\n", index );
+			k->state = STREAM_FAILED;
+			s->resident -= k->bytes;
+		}
+		SDL_UnlockMutex( s->mutex );
+		EventsWake();
+		SDL_LockMutex( s->mutex );
+	}
+	SDL_UnlockMutex( s->mutex );
+	return 0;
+}
+
+stream_t * Stream( const char * chunkfilename, size_t budget ) {
+	FILE * file = fopen( chunkfilename, "rb" );
+	if ( file == NULL ) {
+		printf( "(EE) Unable to open %s\n", chunkfilename );
+		return NULL;
+	}
+	streamheader_t header;
+	if ( fread( &header, sizeof( header ), 1, file ) != 1 || header.magic != STREAM_MAGIC || header.version != STREAM_VERSION || header.count <= 0 ) {
+		printf( "(EE) %s is not a chunk file\n", chunkfilename );
+		fclose( file );
+		return NULL;
+	}
+	stream_t * s = (stream_t*)calloc( 1, sizeof( stream_t ) );
+	streamchunk_t * chunks = (streamchunk_t*)calloc( header.count, sizeof( streamchunk_t ) );
+	int * queue = (int*)malloc( sizeof( int ) * header.count );
+	int * drawn = (int*)malloc( sizeof( int ) * header.count );
+	int * visible = (int*)malloc( sizeof( int ) * header.count );
+	if ( s == NULL || chunks == NULL || queue == NULL || drawn == NULL || visible == NULL ) {
+		printf( "(EE) Unable to allocate stream\n" );
+		free( s ); free( chunks ); free( queue ); free( drawn ); free( visible );
+		fclose( file );
+		return NULL;
+	}
+	size_t total = 0;
+	for ( int i = 0; i < header.count; i++ ) {
+		streamchunk_t * k = &chunks[ i ];
+		if ( fread( &k->record, sizeof( streamrecord_t ), 1, file ) != 1 ) {
+			printf( "(EE) %s is truncated\n", chunkfilename );
+			free( s ); free( chunks ); free( queue ); free( drawn ); free( visible );
+			fclose( file );
+			return NULL;
+		}
+		streamrecord_t * r = &k->record;
+		k->bytes = sizeof( mesh_t ) + sizeof( clusters_t ) + sizeof( vertex_t ) * r->nvertices + (size_t)r->indexsize * r->nindices
+			+ sizeof( cluster_t ) * r->nclusters + sizeof( int ) * ( r->nindices / 3 )
+			+ sizeof( bvh_t ) + ( sizeof( bvhnode_t ) * 2 + sizeof( int ) ) * r->nclusters;
+		k->state = STREAM_UNLOADED;
+		k->used  = -1;
+		total += k->bytes;
+	}
+	s->file    = file;
+	s->chunks  = chunks;
+	s->count   = header.count;
+	s->bounds  = header.bounds;
+	s->budget  = budget;
+	s->queue   = queue;
+	s->drawn   = drawn;
+	s->visible = visible;
+	s->mutex   = SDL_CreateMutex();
+	s->wake    = SDL_CreateCond();
+	s->thread  = SDL_CreateThread( StreamLoader, "stream", s );
+	printf( "(II) Stream: %d chunks, %.1f MB when fully loaded, %.1f MB budget\n", s->count, total / ( 1024.0 * 1024.0 ), budget / ( 1024.0 * 1024.0 ) );
+	return s;
+}
+
+void StreamDelete( stream_t * s ) {
+	if ( s == NULL ) {
+		return;
+	}
+	SDL_LockMutex( s->mutex );
+	s->quit = true;
+	SDL_CondSignal( s->wake );
+	SDL_UnlockMutex( s->mutex );
+	SDL_WaitThread( s->thread, NULL );
+	for ( int i = 0; i < s->count; i++ ) {
+		MeshDelete( s->chunks[ i ].mesh );
+		ClustersDelete( s->chunks[ i ].clusters );
+	}
+	SDL_DestroyCond( s->wake );
+	SDL_DestroyMutex( s->mutex );
+	fclose( s->file );
+	free( s->chunks );
+	free( s->queue );
+	free( s->drawn );
+	free( s->visible );
+	free( s );
+}
+
+/**
+ * Distance de eye à la boîte, nulle à l'intérieur
+ */
+static float StreamDistance( aabb_t b, vec3f_t eye ) {
+	vec3f_t d;
+	d.x = MAX( MAX( b.min.x - eye.x, eye.x - b.max.x ), 0.0f );
+	d.y = MAX( MAX( b.min.y - eye.y, eye.y - b.max.y ), 0.0f );
+	d.z = MAX( MAX( b.min.z - eye.z, eye.z - b.max.z ), 0.0f );
+	return Vec3fLength( d );
+}
+
+static int StreamCompare( const void * a, const void * b ) {
+	float da = g_sorted[ *(const int*)a ].distance;
+	float db = g_sorted[ *(const int*)b ].distance;
+	return ( da > db ) - ( da < db );
+}
+
+/**
+ * Libère le morceau chargé vu le moins récemment, s'il n'est pas dans le champ
+ */
+static bool StreamEvict( stream_t * s ) {
+	int oldest = -1;
+	for ( int i = 0; i < s->count; i++ ) {
+		streamchunk_t * k = &s->chunks[ i ];
+		if ( k->state == STREAM_READY && k->used != s->frame && ( oldest < 0 || k->used < s->chunks[ oldest ].used ) ) {
+			oldest = i;
+		}
+	}
+	if ( oldest < 0 ) {
+		return false;
+	}
+	streamchunk_t * k = &s->chunks[ oldest ];
+	MeshDelete( k->mesh );
+	ClustersDelete( k->clusters );
+	k->mesh     = NULL;
+	k->clusters = NULL;
+	k->state    = STREAM_UNLOADED;
+	s->resident -= k->bytes;
+	s->evictions++;
+	return true;
+}
+
+void StreamUpdate( stream_t * s, camera_t * c ) {
+	if ( s == NULL ) {
+		return;
+	}
+	frustum_t f = CameraFrustum( c );
+	SDL_LockMutex( s->mutex );
+	s->frame++;
+
+	// Morceaux dans le champ, marqués comme vus pour ne pas être libérés, du plus proche au
+	// plus lointain
+	s->nvisible = 0;
+	for ( int i = 0; i < s->count; i++ ) {
+		streamchunk_t * k = &s->chunks[ i ];
+		if ( k->state == STREAM_FAILED || FrustumTestAabb( &f, k->record.box ) < 0 ) {
+			continue;
+		}
+		k->used = s->frame;
+		k->distance = StreamDistance( k->record.box, c->eye );
+		s->visible[ s->nvisible++ ] = i;
+	}
+	g_sorted = s->chunks;
+	qsort( s->visible, s->nvisible, sizeof( int ), StreamCompare );
+
+	// Les demandes pas encore servies sont annulées : la file est reconstruite pour cette vue
+	for ( int i = s->next; i < s->nqueue; i++ ) {
+		streamchunk_t * k = &s->chunks[ s->queue[ i ] ];
+		if ( k->state == STREAM_QUEUED ) {
+			k->state = STREAM_UNLOADED;
+			s->resident -= k->bytes;
+		}
+	}
+	s->nqueue = s->next = 0;
+
+	// Une fois la mémoire allouée atteinte, les morceaux plus lointains attendent
+	s->ndrawn = 0;
+	bool full = false;
+	for ( int i = 0; i < s->nvisible; i++ ) {
+		int index = s->visible[ i ];
+		streamchunk_t * k = &s->chunks[ index ];
+		if ( k->state == STREAM_READY ) {
+			s->drawn[ s->ndrawn++ ] = index;
+		}else if ( k->state == STREAM_UNLOADED && !full ) {
+			while ( s->resident + k->bytes > s->budget && StreamEvict( s ) ) {
+			}
+			if ( s->resident + k->bytes > s->budget ) {
+				full = true;
+				continue;
+			}
+			k->state = STREAM_QUEUED;
+			s->resident += k->bytes;
+			s->queue[ s->nqueue++ ] = index;
+		}
+	}
+	if ( s->nqueue > 0 ) {
+		SDL_CondSignal( s->wake );
+	}
+	SDL_UnlockMutex( s->mutex );
+}
+
+void StreamReport( stream_t * s ) {
+	if ( s == NULL ) {
+		return;
+	}
+	SDL_LockMutex( s->mutex );
+	int resident = 0;
+	for ( int i = 0; i < s->count; i++ ) {
+		resident += ( s->chunks[ i ].state == STREAM_READY );
+	}
+	printf( "(II) Stream: %d of %d chunks in view drawn, %d/%d resident (%.1f of %.1f MB), %d loads (%.1f MB, %.2f ms each), %d evictions\n",
+		s->ndrawn, s->nvisible, resident, s->count, s->resident / ( 1024.0 * 1024.0 ), s->budget / ( 1024.0 * 1024.0 ),
+		s->loads, s->bytesread / ( 1024.0 * 1024.0 ), ( s->loads > 0 ) ? 1000.0 * s->loadtime / s->loads : 0.0, s->evictions );
+	s->loads = s->evictions = 0;
+	s->bytesread = 0;
+	s->loadtime = 0.0;
+	SDL_UnlockMutex( s->mutex );
+}
@@ -0,0 +1,134 @@
+#ifndef __STREAM_H__
+#define __STREAM_H__
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "SDL2/SDL.h"
+#include "geometry.h"
+#include "camera.h"
+#include "mesh.h"
+#include "cluster.h"
+
+/**
+ * Fichier de morceaux : en-tte, table des morceaux, puis pour chaque morceau ses sommets,
+ * ses index, ses groupes de triangles et l'ordre de ses faces, dans l'ordre des octets de
+ * la machine qui l'a crit
+ */
+#define STREAM_MAGIC		0x43443345	// "E3DC"
+#define STREAM_VERSION		1
+
+/**
+ * Nombre de triangles vis par morceau lors du dcoupage
+ */
+#define STREAM_CHUNK_TRIANGLES	32768
+
+/**
+ * Mmoire alloue par dfaut aux morceaux chargs, en octets
+ */
+#define STREAM_BUDGET		( 256 * 1024 * 1024 )
+
+/**
+ * Etats d'un morceau
+ */
+#define STREAM_UNLOADED		0
+#define STREAM_QUEUED		1	// Demand, en attente du chargeur
+#define STREAM_LOADING		2	// En cours de lecture par le chargeur
+#define STREAM_READY		3
+#define STREAM_FAILED		4	// Lecture impossible, n'est plus demand
+
+/**
+ * Dfinition des types
+ */
+
+/**
+ * Entre de la table des morceaux, telle qu'crite dans le fichier
+ */
+typedef struct streamrecord {
+	aabb_t			box;
+	long long		offset;		// Position des donnes du morceau dans le fichier
+	int			nvertices;
+	int			nindices;
+	int			indexsize;
+	int			nclusters;
+}streamrecord_t;
+
+/**
+ * Morceau du modle : les champs state, mesh et clusters sont protgs par le verrou du
+ * flux, mesh et clusters ne sont librs que par le fil principal
+ */
+typedef struct streamchunk {
+	streamrecord_t		record;
+	size_t			bytes;		// Mmoire occupe une fois charg
+	int			state;
+	int			used;		// Dernire mise  jour o le morceau tait visible
+	float			distance;	// Distance  la camra lors de cette mise  jour
+	mesh_t		*	mesh;
+	clusters_t	*	clusters;
+}streamchunk_t;
+
+/**
+ * Modle lu morceau par morceau : seuls les morceaux dans le champ sont chargs, par un fil
+ * ddi, les moins rcemment vus tant librs quand la mmoire alloue est atteinte
+ */
+typedef struct stream {
+	FILE		*	file;
+	streamchunk_t	*	chunks;
+	int			count;
+	aabb_t			bounds;
+	size_t			budget;
+	size_t			resident;	// Mmoire des morceaux chargs, en cours de chargement ou demands
+	int		*	queue;		// Morceaux demands, du plus proche au plus lointain
+	int			nqueue;
+	int			next;		// Prochain morceau de la file  charger
+	int		*	visible;	// Morceaux dans le champ, du plus proche au plus lointain
+	int			nvisible;
+	int		*	drawn;		// Ceux qui sont chargs,  dessiner
+	int			ndrawn;
+	int			frame;
+	SDL_Thread	*	thread;
+	SDL_mutex	*	mutex;
+	SDL_cond	*	wake;
+	bool			quit;
+	int			loads;		// Compteurs depuis StreamReport
+	int			evictions;
+	long long		bytesread;
+	double			loadtime;	// Secondes passes par le chargeur  lire
+}stream_t;
+
+/**
+ * Dfinition des prototypes de fonctions
+ */
+
+/**
+ * Dcoupe un fichier OBJ en morceaux selon une grille rgulire, sans jamais le charger en
+ * entier : les attributs passent par des fichiers temporaires, puis les faces sont rparties
+ * par cellule avant que chaque morceau soit soud et crit dans chunkfilename
+ */
+bool				StreamBuild		( const char * objfilename, const char * chunkfilename );
+
+/**
+ * Ouvre un fichier de morceaux, dont seule la table est lue, et dmarre le chargeur.
+ * Retourne NULL si le fichier n'est pas lisible.
+ */
+stream_t		*	Stream			( const char * chunkfilename, size_t budget );
+
+/**
+ * Arrte le chargeur et libre tous les morceaux
+ */
+void				StreamDelete		( stream_t * s );
+
+/**
+ * Slectionne les morceaux dans le champ de la camra : ceux dj chargs sont placs dans
+ * drawn, les autres sont demands au chargeur du plus proche au plus lointain, tant que la
+ * mmoire alloue le permet aprs libration des morceaux hors champ les moins rcents.
+ * Ne bloque jamais sur une lecture : le chargeur rveille la boucle (EventsWake)  chaque
+ * morceau prt.
+ */
+void				StreamUpdate		( stream_t * s, camera_t * c );
+
+/**
+ * Affiche l'tat du cache et les chargements depuis l'appel prcdent
+ */
+void				StreamReport		( stream_t * s );
+
+#endif //__STREAM_H__
@@ -6,6 +6,15 @@ vector_t * Vector() {
 		v->data  = NULL;
 		v->size  = 0;
 		v->count = 0;
+		v->arena = NULL;
+	}
+	return v;
+}
+
+vector_t * VectorArena( arena_t * a ) {
+	vector_t * v = Vector();
+	if ( v != NULL ) {
+		v->arena = a;
 	}
 	return v;
 }
@@ -14,7 +23,7 @@ void VectorClear( vector_t * v ) {
 	if ( v != NULL ) {
 		if ( v->count != 0 ) {
 			if ( v->data != NULL ) {
-				for ( int i = 0; i < v->count; i++ ) {
+				for ( int i = 0; v->arena == NULL && i < v->count; i++ ) {
 					if ( v->data[ i ] != NULL ) {
 						free( v->data[ i ] );
 					}
@@ -32,7 +41,7 @@ void VectorClear( vector_t * v ) {
 void VectorDelete( vector_t * v ) {
 	if ( v != NULL ) {
 		if ( v->data != NULL ) {
-			for ( int i = 0; i < v->count; i++ ) {
+			for ( int i = 0; v->arena == NULL && i < v->count; i++ ) {
 				if ( v->data[ i ] != NULL ) {
 					free( v->data[ i ] );
 				}
@@ -49,9 +58,9 @@ void VectorAdd( vector_t * v, void * data ) {
 	if ( v != NULL ) {
 		if ( data != NULL ) {
 			if ( v->size == 0 ) {
-				v->size = 10;
-				v->data = (void**)malloc( sizeof( void * ) * v->size );
+				v->data = (void**)malloc( sizeof( void * ) * 10 );
 				if ( v->data != NULL ) {
+					v->size = 10;
 					memset( v->data, '\0', sizeof( void * ) * v->size );
 				}else {
 					printf( "(EE) Unable to add data to vector\n" );
@@ -59,10 +68,10 @@ void VectorAdd( vector_t * v, void * data ) {
 				}
 			} 
 			if ( v->size == v->count ) {
-				v->size *= 2;
-				void ** nv = (void **)realloc( v->data, sizeof( void * ) * v->size );
+				void ** nv = (void **)realloc( v->data, sizeof( void * ) * v->size * 2 );
 				if ( nv != NULL ) {
 					v->data = nv;
+					v->size *= 2;
 				}else {
 					printf( "(EE) Unable to realloc vector\n" );
 					return;
@@ -103,7 +112,7 @@ void VectorRemoveFromIdx( vector_t * v, int idx ) {
 
 void * VectorGetFromIdx( vector_t * v, int idx ) {
 	if ( v != NULL ) {
-		if ( idx >= v->count ) {
+		if ( idx < 0 || idx >= v->count ) {
 			return NULL;
 		}
 		return v->data[ idx ];
@@ -5,6 +5,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include "arena.h"
 
 /**
  * Dfinition des types
@@ -13,6 +14,7 @@ typedef struct vector {
 	void ** data;
     int size;
     int count;
+    arena_t * arena;	// Propritaire des lments, NULL s'ils sont allous un par un
 }vector_t;
 
 /**
@@ -24,6 +26,12 @@ typedef struct vector {
  */
 vector_t			*	Vector				();
 
+/**
+ * Construit un vecteur dont les lments sont allous dans l'arne a : ils sont librs
+ * avec elle, et non par VectorDelete ou VectorClear
+ */
+vector_t			*	VectorArena			( arena_t * a );
+
 /**
  * Supprime un vecteur
  */
@@ -1,29 +1,35 @@
 ﻿#include "window.h"
 #include "geometry.h"
-#include "model.h"
-#include "vector.h"
-
-static void WindowUpdateTexture( window_t * w ) {
-	Uint32 * dst;
-	int row, col;
-	void * pixels;
-	int pitch;
-	if ( SDL_LockTexture( w->texture, NULL, &pixels, &pitch ) < 0 ) {
-		SDL_LogError( SDL_LOG_CATEGORY_APPLICATION, "Couldn't lock texture: %s\n", SDL_GetError() );
-		SDL_Quit();
-	}
-	Uint8 * ptr = w->framebuffer;
-	for ( row = 0; row < w->height; ++row ) {
-		dst = (Uint32*)( (Uint8*)pixels + row * pitch );
-		for ( col = 0; col < w->width; ++col ) {
-			Uint8 b = *ptr++;
-			Uint8 g = *ptr++;
-			Uint8 r = *ptr++;
-			Uint8 a = *ptr++;
-			*dst++ = ( ( b << 24 ) | ( g << 16 ) | ( r << 8 ) | a );
+
+static void WindowUpdateTexture( window_t * w, const SDL_Rect * rect ) {
+	// En multi-échantillonnage, la résolution des échantillons se fait pendant la copie
+	if ( w->samples > 1 ) {
+		void * pixels;
+		int pitch;
+		if ( SDL_LockTexture( w->texture, rect, &pixels, &pitch ) < 0 ) {
+			SDL_LogError( SDL_LOG_CATEGORY_APPLICATION, "Couldn't lock texture: %s\n", SDL_GetError() );
+			SDL_Quit();
+		}
+		for ( int row = 0; row < rect->h; ++row ) {
+			Uint32 * dst = (Uint32*)( (Uint8*)pixels + row * pitch );
+			const Uint32 * src = WindowSamplePixels( w, rect->x, rect->y + row );
+			for ( int col = 0; col < rect->w; ++col ) {
+				*dst++ = WindowResolve( src );
+				src += WINDOW_SAMPLES;
+			}
+		}
+		SDL_UnlockTexture( w->texture );
+	}else {
+		// Texture au format du framebuffer : copie directe, sans conversion
+		if ( SDL_UpdateTexture( w->texture, rect, WindowPixels( w, rect->x, rect->y ), w->pitch ) < 0 ) {
+			SDL_LogError( SDL_LOG_CATEGORY_APPLICATION, "Couldn't update texture: %s\n", SDL_GetError() );
 		}
 	}
-	SDL_UnlockTexture( w->texture );
+	// Seul le coin de la texture à la résolution interne est présenté
+	w->source.x = 0;
+	w->source.y = 0;
+	w->source.w = w->width;
+	w->source.h = w->height;
 }
 
 static Uint8 * WindowInitFramebuffer( window_t * w ) {
@@ -63,7 +69,9 @@ window_t * WindowInit( int width, int height, int bpp ) {
 		return NULL;
 	}
 
-	SDL_Texture * texture = SDL_CreateTexture( renderer, SDL_PIXELFORMAT_BGRA8888, SDL_TEXTUREACCESS_STREAMING, width, height );
+	// Filtrage bilinéaire quand une résolution interne réduite est agrandie à la présentation
+	SDL_SetHint( SDL_HINT_RENDER_SCALE_QUALITY, "linear" );
+	SDL_Texture * texture = SDL_CreateTexture( renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, width, height );
 	
 	if ( texture == NULL ) {
 		SDL_LogError( SDL_LOG_CATEGORY_APPLICATION, "Couldn't create texture: %s\n", SDL_GetError() );
@@ -82,8 +90,20 @@ window_t * WindowInit( int width, int height, int bpp ) {
 
 	mainwindow->width	= width;
 	mainwindow->height	= height;
+	mainwindow->displaywidth	= width;
+	mainwindow->displayheight	= height;
+	mainwindow->source.x	= 0;
+	mainwindow->source.y	= 0;
+	mainwindow->source.w	= width;
+	mainwindow->source.h	= height;
 	mainwindow->bpp		= bpp;
 	mainwindow->pitch	= width * bpp;
+	mainwindow->present	= WINDOW_PRESENT_QUEUED;
+
+	// Fréquence de l'écran, pour caler le dessin sur la synchronisation verticale
+	SDL_DisplayMode mode;
+	bool known = SDL_GetWindowDisplayMode( sdlwindow, &mode ) == 0 && mode.refresh_rate > 0;
+	mainwindow->refresh	= known ? mode.refresh_rate : WINDOW_REFRESH;
 
 	Uint8 * framebuffer = WindowInitFramebuffer( mainwindow );
 
@@ -93,7 +113,20 @@ window_t * WindowInit( int width, int height, int bpp ) {
 		return NULL;
 	}
 
+	float * zbuffer = (float*)malloc( sizeof( float ) * width * height );
+
+	if ( zbuffer == NULL ) {
+		SDL_LogError( SDL_LOG_CATEGORY_APPLICATION, "Couldn't allocate depth buffer\n" );
+		SDL_Quit();
+		return NULL;
+	}
+
 	mainwindow->framebuffer = framebuffer;
+	mainwindow->zbuffer	= zbuffer;
+	mainwindow->counter	= NULL;
+	mainwindow->samples	= 1;
+	mainwindow->samplecolor	= NULL;
+	mainwindow->sampledepth	= NULL;
 	mainwindow->sdlwindow	= sdlwindow;
 	mainwindow->renderer	= renderer;
 	mainwindow->texture		= texture;
@@ -106,74 +139,408 @@ void WindowDestroy( window_t * w ) {
 	SDL_DestroyTexture( w->texture );
 	SDL_DestroyWindow( w->sdlwindow );
 	free( w->framebuffer );
+	free( w->zbuffer );
+	free( w->counter );
+	free( w->samplecolor );
+	free( w->sampledepth );
 	SDL_Quit();
 }
 
 void WindowUpdate( window_t * w ) {
+	SDL_Rect rect = { 0, 0, w->width, w->height };
+	WindowUpdateRect( w, &rect );
+}
+
+bool WindowUpdateRect( window_t * w, const SDL_Rect * rect ) {
+	bool copy = rect != NULL && rect->w > 0 && rect->h > 0;
+	bool queued = w->present == WINDOW_PRESENT_QUEUED;
+	if ( copy && !queued ) {
+		WindowUpdateTexture( w, rect );
+	}
 	SDL_RenderClear( w->renderer );
-	SDL_RenderCopy( w->renderer, w->texture, NULL, NULL );
+	SDL_RenderCopy( w->renderer, w->texture, &w->source, NULL );
 	SDL_RenderPresent( w->renderer );
-	WindowUpdateTexture( w );
+	if ( copy && queued ) {
+		WindowUpdateTexture( w, rect );
+	}
+	return !( copy && queued );
+}
+
+void WindowPresentMode( window_t * w, int mode ) {
+	if ( SDL_RenderSetVSync( w->renderer, mode != WINDOW_PRESENT_IMMEDIATE ) != 0 ) {
+		printf( "(EE) Couldn't change vertical synchronization: %s\n", SDL_GetError() );
+	}
+	w->present = mode;
+}
+
+bool WindowResize( window_t * w, int width, int height ) {
+	width  = MIN( MAX( width, 1 ), w->displaywidth );
+	height = MIN( MAX( height, 1 ), w->displayheight );
+	if ( width == w->width && height == w->height ) {
+		return true;
+	}
+	Uint8 * framebuffer = (Uint8*)malloc( width * height * w->bpp );
+	float * zbuffer = (float*)malloc( sizeof( float ) * width * height );
+	if ( framebuffer == NULL || zbuffer == NULL ) {
+		SDL_LogError( SDL_LOG_CATEGORY_APPLICATION, "Couldn't allocate %dx%d framebuffer\n", width, height );
+		free( framebuffer );
+		free( zbuffer );
+		return false;
+	}
+	// Les tampons d'échantillons et le compteur sont réalloués à la demande à la nouvelle taille
+	WindowSamples( w, 1 );
+	free( w->framebuffer );
+	free( w->zbuffer );
+	free( w->counter );
+	w->framebuffer	= framebuffer;
+	w->zbuffer	= zbuffer;
+	w->counter	= NULL;
+	w->width	= width;
+	w->height	= height;
+	w->pitch	= width * w->bpp;
+	return true;
 }
 
 void WindowDrawPoint( window_t * w, int x, int y, Uint8 r, Uint8 g, Uint8 b ) {
-	Uint32 * dst = (Uint32*)w->framebuffer + y * w->width + x;
-	*dst = (0xFF << 24) | (r << 16) | ( g << 8) | b;
+	// Comparaison non signée : couvre aussi les coordonnées négatives
+	if ( (unsigned)x >= (unsigned)w->width || (unsigned)y >= (unsigned)w->height ) {
+		return;
+	}
+	WindowPutPixel( w, x, y, WindowColor( r, g, b ) );
+}
+
+void WindowFillSpan( window_t * w, int x0, int x1, int y, Uint32 color ) {
+	if ( (unsigned)y >= (unsigned)w->height ) {
+		return;
+	}
+	x0 = MAX( x0, 0 );
+	x1 = MIN( x1, w->width - 1 );
+	Uint32 * dst = WindowPixels( w, 0, y );
+	for ( int x = x0; x <= x1; x++ ) {
+		dst[ x ] = color;
+	}
+}
+
+void WindowFillRect( window_t * w, int x, int y, int width, int height, Uint32 color ) {
+	int x0 = MAX( x, 0 ), x1 = MIN( x + width, w->width );
+	int y0 = MAX( y, 0 ), y1 = MIN( y + height, w->height );
+	if ( x0 >= x1 || y0 >= y1 ) {
+		return;
+	}
+	// Première ligne remplie pixel par pixel, les suivantes recopiées d'un bloc
+	Uint32 * first = WindowPixels( w, x0, y0 );
+	for ( int i = 0; i < x1 - x0; i++ ) {
+		first[ i ] = color;
+	}
+	for ( int row = y0 + 1; row < y1; row++ ) {
+		memcpy( WindowPixels( w, x0, row ), first, ( x1 - x0 ) * sizeof( Uint32 ) );
+	}
+}
+
+void WindowClearRect( window_t * w, const SDL_Rect * rect, Uint32 color ) {
+	int x0 = MAX( rect->x, 0 ), x1 = MIN( rect->x + rect->w, w->width );
+	int y0 = MAX( rect->y, 0 ), y1 = MIN( rect->y + rect->h, w->height );
+	if ( x0 >= x1 || y0 >= y1 ) {
+		return;
+	}
+	if ( w->samples > 1 ) {
+		for ( int y = y0; y < y1; y++ ) {
+			Uint32 * s = WindowSamplePixels( w, x0, y );
+			float * d = WindowSampleDepths( w, x0, y );
+			for ( int i = 0; i < ( x1 - x0 ) * WINDOW_SAMPLES; i++ ) {
+				s[ i ] = color;
+				d[ i ] = 1.0f;
+			}
+		}
+		return;
+	}
+	WindowFillRect( w, x0, y0, x1 - x0, y1 - y0, color );
+	for ( int y = y0; y < y1; y++ ) {
+		float * d = WindowDepths( w, x0, y );
+		for ( int i = 0; i < x1 - x0; i++ ) {
+			d[ i ] = 1.0f;
+		}
+	}
+}
+
+void WindowClearDepth( window_t * w ) {
+	int n = w->width * w->height;
+	if ( w->samples > 1 ) {
+		for ( int i = 0; i < n * WINDOW_SAMPLES; i++ ) {
+			w->sampledepth[ i ] = 1.0f;
+		}
+		return;
+	}
+	for ( int i = 0; i < n; i++ ) {
+		w->zbuffer[ i ] = 1.0f;
+	}
 }
 
 void WindowDrawClearColor( window_t * w, Uint8 r, Uint8 g, Uint8 b ) {
-	for ( int row = 0; row < w->height; row++ ) {
-		for ( int col = 0; col < w->width; col++ ) {
-			WindowDrawPoint(w, col, row, r, g, b);
+	if ( w->samples > 1 ) {
+		Uint32 color = WindowColor( r, g, b );
+		for ( int i = 0; i < w->width * w->height * WINDOW_SAMPLES; i++ ) {
+			w->samplecolor[ i ] = color;
 		}
+		return;
 	}
+	WindowFillRect( w, 0, 0, w->width, w->height, WindowColor( r, g, b ) );
 }
 
-void WindowDrawLine( window_t * w, int x0, int y0, int x1, int y1, Uint8 r, Uint8 g, Uint8 b ) {
-	bool s = false;
-	if ( (x1 - x0) == 0.0f ){
-		int miny = MIN(y0, y1);
-		int maxy = MAX(y0, y1);
-		for (int y_courant = miny ; y_courant < maxy ; y_courant++){
-			WindowDrawPoint(w, x0, y_courant, r, g, b);
-		}
-	}
-	else{
-		if ( (y1 - y0)/(x1 - x0) < 1){
-			swap(&x0, &y0);
-			swap(&x1, &y1);
-			s = true;
-		}
-
-		float coef = (y1 - y0)/(x1 - x0);
-		float offset = y0 - coef * x0;
-		int minx   = MIN(x0, x1);
-		int maxx   = MAX(x0, x1);
-
-		int y_courant = 0;
-		for (int x_courant = minx ; x_courant < maxx ; x_courant++){
-			y_courant = coef*x_courant + offset;
-			if(s){
-				WindowDrawPoint(w, y_courant, x_courant, r, g, b);
+void WindowSamples( window_t * w, int samples ) {
+	int n = w->width * w->height;
+	samples = ( samples > 1 ) ? WINDOW_SAMPLES : 1;
+	if ( samples == w->samples ) {
+		return;
+	}
+	if ( samples == 1 ) {
+		for ( int i = 0; i < n; i++ ) {
+			const float * d = w->sampledepth + i * WINDOW_SAMPLES;
+			( (Uint32*)w->framebuffer )[ i ] = WindowResolve( w->samplecolor + i * WINDOW_SAMPLES );
+			w->zbuffer[ i ] = MIN( MIN( d[ 0 ], d[ 1 ] ), MIN( d[ 2 ], d[ 3 ] ) );
+		}
+		free( w->samplecolor );
+		free( w->sampledepth );
+		w->samplecolor = NULL;
+		w->sampledepth = NULL;
+		w->samples = 1;
+		return;
+	}
+	w->samplecolor = (Uint32*)malloc( sizeof( Uint32 ) * n * WINDOW_SAMPLES );
+	w->sampledepth = (float*)malloc( sizeof( float ) * n * WINDOW_SAMPLES );
+	if ( w->samplecolor == NULL || w->sampledepth == NULL ) {
+		SDL_LogError( SDL_LOG_CATEGORY_APPLICATION, "Couldn't allocate sample buffers\n" );
+		free( w->samplecolor );
+		free( w->sampledepth );
+		w->samplecolor = NULL;
+		w->sampledepth = NULL;
+		return;
+	}
+	for ( int i = 0; i < n; i++ ) {
+		for ( int k = 0; k < WINDOW_SAMPLES; k++ ) {
+			w->samplecolor[ i * WINDOW_SAMPLES + k ] = ( (Uint32*)w->framebuffer )[ i ];
+			w->sampledepth[ i * WINDOW_SAMPLES + k ] = w->zbuffer[ i ];
+		}
+	}
+	w->samples = samples;
+}
+
+void WindowResetCounter( window_t * w, bool enable ) {
+	// Sans compteur, les remplissages ne paient qu'un test de pointeur par ligne
+	if ( !enable ) {
+		free( w->counter );
+		w->counter = NULL;
+		return;
+	}
+	if ( w->counter == NULL ) {
+		w->counter = (Uint16*)malloc( sizeof( Uint16 ) * w->width * w->height );
+		if ( w->counter == NULL ) {
+			SDL_LogError( SDL_LOG_CATEGORY_APPLICATION, "Couldn't allocate overdraw counter\n" );
+			return;
+		}
+	}
+	memset( w->counter, 0, sizeof( Uint16 ) * w->width * w->height );
+}
+
+int WindowDrawHeatmap( window_t * w ) {
+	// Noir : jamais écrit, puis bleu, vert, jaune, orange, rouge et blanc au-delà de 8 écritures
+	static const Uint8 palette[ 9 ][ 3 ] = {
+		{ 0, 0, 0 }, { 0, 0, 255 }, { 0, 255, 0 }, { 255, 255, 0 }, { 255, 128, 0 },
+		{ 255, 0, 0 }, { 255, 0, 0 }, { 255, 0, 0 }, { 255, 255, 255 }
+	};
+	if ( w->counter == NULL ) {
+		return 0;
+	}
+	Uint32 colors[ 9 ];
+	for ( int i = 0; i < 9; i++ ) {
+		colors[ i ] = WindowColor( palette[ i ][ 0 ], palette[ i ][ 1 ], palette[ i ][ 2 ] );
+	}
+	int n = w->width * w->height, maximum = 0;
+	Uint32 * dst = WindowPixels( w, 0, 0 );
+	for ( int i = 0; i < n; i++ ) {
+		int count = w->counter[ i ];
+		maximum = MAX( maximum, count );
+		dst[ i ] = colors[ MIN( count, 8 ) ];
+	}
+	return maximum;
+}
+
+#define WINDOW_CLIP_LEFT	1
+#define WINDOW_CLIP_RIGHT	2
+#define WINDOW_CLIP_TOP		4
+#define WINDOW_CLIP_BOTTOM	8
+
+static int WindowClipCode( window_t * w, int x, int y ) {
+	int code = 0;
+	if ( x < 0 ) code |= WINDOW_CLIP_LEFT;
+	else if ( x >= w->width ) code |= WINDOW_CLIP_RIGHT;
+	if ( y < 0 ) code |= WINDOW_CLIP_TOP;
+	else if ( y >= w->height ) code |= WINDOW_CLIP_BOTTOM;
+	return code;
+}
+
+/**
+ * Découpe un segment contre la fenêtre (Cohen-Sutherland).
+ * Retourne faux si le segment est entièrement hors de la fenêtre.
+ */
+static bool WindowClipLine( window_t * w, int * x0, int * y0, int * x1, int * y1 ) {
+	int c0 = WindowClipCode( w, *x0, *y0 );
+	int c1 = WindowClipCode( w, *x1, *y1 );
+	while ( c0 | c1 ) {
+		if ( c0 & c1 ) {
+			return false;
+		}
+		int c = c0 ? c0 : c1;
+		long long dx = *x1 - *x0, dy = *y1 - *y0;
+		int x, y;
+		if ( c & WINDOW_CLIP_TOP ) {
+			y = 0;
+			x = *x0 + (int)( dx * ( y - *y0 ) / dy );
+		}else if ( c & WINDOW_CLIP_BOTTOM ) {
+			y = w->height - 1;
+			x = *x0 + (int)( dx * ( y - *y0 ) / dy );
+		}else if ( c & WINDOW_CLIP_LEFT ) {
+			x = 0;
+			y = *y0 + (int)( dy * ( x - *x0 ) / dx );
+		}else {
+			x = w->width - 1;
+			y = *y0 + (int)( dy * ( x - *x0 ) / dx );
+		}
+		if ( c == c0 ) {
+			*x0 = x; *y0 = y;
+			c0 = WindowClipCode( w, x, y );
+		}else {
+			*x1 = x; *y1 = y;
+			c1 = WindowClipCode( w, x, y );
+		}
+	}
+	return true;
+}
+
+/**
+ * Trace un segment déjà découpé par l'algorithme de Bresenham, en entiers uniquement
+ */
+static void WindowBresenham( window_t * w, int x0, int y0, int x1, int y1, Uint32 color ) {
+	int dx = abs( x1 - x0 ), dy = abs( y1 - y0 );
+	int sx = ( x0 < x1 ) ? 1 : -1;
+	int sy = ( y0 < y1 ) ? w->width : -w->width;
+	Uint32 * dst = WindowPixels( w, x0, y0 );
+	if ( dx >= dy ) {
+		int err = 2 * dy - dx;
+		for ( int i = 0; i <= dx; i++ ) {
+			*dst = color;
+			if ( err > 0 ) {
+				dst += sy;
+				err -= 2 * dx;
 			}
-			else{
-				WindowDrawPoint(w, x_courant, y_courant, r, g, b);
+			dst += sx;
+			err += 2 * dy;
+		}
+	}else {
+		int err = 2 * dx - dy;
+		for ( int i = 0; i <= dy; i++ ) {
+			*dst = color;
+			if ( err > 0 ) {
+				dst += sx;
+				err -= 2 * dy;
 			}
+			dst += sy;
+			err += 2 * dx;
 		}
 	}
-	
 }
 
-void WindowDrawTriangle( window_t * w, int idx ) { 
-		face_t * face = (face_t*) VectorGetFromIdx( ModelFaces(), idx );
-		vec3f_t *s1 = (vec3f_t*) VectorGetFromIdx(ModelVertices(), face->v[0]-1);
-		vec3f_t *s2 = (vec3f_t*) VectorGetFromIdx(ModelVertices(), face->v[1]-1);
-		vec3f_t *s3 = (vec3f_t*) VectorGetFromIdx(ModelVertices(), face->v[2]-1);
-		
-		WindowDrawLine(w, (int) (s1->x+1)*w->width, (int) (s1->y+1)*w->height, (int) (s2->x+1)*w->width, (int) (s2->y+1)*w->height, 200, 200, 200);
-		//WindowDrawLine(w, (int) s3->x, (int) s3->y, (int) s2->x, (int) s2->y, 200, 200, 200);
-		//WindowDrawLine(w, (int) s1->x, (int) s1->y, (int) s3->x, (int) s3->y, 200, 200, 200);
+void WindowDrawLine( window_t * w, int x0, int y0, int x1, int y1, Uint8 r, Uint8 g, Uint8 b ) {
+	if ( !WindowClipLine( w, &x0, &y0, &x1, &y1 ) ) {
+		return;
+	}
+	if ( y0 == y1 ) {
+		WindowFillSpan( w, MIN( x0, x1 ), MAX( x0, x1 ), y0, WindowColor( r, g, b ) );
+	}else {
+		WindowBresenham( w, x0, y0, x1, y1, WindowColor( r, g, b ) );
+	}
+}
+
+void WindowDrawLines( window_t * w, const vec2i_t * points, int count, Uint32 color ) {
+	for ( int i = 0; i < count; i++ ) {
+		int x0 = points[ i * 2 ].x, y0 = points[ i * 2 ].y;
+		int x1 = points[ i * 2 + 1 ].x, y1 = points[ i * 2 + 1 ].y;
+		// Les segments entièrement dans la fenêtre, cas courant, évitent la boucle de découpage
+		if ( ( WindowClipCode( w, x0, y0 ) | WindowClipCode( w, x1, y1 ) ) == 0 || WindowClipLine( w, &x0, &y0, &x1, &y1 ) ) {
+			WindowBresenham( w, x0, y0, x1, y1, color );
+		}
+	}
+}
 
+/**
+ * Découpe un segment flottant contre le rectangle [0, xmax] x [0, ymax] (Liang-Barsky)
+ */
+static bool WindowClipLinef( float xmax, float ymax, vec2f_t * a, vec2f_t * b ) {
+	float t0 = 0.0f, t1 = 1.0f;
+	float dx = b->x - a->x, dy = b->y - a->y;
+	float p[ 4 ] = { -dx, dx, -dy, dy };
+	float q[ 4 ] = { a->x, xmax - a->x, a->y, ymax - a->y };
+	for ( int i = 0; i < 4; i++ ) {
+		if ( p[ i ] == 0.0f ) {
+			if ( q[ i ] < 0.0f ) {
+				return false;
+			}
+		}else {
+			float t = q[ i ] / p[ i ];
+			if ( p[ i ] < 0.0f ) {
+				t0 = MAX( t0, t );
+			}else {
+				t1 = MIN( t1, t );
+			}
+		}
+	}
+	if ( t0 > t1 ) {
+		return false;
+	}
+	vec2f_t o = *a;
+	a->x = o.x + t0 * dx; a->y = o.y + t0 * dy;
+	b->x = o.x + t1 * dx; b->y = o.y + t1 * dy;
+	return true;
 }
 
+/**
+ * Mélange une couleur dans un pixel avec la couverture c dans [0, 256]
+ */
+static inline void WindowBlend( Uint32 * dst, Uint32 color, int c ) {
+	Uint32 d = *dst;
+	Uint32 rb = ( ( ( color & 0xFF00FF ) * c + ( d & 0xFF00FF ) * ( 256 - c ) ) >> 8 ) & 0xFF00FF;
+	Uint32 g  = ( ( ( color & 0x00FF00 ) * c + ( d & 0x00FF00 ) * ( 256 - c ) ) >> 8 ) & 0x00FF00;
+	*dst = 0xFF000000 | rb | g;
+}
 
+void WindowDrawLinesAA( window_t * w, const vec2f_t * points, int count, Uint32 color ) {
+	for ( int i = 0; i < count; i++ ) {
+		vec2f_t a = points[ i * 2 ], b = points[ i * 2 + 1 ];
+		// Le pixel voisin écrit par l'algorithme de Wu doit rester dans la fenêtre
+		if ( !WindowClipLinef( w->width - 2, w->height - 2, &a, &b ) ) {
+			continue;
+		}
+		bool steep = fabsf( b.y - a.y ) > fabsf( b.x - a.x );
+		if ( steep ) {
+			float t;
+			t = a.x; a.x = a.y; a.y = t;
+			t = b.x; b.x = b.y; b.y = t;
+		}
+		if ( a.x > b.x ) {
+			Vec2fSwap( &a, &b );
+		}
+		float gradient = ( b.x - a.x > 0.0f ) ? ( b.y - a.y ) / ( b.x - a.x ) : 0.0f;
+		int x0 = (int)( a.x + 0.5f ), x1 = (int)( b.x + 0.5f );
+		float y = a.y + gradient * ( x0 - a.x );
+		// Deux pixels par colonne, pondérés par la distance au segment (virgule fixe 8 bits)
+		for ( int x = x0; x <= x1; x++ ) {
+			int yi = MAX( (int)y, 0 );
+			int c = MIN( MAX( (int)( ( y - yi ) * 256.0f ), 0 ), 256 );
+			Uint32 * p0 = steep ? WindowPixels( w, yi, x ) : WindowPixels( w, x, yi );
+			Uint32 * p1 = steep ? p0 + 1 : p0 + w->width;
+			WindowBlend( p0, color, 256 - c );
+			WindowBlend( p1, color, c );
+			y += gradient;
+		}
+	}
+}
@@ -7,6 +7,30 @@
 #include <stdbool.h>
 #include <math.h>
 #include "SDL2/SDL.h"
+#include "geometry.h"
+
+/**
+ * Nombre d'chantillons par pixel du multi-chantillonnage
+ */
+#define WINDOW_SAMPLES		4
+
+/**
+ * Modes de prsentation :
+ * - WINDOW_PRESENT_QUEUED prsente la trame prcdente puis copie la nouvelle, qui attend
+ *   la prsentation suivante (une trame de latence en plus)
+ * - WINDOW_PRESENT_LOWLATENCY copie puis prsente aussitt, synchronis sur l'cran
+ * - WINDOW_PRESENT_IMMEDIATE copie puis prsente sans attendre la synchronisation verticale,
+ *   au prix d'un dchirement possible
+ */
+#define WINDOW_PRESENT_QUEUED		0
+#define WINDOW_PRESENT_LOWLATENCY	1
+#define WINDOW_PRESENT_IMMEDIATE	2
+#define WINDOW_PRESENT_MODES		3
+
+/**
+ * Frquence suppose de l'cran quand SDL ne la connat pas, en hertz
+ */
+#define WINDOW_REFRESH		60
 
 /**
  * Dfinition des types
@@ -16,10 +40,20 @@ typedef struct window {
 	SDL_Renderer	*	renderer;
 	SDL_Texture	*	texture;
 	unsigned char	*	framebuffer;
-	int			width;
+	float		*	zbuffer;
+	Uint16		*	counter;	// Ecritures par pixel (carte de surcharge), allou  la demande
+	int			samples;	// 1, ou WINDOW_SAMPLES : les remplissages crivent alors dans les tampons suivants
+	Uint32		*	samplecolor;	// Couleurs des chantillons, WINDOW_SAMPLES conscutifs par pixel
+	float		*	sampledepth;	// Profondeurs des chantillons, mme disposition
+	int			width;		// Rsolution interne du framebuffer, variable (WindowResize)
 	int			height;
+	int			displaywidth;	// Taille fixe de la fentre SDL et de sa texture
+	int			displayheight;
+	SDL_Rect		source;		// Partie de la texture remplie par la dernire copie, agrandie  la prsentation
 	int			bpp;
 	int			pitch;
+	int			present;	// Mode de prsentation, WINDOW_PRESENT_*
+	int			refresh;	// Frquence de l'cran, en hertz
 }window_t;
 
 /**
@@ -41,21 +75,141 @@ void			WindowDestroy		( window_t * w );
  */
 void			WindowDrawClearColor	( window_t * w, unsigned char r, unsigned char g, unsigned char b );
 
+/**
+ * Remet le tampon de profondeur de la fentre au plus loin
+ */
+void			WindowClearDepth	( window_t * w );
+
+/**
+ * Choisit le nombre d'chantillons par pixel (1 ou WINDOW_SAMPLES). En entrant en
+ * multi-chantillonnage, chaque chantillon reprend la couleur et la profondeur de son
+ * pixel ; en sortant, les chantillons sont moyenns dans le framebuffer.
+ */
+void			WindowSamples		( window_t * w, int samples );
+
+/**
+ * Change la rsolution interne (framebuffer, profondeur, compteur d'critures), borne 
+ * la taille de la fentre, et quitte le multi-chantillonnage. La fentre et sa texture
+ * gardent leur taille : l'image est agrandie  la prsentation. Retourne faux si
+ * l'allocation choue, la rsolution prcdente tant alors conserve.
+ */
+bool			WindowResize		( window_t * w, int width, int height );
+
+/**
+ * Efface couleur et profondeur d'un rectangle, dcoup contre la fentre (chantillons
+ * compris en multi-chantillonnage)
+ */
+void			WindowClearRect		( window_t * w, const SDL_Rect * rect, Uint32 color );
+
 /**
  * Met  jour le contenu de la fentre
  */
 void			WindowUpdate		( window_t * w );
 
 /**
- * Dessine un point color dans la fentre
+ * Copie dans la texture le seul rectangle donn du framebuffer, qui doit tre dans ses
+ * bords (le reste de la texture garde la trame prcdente), et prsente la fentre. En
+ * mode WINDOW_PRESENT_QUEUED, la prsentation prcde la copie : retourne vrai si le
+ * rectangle copi est dj  l'cran, faux s'il attend la prsentation suivante. Avec
+ * rect NULL ou vide, la texture est prsente  nouveau, sans aucune copie.
+ */
+bool			WindowUpdateRect	( window_t * w, const SDL_Rect * rect );
+
+/**
+ * Choisit le mode de prsentation (WINDOW_PRESENT_*) et la synchronisation verticale qui va avec
+ */
+void			WindowPresentMode	( window_t * w, int mode );
+
+/**
+ * Dessine un point color dans la fentre, ignor s'il est hors de ses bords
  */
 void			WindowDrawPoint		( window_t * w, int x, int y, Uint8 r, Uint8 g, Uint8 b );
 
 /**
- * Dessine une ligne colore dans la fentre
+ * Remet  zro le compteur d'critures par pixel (allou au premier appel), ou le libre si enable est faux
+ */
+void			WindowResetCounter	( window_t * w, bool enable );
+
+/**
+ * Remplace le framebuffer par la carte de chaleur du compteur d'critures, retourne le maximum
+ */
+int			WindowDrawHeatmap	( window_t * w );
+
+/**
+ * Remplit les pixels x0  x1 inclus de la ligne y, dcoups contre la fentre
+ */
+void			WindowFillSpan		( window_t * w, int x0, int x1, int y, Uint32 color );
+
+/**
+ * Remplit un rectangle de width x height pixels, dcoup contre la fentre
+ */
+void			WindowFillRect		( window_t * w, int x, int y, int width, int height, Uint32 color );
+
+/**
+ * Dessine une ligne colore dans la fentre, dcoupe contre ses bords
  */
 void			WindowDrawLine		( window_t * w, int x0, int y0, int x1, int y1, Uint8 r, Uint8 g, Uint8 b );
 
-void 			WindowDrawTriangle	( window_t * w, int idx );
+/**
+ * Dessine count lignes d'une mme couleur, donnes par paires d'extrmits conscutives
+ */
+void			WindowDrawLines		( window_t * w, const vec2i_t * points, int count, Uint32 color );
+
+/**
+ * Dessine count lignes anti-crneles (algorithme de Wu) aux extrmits flottantes
+ */
+void			WindowDrawLinesAA	( window_t * w, const vec2f_t * points, int count, Uint32 color );
+
+/**
+ * Retourne la valeur d'un pixel du framebuffer pour une couleur
+ */
+inline Uint32 WindowColor( Uint8 r, Uint8 g, Uint8 b ) {
+	return (0xFF << 24) | (r << 16) | ( g << 8) | b;
+}
+
+/**
+ * Retourne l'adresse du pixel (x, y) du framebuffer, sans vrification des bords
+ */
+inline Uint32 * WindowPixels( window_t * w, int x, int y ) {
+	return (Uint32*)w->framebuffer + y * w->width + x;
+}
+
+/**
+ * Retourne l'adresse de la profondeur du pixel (x, y), sans vrification des bords
+ */
+inline float * WindowDepths( window_t * w, int x, int y ) {
+	return w->zbuffer + y * w->width + x;
+}
+
+/**
+ * Retourne l'adresse des chantillons du pixel (x, y), sans vrification des bords
+ */
+inline Uint32 * WindowSamplePixels( window_t * w, int x, int y ) {
+	return w->samplecolor + ( y * w->width + x ) * WINDOW_SAMPLES;
+}
+
+/**
+ * Retourne l'adresse des profondeurs des chantillons du pixel (x, y), sans vrification des bords
+ */
+inline float * WindowSampleDepths( window_t * w, int x, int y ) {
+	return w->sampledepth + ( y * w->width + x ) * WINDOW_SAMPLES;
+}
+
+/**
+ * Moyenne des WINDOW_SAMPLES chantillons d'un pixel, composante par composante
+ */
+inline Uint32 WindowResolve( const Uint32 * s ) {
+	// Rouge et bleu additionns ensemble, vert et alpha dcals : aucune retenue ne dborde
+	Uint32 rb = ( s[ 0 ] & 0xFF00FF ) + ( s[ 1 ] & 0xFF00FF ) + ( s[ 2 ] & 0xFF00FF ) + ( s[ 3 ] & 0xFF00FF ) + 0x020002;
+	Uint32 ag = ( ( s[ 0 ] >> 8 ) & 0xFF00FF ) + ( ( s[ 1 ] >> 8 ) & 0xFF00FF ) + ( ( s[ 2 ] >> 8 ) & 0xFF00FF ) + ( ( s[ 3 ] >> 8 ) & 0xFF00FF ) + 0x020002;
+	return ( ( rb >> 2 ) & 0xFF00FF ) | ( ( ag << 6 ) & 0xFF00FF00 );
+}
+
+/**
+ * Ecrit un pixel sans vrification des bords, rserv aux appelants qui ont dj dcoup
+ */
+inline void WindowPutPixel( window_t * w, int x, int y, Uint32 color ) {
+	*WindowPixels( w, x, y ) = color;
+}
 
 #endif //__WINDOW_H__
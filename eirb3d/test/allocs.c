@@ -0,0 +1,105 @@
+#include "test.h"
+#include "render.h"
+#include "model.h"
+#include "camera.h"
+
+#define TEST_WIDTH		400
+#define TEST_HEIGHT		300
+#define TEST_MODEL		"./bin/data/diablo.obj"
+#define TEST_WARMUP		3	// Trames dessinées avant la mesure : tampons et arène de trame à leur taille
+#define TEST_FRAME_ALLOCS	32	// Par trame, seules les matrices de caméra et de lumière sont allouées
+
+// Appels à malloc, calloc et realloc comptés par les fonctions __wrap_ ci-dessous, l'éditeur
+// de liens y redirigeant les allocations de tout le programme (-Wl,--wrap, voir le makefile)
+static int g_allocs = 0;
+static int g_frees  = 0;
+
+extern "C" {
+void *	__real_malloc	( size_t size );
+void *	__real_calloc	( size_t count, size_t size );
+void *	__real_realloc	( void * p, size_t size );
+void	__real_free	( void * p );
+
+void * __wrap_malloc( size_t size ) {
+	__sync_fetch_and_add( &g_allocs, 1 );
+	return __real_malloc( size );
+}
+
+void * __wrap_calloc( size_t count, size_t size ) {
+	__sync_fetch_and_add( &g_allocs, 1 );
+	return __real_calloc( count, size );
+}
+
+void * __wrap_realloc( void * p, size_t size ) {
+	__sync_fetch_and_add( &g_allocs, 1 );
+	return __real_realloc( p, size );
+}
+
+void __wrap_free( void * p ) {
+	if ( p != NULL ) {
+		__sync_fetch_and_add( &g_frees, 1 );
+	}
+	__real_free( p );
+}
+}
+
+/**
+ * Dessine TEST_WARMUP trames puis une dernière, et retourne le nombre d'allocations de celle-ci
+ */
+static int TestFrame( window_t * w, camera_t * c ) {
+	for ( int i = 0; i < TEST_WARMUP; i++ ) {
+		WindowClearDepth( w );
+		RenderInvalidate();
+		RenderModel( w, c );
+	}
+	WindowClearDepth( w );
+	RenderInvalidate();
+	int before = g_allocs;
+	RenderModel( w, c );
+	return g_allocs - before;
+}
+
+int main() {
+	window_t * w = TestWindow( TEST_WIDTH, TEST_HEIGHT );
+	if ( w == NULL ) {
+		printf( "(EE) Unable to allocate test buffers\n" );
+		return 1;
+	}
+	camera_t c = Camera( Vec3f( 0.3f, 0.2f, 2.5f ), Vec3f( 0.0f, 0.0f, 0.0f ), Vec3f( 0.0f, 1.0f, 0.0f ), M_PI / 3.0f, (float)TEST_WIDTH / TEST_HEIGHT );
+
+	// Chargement : les éléments du fichier vont dans l'arène du modèle, une allocation par
+	// tableau et par bloc d'arène, pas une par ligne
+	int allocs = g_allocs, frees = g_frees;
+	if ( !ModelLoad( (char*)TEST_MODEL, MODEL_OPTIMIZE | MODEL_LOD ) ) {
+		printf( "(EE) Unable to load %s\n", TEST_MODEL );
+		return 1;
+	}
+	int load = g_allocs - allocs;
+	int faces = VectorGetLength( ModelFaces() );
+
+	RenderOptions()->deferred = false;
+	int forward = TestFrame( w, &c );
+	RenderOptions()->deferred = true;
+	RenderOptions()->shadows  = true;
+	int deferred = TestFrame( w, &c );
+
+	RenderQuit();
+	frees = g_frees;
+	ModelDelete();
+	int teardown = g_frees - frees;
+	TestWindowDelete( w );
+
+	printf( "(II) %s: %d faces loaded with %d allocations, %d frees on delete\n", TEST_MODEL, faces, load, teardown );
+	printf( "(II) Allocations per frame: %d forward, %d deferred with shadows\n", forward, deferred );
+	bool ok = true;
+	// Le chargement ne doit pas allouer par ligne du fichier
+	if ( load >= faces / 10 ) {
+		printf( "(EE) Model loading allocates per element\n" );
+		ok = false;
+	}
+	if ( forward > TEST_FRAME_ALLOCS || deferred > TEST_FRAME_ALLOCS ) {
+		printf( "(EE) Frames allocate more than %d blocks\n", TEST_FRAME_ALLOCS );
+		ok = false;
+	}
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,173 @@
+#include "test.h"
+#include "raster.h"
+#include "camera.h"
+
+#define TEST_WIDTH		320
+#define TEST_HEIGHT		240
+#define TEST_STACKS		24
+#define TEST_SLICES		37
+#define TEST_TRIANGLES		( TEST_STACKS * TEST_SLICES * 2 )
+#define TEST_GRID		16
+
+/**
+ * Point de la sphère unité en latitude i et longitude j. Les pôles et la couture sont
+ * des points uniques : les triangles voisins partagent exactement leurs sommets.
+ */
+static vec3f_t TestSpherePoint( int i, int j ) {
+	if ( i == 0 ) {
+		return Vec3f( 0.0f, 1.0f, 0.0f );
+	}
+	if ( i == TEST_STACKS ) {
+		return Vec3f( 0.0f, -1.0f, 0.0f );
+	}
+	float theta = M_PI * i / TEST_STACKS;
+	float phi = 2.0f * M_PI * ( j % TEST_SLICES ) / TEST_SLICES;
+	return Vec3f( sinf( theta ) * cosf( phi ), cosf( theta ), sinf( theta ) * sinf( phi ) );
+}
+
+/**
+ * Ajoute un triangle orienté dans le sens trigonométrique vu de l'extérieur
+ */
+static int TestSphereTriangle( vec3f_t * corners, int n, vec3f_t a, vec3f_t b, vec3f_t c ) {
+	vec3f_t normal = Vec3fCross( Vec3fSub( b, a ), Vec3fSub( c, a ) );
+	if ( Vec3fDot( normal, Vec3fAdd( a, Vec3fAdd( b, c ) ) ) < 0.0f ) {
+		Vec3fSwap( &b, &c );
+	}
+	corners[ n * 3 + 0 ] = a;
+	corners[ n * 3 + 1 ] = b;
+	corners[ n * 3 + 2 ] = c;
+	return n + 1;
+}
+
+/**
+ * Sphère fermée en latitudes et longitudes, retourne son nombre de triangles
+ */
+static int TestSphere( vec3f_t * corners ) {
+	int n = 0;
+	for ( int i = 0; i < TEST_STACKS; i++ ) {
+		for ( int j = 0; j < TEST_SLICES; j++ ) {
+			vec3f_t a = TestSpherePoint( i, j ), b = TestSpherePoint( i + 1, j );
+			vec3f_t c = TestSpherePoint( i + 1, j + 1 ), d = TestSpherePoint( i, j + 1 );
+			// Aux pôles, un des deux triangles du quadrilatère est dégénéré
+			if ( i < TEST_STACKS - 1 ) {
+				n = TestSphereTriangle( corners, n, a, b, c );
+			}
+			if ( i > 0 ) {
+				n = TestSphereTriangle( corners, n, a, c, d );
+			}
+		}
+	}
+	return n;
+}
+
+/**
+ * Grille de TEST_GRID x TEST_GRID cellules de 7 x 5 pixels dont les sommets sont au centre
+ * des pixels, coupées alternativement selon l'une ou l'autre diagonale : horizontales,
+ * verticales et diagonales passent toutes par des centres de pixels, où seule la règle
+ * haut-gauche départage les deux triangles. Retourne son nombre de triangles.
+ */
+static int TestGrid( vec3f_t * corners ) {
+	int n = 0;
+	for ( int i = 0; i < TEST_GRID; i++ ) {
+		for ( int j = 0; j < TEST_GRID; j++ ) {
+			float x0 = 20.5f + i * 7, y0 = 20.5f + j * 5;
+			vec3f_t a = Vec3f( x0, y0, 0.0f ), b = Vec3f( x0 + 7, y0, 0.0f );
+			vec3f_t c = Vec3f( x0 + 7, y0 + 5, 0.0f ), d = Vec3f( x0, y0 + 5, 0.0f );
+			// Aire négative à l'écran, comme les faces avant projetées
+			if ( ( i + j ) % 2 == 0 ) {
+				corners[ n * 3 + 0 ] = a; corners[ n * 3 + 1 ] = c; corners[ n * 3 + 2 ] = b; n++;
+				corners[ n * 3 + 0 ] = a; corners[ n * 3 + 1 ] = d; corners[ n * 3 + 2 ] = c; n++;
+			}else {
+				corners[ n * 3 + 0 ] = a; corners[ n * 3 + 1 ] = d; corners[ n * 3 + 2 ] = b; n++;
+				corners[ n * 3 + 0 ] = b; corners[ n * 3 + 1 ] = d; corners[ n * 3 + 2 ] = c; n++;
+			}
+		}
+	}
+	return n;
+}
+
+/**
+ * Projette les triangles à l'écran (screen vaut NULL s'ils y sont déjà) et dessine ceux
+ * de face avec le compteur d'écritures par pixel. Chaque triangle reçoit une profondeur
+ * constante, plus proche que celle du précédent : le test de profondeur ne masque aucune
+ * écriture, une arête partagée dessinée deux fois se voit. Retourne vrai si chaque pixel
+ * est écrit au plus une fois et si la silhouette, convexe, n'a aucun trou.
+ */
+static bool TestWatertight( window_t * w, const char * name, const vec3f_t * corners, int ntris, matrixf_t screen, int mode ) {
+	WindowClearDepth( w );
+	WindowResetCounter( w, true );
+	for ( int t = 0; t < ntris; t++ ) {
+		vec3f_t s[ 3 ];
+		for ( int j = 0; j < 3; j++ ) {
+			s[ j ] = corners[ t * 3 + j ];
+			if ( screen != NULL ) {
+				vec4f_t p = MatrixfTransform( screen, s[ j ] );
+				s[ j ] = Vec3f( p.x / p.w, p.y / p.w, 0.0f );
+			}
+			s[ j ].z = 1.0f - ( t + 1.0f ) / ( ntris + 1.0f );
+		}
+		float area = ( s[ 1 ].x - s[ 0 ].x ) * ( s[ 2 ].y - s[ 0 ].y ) - ( s[ 1 ].y - s[ 0 ].y ) * ( s[ 2 ].x - s[ 0 ].x );
+		if ( area < 0.0f ) {
+			RasterTriangle( w, s[ 0 ], s[ 1 ], s[ 2 ], WindowColor( 255, 255, 255 ), mode );
+		}
+	}
+
+	int covered = 0, twice = 0, holes = 0;
+	for ( int y = 0; y < w->height; y++ ) {
+		const Uint16 * count = w->counter + y * w->width;
+		int first = -1, last = -1;
+		for ( int x = 0; x < w->width; x++ ) {
+			if ( count[ x ] > 0 ) {
+				covered++;
+				if ( first < 0 ) {
+					first = x;
+				}
+				last = x;
+			}
+			twice += ( count[ x ] > 1 );
+		}
+		for ( int x = first; first >= 0 && x <= last; x++ ) {
+			holes += ( count[ x ] == 0 );
+		}
+	}
+	printf( "(II) %s, %s: %d pixels covered, %d written more than once, %d holes\n",
+		name, ( mode == RASTER_FIXED ) ? "fixed" : "float", covered, twice, holes );
+	return covered > 0 && twice == 0 && holes == 0;
+}
+
+int main() {
+	window_t * w = TestWindow( TEST_WIDTH, TEST_HEIGHT );
+	vec3f_t * sphere = (vec3f_t*)malloc( sizeof( vec3f_t ) * 3 * TEST_TRIANGLES );
+	vec3f_t * grid = (vec3f_t*)malloc( sizeof( vec3f_t ) * 3 * TEST_GRID * TEST_GRID * 2 );
+	if ( w == NULL || sphere == NULL || grid == NULL ) {
+		printf( "(EE) Unable to allocate test buffers\n" );
+		return 1;
+	}
+	int nsphere = TestSphere( sphere );
+	int ngrid = TestGrid( grid );
+
+	// Caméra décentrée : les sommets tombent à des positions quelconques dans les pixels
+	camera_t c = Camera( Vec3f( 0.31f, 0.17f, 2.7f ), Vec3f( 0.013f, -0.021f, 0.0f ), Vec3f( 0.0f, 1.0f, 0.0f ), M_PI / 4.0f, (float)TEST_WIDTH / TEST_HEIGHT );
+	matrixf_t screen = CameraScreen( &c, TEST_WIDTH, TEST_HEIGHT );
+
+	// Seul le mode en virgule fixe garantit une couverture exacte, le mode flottant est
+	// seulement rapporté
+	bool ok = true;
+	for ( int mode = RASTER_FLOAT; mode <= RASTER_FIXED; mode++ ) {
+		bool sphereok = TestWatertight( w, "sphere", sphere, nsphere, screen, mode );
+		bool gridok = TestWatertight( w, "grid", grid, ngrid, NULL, mode );
+		if ( mode == RASTER_FIXED ) {
+			ok = sphereok && gridok;
+		}
+	}
+
+	MatrixfDelete( screen, 4 );
+	free( sphere );
+	free( grid );
+	TestWindowDelete( w );
+	if ( !ok ) {
+		printf( "(EE) Fixed-point rasterization is not watertight\n" );
+		return 1;
+	}
+	return 0;
+}
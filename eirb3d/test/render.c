@@ -0,0 +1,160 @@
+#include "test.h"
+#include "raster.h"
+#include "render.h"
+#include "model.h"
+#include "camera.h"
+
+#define TEST_WIDTH		400
+#define TEST_HEIGHT		300
+#define TEST_MODEL		"./bin/data/diablo.obj"
+#define TEST_UV_ERROR		0.001f	// Ecart toléré sur u et v, quantification sur 12 bits du tampon géométrique comprise
+#define TEST_COLOR_ERROR	6	// Ecart toléré par composante entre deux rendus d'une même surface
+
+/**
+ * Grand triangle au sol fuyant vers l'horizon, dessiné dans le tampon géométrique avec
+ * (affine faux) ou sans correction de perspective. L'image des coordonnées de texture est
+ * comparée à une référence calculée en double à partir des coordonnées barycentriques
+ * écran de chaque pixel. Retourne le plus grand écart.
+ */
+static float TestPerspective( window_t * w, gbuffer_t * g, bool affine ) {
+	camera_t c = Camera( Vec3f( 0.0f, 0.3f, 0.0f ), Vec3f( 0.0f, 0.0f, -1.0f ), Vec3f( 0.0f, 1.0f, 0.0f ), M_PI / 3.0f, (float)w->width / w->height );
+	matrixf_t screen = CameraScreen( &c, w->width, w->height );
+	vec3f_t p[ 3 ] = { Vec3f( -2.0f, 0.0f, -0.5f ), Vec3f( 0.0f, 0.0f, -40.0f ), Vec3f( 2.0f, 0.0f, -0.5f ) };
+	vec2f_t t[ 3 ] = { { 0.0f, 0.0f }, { 0.5f, 1.0f }, { 1.0f, 0.0f } };
+	vec3f_t s[ 3 ];
+	float q[ 3 ];
+	for ( int i = 0; i < 3; i++ ) {
+		vec4f_t h = MatrixfTransform( screen, p[ i ] );
+		q[ i ] = 1.0f / h.w;
+		s[ i ] = Vec3f( h.x * q[ i ], h.y * q[ i ], h.z * q[ i ] );
+	}
+	MatrixfDelete( screen, 4 );
+
+	WindowClearDepth( w );
+	vec3f_t n = Vec3f( 0.0f, 1.0f, 0.0f );
+	if ( affine ) {
+		RasterTriangleGBuffer( w, g, s[ 0 ], s[ 1 ], s[ 2 ], 1.0f, 1.0f, 1.0f, n, n, n, t[ 0 ], t[ 1 ], t[ 2 ], 0 );
+	}else {
+		RasterTriangleGBuffer( w, g, s[ 0 ], s[ 1 ], s[ 2 ], q[ 0 ], q[ 1 ], q[ 2 ], n, n, n, t[ 0 ], t[ 1 ], t[ 2 ], 0 );
+	}
+
+	// La référence part des sommets arrondis au 1/16 de pixel comme ceux du remplissage :
+	// près de l'horizon, v varie d'un quart par pixel et l'arrondi seul dépasserait l'écart toléré
+	double sx[ 3 ], sy[ 3 ];
+	for ( int i = 0; i < 3; i++ ) {
+		sx[ i ] = rint( s[ i ].x * 16.0 ) / 16.0;
+		sy[ i ] = rint( s[ i ].y * 16.0 ) / 16.0;
+	}
+	double area = ( sx[ 1 ] - sx[ 0 ] ) * ( sy[ 2 ] - sy[ 0 ] ) - ( sy[ 1 ] - sy[ 0 ] ) * ( sx[ 2 ] - sx[ 0 ] );
+	float error = 0.0f;
+	int pixels = 0;
+	for ( int y = 0; y < w->height; y++ ) {
+		for ( int x = 0; x < w->width; x++ ) {
+			if ( *WindowDepths( w, x, y ) >= 1.0f ) {
+				continue;
+			}
+			double px = x + 0.5, py = y + 0.5;
+			double l1 = ( ( px - sx[ 0 ] ) * ( sy[ 2 ] - sy[ 0 ] ) - ( py - sy[ 0 ] ) * ( sx[ 2 ] - sx[ 0 ] ) ) / area;
+			double l2 = ( ( sx[ 1 ] - sx[ 0 ] ) * ( py - sy[ 0 ] ) - ( sy[ 1 ] - sy[ 0 ] ) * ( px - sx[ 0 ] ) ) / area;
+			double l0 = 1.0 - l1 - l2;
+			double d = l0 * q[ 0 ] + l1 * q[ 1 ] + l2 * q[ 2 ];
+			double u = ( l0 * q[ 0 ] * t[ 0 ].x + l1 * q[ 1 ] * t[ 1 ].x + l2 * q[ 2 ] * t[ 2 ].x ) / d;
+			double v = ( l0 * q[ 0 ] * t[ 0 ].y + l1 * q[ 1 ] * t[ 1 ].y + l2 * q[ 2 ] * t[ 2 ].y ) / d;
+			Uint32 surface = g->surface[ y * w->width + x ];
+			double pu = ( surface & 4095 ) / 4095.0, pv = ( ( surface >> 12 ) & 4095 ) / 4095.0;
+			error = MAX( error, (float)MAX( fabs( pu - u ), fabs( pv - v ) ) );
+			pixels++;
+		}
+	}
+	printf( "(II) %s: %d pixels, max uv error %.5f\n", affine ? "affine" : "perspective", pixels, error );
+	return ( pixels > 0 ) ? error : HUGE_VALF;
+}
+
+/**
+ * Distance à la caméra d'une profondeur du zbuffer
+ */
+static float TestDistance( const camera_t * c, float z ) {
+	return c->znear * c->zfar / ( c->zfar - z * ( c->zfar - c->znear ) );
+}
+
+/**
+ * Dessine le modèle avec un plan proche qui le traverse, puis avec un plan proche qui ne
+ * découpe rien. Les pixels qui montrent la même surface dans les deux images (même
+ * distance à la caméra) doivent avoir la même couleur : les sommets créés par le
+ * découpage portent les attributs interpolés du triangle d'origine.
+ * Retourne le nombre de pixels qui diffèrent.
+ */
+static int TestClipNear( window_t * a, window_t * b, const char * name ) {
+	camera_t c = Camera( Vec3f( 0.3f, 0.2f, 1.2f ), Vec3f( 0.0f, 0.0f, 0.0f ), Vec3f( 0.0f, 1.0f, 0.0f ), M_PI / 3.0f, (float)a->width / a->height );
+	camera_t clipped = c;
+	c.znear = 0.01f;
+	clipped.znear = 1.1f;
+	WindowDrawClearColor( a, 0, 0, 0 );
+	WindowClearDepth( a );
+	RenderInvalidate();
+	RenderModel( a, &c );
+	WindowDrawClearColor( b, 0, 0, 0 );
+	WindowClearDepth( b );
+	RenderInvalidate();
+	RenderModel( b, &clipped );
+
+	int shared = 0, differ = 0;
+	for ( int i = 0; i < a->width * a->height; i++ ) {
+		if ( b->zbuffer[ i ] >= 1.0f ) {
+			continue;
+		}
+		float da = TestDistance( &c, a->zbuffer[ i ] ), db = TestDistance( &clipped, b->zbuffer[ i ] );
+		if ( fabsf( da - db ) > 1e-3f * db ) {
+			continue;
+		}
+		shared++;
+		Uint32 pa = ( (Uint32*)a->framebuffer )[ i ], pb = ( (Uint32*)b->framebuffer )[ i ];
+		int d = 0;
+		for ( int shift = 0; shift < 24; shift += 8 ) {
+			d = MAX( d, abs( (int)( ( pa >> shift ) & 255 ) - (int)( ( pb >> shift ) & 255 ) ) );
+		}
+		differ += ( d > TEST_COLOR_ERROR );
+	}
+	printf( "(II) %s near clipping: %d pixels of the same surface, %d differ\n", name, shared, differ );
+	return ( shared > 0 ) ? differ : -1;
+}
+
+int main() {
+	window_t * w = TestWindow( TEST_WIDTH, TEST_HEIGHT );
+	window_t * ref = TestWindow( TEST_WIDTH, TEST_HEIGHT );
+	gbuffer_t * g = GBuffer( TEST_WIDTH, TEST_HEIGHT );
+	if ( w == NULL || ref == NULL || g == NULL ) {
+		printf( "(EE) Unable to allocate test buffers\n" );
+		return 1;
+	}
+	bool ok = true;
+
+	// L'écart de l'interpolation affine montre que la référence distingue les deux
+	float perspective = TestPerspective( w, g, false );
+	float affine = TestPerspective( w, g, true );
+	if ( perspective > TEST_UV_ERROR || affine <= 10.0f * TEST_UV_ERROR ) {
+		printf( "(EE) Texture coordinates are not perspective-correct\n" );
+		ok = false;
+	}
+
+	if ( !ModelLoad( (char*)TEST_MODEL, MODEL_OPTIMIZE ) ) {
+		printf( "(EE) Unable to load %s\n", TEST_MODEL );
+		return 1;
+	}
+	const char * names[ 3 ] = { "gouraud", "phong", "deferred" };
+	for ( int mode = 0; mode < 3; mode++ ) {
+		RenderOptions()->shading  = ( mode == 0 ) ? RENDER_GOURAUD : RENDER_PHONG;
+		RenderOptions()->deferred = ( mode == 2 );
+		if ( TestClipNear( ref, w, names[ mode ] ) != 0 ) {
+			printf( "(EE) Near-clipped triangles do not interpolate their attributes\n" );
+			ok = false;
+		}
+	}
+
+	ModelDelete();
+	RenderQuit();
+	GBufferDelete( g );
+	TestWindowDelete( w );
+	TestWindowDelete( ref );
+	return ok ? 0 : 1;
+}
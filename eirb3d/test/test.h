@@ -0,0 +1,47 @@
+#ifndef __TEST_H__
+#define __TEST_H__
+
+#include "window.h"
+
+/**
+ * Fentre de test sans fentre SDL : seuls le framebuffer et le zbuffer sont allous,
+ * les remplissages n'utilisent rien d'autre
+ */
+inline window_t * TestWindow( int width, int height ) {
+	window_t * w = (window_t*)calloc( 1, sizeof( window_t ) );
+	if ( w == NULL ) {
+		return NULL;
+	}
+	w->width         = width;
+	w->height        = height;
+	w->displaywidth  = width;
+	w->displayheight = height;
+	w->source.w      = width;
+	w->source.h      = height;
+	w->bpp           = 4;
+	w->pitch         = width * 4;
+	w->samples       = 1;
+	w->framebuffer   = (unsigned char*)calloc( width * height, 4 );
+	w->zbuffer       = (float*)malloc( sizeof( float ) * width * height );
+	if ( w->framebuffer == NULL || w->zbuffer == NULL ) {
+		free( w->framebuffer );
+		free( w->zbuffer );
+		free( w );
+		return NULL;
+	}
+	WindowClearDepth( w );
+	return w;
+}
+
+/**
+ * Supprime une fentre construite par TestWindow
+ */
+inline void TestWindowDelete( window_t * w ) {
+	WindowResetCounter( w, false );
+	WindowSamples( w, 1 );
+	free( w->framebuffer );
+	free( w->zbuffer );
+	free( w );
+}
+
+#endif //__TEST_H__